@@ -27,10 +27,112 @@
 
 #include "benchmark_utils.hpp"
 #include "op_dispatcher.hpp"
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <cxxopts.hpp>
 
 
+/** Return the name of the algorithm in algos used for Op. */
+template <Al::AlOperation Op, typename Backend>
+std::string get_algorithm_name(AlgorithmOptions<Backend> algos) {
+  if constexpr (Al::OpSupportsAlgos<Op>::value) {
+    AlgoAccessor<Op, Backend> getter;
+    return Al::algorithm_name(getter.get(algos));
+  } else {
+    return "automatic";
+  }
+}
+
+/**
+ * Append rules selecting the fastest algorithm at each size to the
+ * tuning table in filename (see Al::internal::mpi::load_tuning_table).
+ *
+ * The fastest algorithm has the lowest median time over all ranks. The
+ * rules cover only this communicator's size and ranks per node, so
+ * running at several scales builds up a table for each of them.
+ */
+template <Al::AlOperation Op, typename Backend, typename T>
+void write_tuning_rules(const std::string& filename,
+                        std::vector<OpProfile<Op, Backend, T>>& profiles,
+                        const std::vector<AlgorithmOptions<Backend>>& algorithms,
+                        typename Backend::comm_type& comm) {
+  if constexpr (!std::is_same_v<Backend, Al::MPIBackend>
+                || !Al::OpSupportsAlgos<Op>::value) {
+    std::cerr << "Tuning tables are only supported for MPI collectives"
+              << std::endl;
+    std::abort();
+  } else {
+    std::vector<std::unordered_map<size_t, SummaryStats>> summaries;
+    for (auto& profile : profiles) {
+      summaries.push_back(profile.get_summary_stats());
+    }
+    int ranks_per_node = comm.local_size();
+    MPI_Allreduce(MPI_IN_PLACE, &ranks_per_node, 1, MPI_INT, MPI_MAX,
+                  comm.get_comm());
+    if (comm.rank() != 0) {
+      return;
+    }
+    // Sizes that were run, in order.
+    std::vector<size_t> sizes;
+    for (const auto& p : summaries[0]) {
+      sizes.push_back(p.first);
+    }
+    std::sort(sizes.begin(), sizes.end());
+    // Pick the winner at each size. Automatic is only a candidate if
+    // it is the only one, since it may itself be chosen from a table.
+    std::vector<std::string> winners;
+    for (const auto& size : sizes) {
+      std::string winner;
+      double best = std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < algorithms.size(); ++i) {
+        const std::string name = get_algorithm_name<Op>(algorithms[i]);
+        if (name == "automatic" && algorithms.size() > 1) {
+          continue;
+        }
+        const double median = summaries[i][size].median;
+        if (winner.empty() || median < best) {
+          winner = name;
+          best = median;
+        }
+      }
+      winners.push_back(winner);
+    }
+    // Selection is by total bytes, which for vector operations is the
+    // size from every rank.
+    auto get_bytes = [&](size_t size) {
+      return size * sizeof(T) * (Al::IsVectorOp<Op>::value ? comm.size() : 1);
+    };
+    std::ofstream f(filename, std::ios::app);
+    if (f.fail()) {
+      std::cerr << "Error opening " << filename << std::endl;
+      std::abort();
+    }
+    f << "# " << Al::AlOperationName<Op> << " " << typeid(T).name()
+      << " on " << comm.size() << " ranks, " << ranks_per_node
+      << " per node\n";
+    // Each rule runs from its first size up to the next rule, and the
+    // first and last are open-ended.
+    for (size_t i = 0; i < sizes.size(); ) {
+      size_t j = i + 1;
+      while (j < sizes.size() && winners[j] == winners[i]) {
+        ++j;
+      }
+      f << Al::AlOperationName<Op> << " " << sizeof(T) << " "
+        << comm.size() << " " << ranks_per_node << " "
+        << (i == 0 ? 0 : get_bytes(sizes[i])) << " ";
+      if (j < sizes.size()) {
+        f << get_bytes(sizes[j]) - 1;
+      } else {
+        f << "*";
+      }
+      f << " " << winners[i] << "\n";
+      i = j;
+    }
+  }
+}
+
+
 template <Al::AlOperation Op, typename Backend, typename T,
           std::enable_if_t<Al::IsTypeSupported<Backend, T>::value, bool> = true>
 void run_benchmark(cxxopts::ParseResult& parsed_opts) {
@@ -52,15 +154,17 @@ void run_benchmark(cxxopts::ParseResult& parsed_opts) {
       parsed_opts["reduction-op"].as<std::string>());
   }
   op_options.root = parsed_opts["root"].as<int>();
-  // TODO: Support multiple algorithms -- needs support in OpProfile.
+  std::vector<AlgorithmOptions<Backend>> algorithms = {op_options.algos};
   if (Al::OpSupportsAlgos<Op>::value) {
-    auto algorithms = get_algorithms<Backend>(
-      op, parsed_opts["algorithm"].as<std::string>());
-    if (algorithms.size() != 1) {
-      std::cerr << "Can only benchmark one algorithm at a time." << std::endl;
+    std::string algorithm = parsed_opts["algorithm"].as<std::string>();
+    if (algorithm.empty() && parsed_opts.count("tune-file")) {
+      algorithm = "all";
+    }
+    algorithms = get_algorithms<Backend>(op, algorithm);
+    if (algorithms.empty()) {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
       std::abort();
     }
-    op_options.algos = algorithms[0];
   }
 
   int send_rank = parsed_opts["send-rank"].as<int>();
@@ -74,7 +178,6 @@ void run_benchmark(cxxopts::ParseResult& parsed_opts) {
 
   StreamManager<Backend>::init(1UL);
   CommWrapper<Backend> comm_wrapper = get_world_wrapper<Backend>(MPI_COMM_WORLD, parsed_opts);  //comm_wrapper(MPI_COMM_WORLD);
-  OpProfile<Op, Backend, T> profile(comm_wrapper.comm(), op_options);
   Timer<Backend> timer;
 
   bool participates_in_pt2pt = true;
@@ -137,6 +240,16 @@ void run_benchmark(cxxopts::ParseResult& parsed_opts) {
     }
   }
 
+  // Each algorithm gets its own profile, with options naming it.
+  std::vector<OpOptions<Backend>> profile_options(algorithms.size(),
+                                                  op_options);
+  std::vector<OpProfile<Op, Backend, T>> profiles;
+  profiles.reserve(algorithms.size());
+  for (size_t i = 0; i < algorithms.size(); ++i) {
+    profile_options[i].algos = algorithms[i];
+    profiles.emplace_back(comm_wrapper.comm(), profile_options[i]);
+  }
+
   size_t num_iters = parsed_opts["num-iters"].as<size_t>();
   size_t num_warmup = parsed_opts["num-warmup"].as<size_t>();
 
@@ -170,48 +283,66 @@ void run_benchmark(cxxopts::ParseResult& parsed_opts) {
     typename VectorType<T, Backend>::type output =
       VectorType<T, Backend>::gen_data(out_size);
 
-    if (!Al::IsPt2PtOp<Op>::value || participates_in_pt2pt) {
-      for (size_t trial = 0; trial < num_warmup + num_iters; ++trial) {
-        MPI_Barrier(MPI_COMM_WORLD);
-        timer.start_timer(comm_wrapper.comm());
-        op_runner.run(input, output, comm_wrapper.comm());
-        if (op_options.nonblocking) {
-          Al::Wait<Backend>(op_options.req);
+    for (size_t algo = 0; algo < algorithms.size(); ++algo) {
+      op_options.algos = algorithms[algo];
+      if (!Al::IsPt2PtOp<Op>::value || participates_in_pt2pt) {
+        for (size_t trial = 0; trial < num_warmup + num_iters; ++trial) {
+          MPI_Barrier(MPI_COMM_WORLD);
+          timer.start_timer(comm_wrapper.comm());
+          op_runner.run(input, output, comm_wrapper.comm());
+          if (op_options.nonblocking) {
+            Al::Wait<Backend>(op_options.req);
+          }
+          double t = timer.end_timer(comm_wrapper.comm());
+          if (trial >= num_warmup) {
+            profiles[algo].add_result(size, t);
+          }
         }
-        double t = timer.end_timer(comm_wrapper.comm());
-        if (trial >= num_warmup) {
-          profile.add_result(size, t);
+      } else if (Al::IsPt2PtOp<Op>::value && !participates_in_pt2pt) {
+        // These ranks still need to participate in the barriers.
+        for (size_t trial = 0; trial < num_warmup + num_iters; ++trial) {
+          MPI_Barrier(MPI_COMM_WORLD);
         }
       }
-    } else if (Al::IsPt2PtOp<Op>::value && !participates_in_pt2pt) {
-      // These ranks still need to participate in the barriers.
-      for (size_t trial = 0; trial < num_warmup + num_iters; ++trial) {
-        MPI_Barrier(MPI_COMM_WORLD);
-      }
     }
 
     MPI_Barrier(MPI_COMM_WORLD);
   }
 
   if (parsed_opts.count("summarize")) {
-    auto summaries = profile.get_summary_stats(
-      parsed_opts["summarize"].as<int>());
-    if (comm_wrapper.rank() == 0) {
-      // Print in sorted order by size for better readability.
-      std::map<typename decltype(summaries)::key_type,
-               typename decltype(summaries)::mapped_type>
-        sorted_summaries(summaries.begin(), summaries.end());
-      std::cout << "Size\t\tMean\t\tMedian\t\tStdev\t\tMin\t\tMax" << std::endl;
-      for (const auto& p : sorted_summaries) {
-        std::cout << p.first << "\t\t" << p.second << std::endl;
+    for (size_t algo = 0; algo < algorithms.size(); ++algo) {
+      auto summaries = profiles[algo].get_summary_stats(
+        parsed_opts["summarize"].as<int>());
+      if (comm_wrapper.rank() == 0) {
+        // Print in sorted order by size for better readability.
+        std::map<typename decltype(summaries)::key_type,
+                 typename decltype(summaries)::mapped_type>
+          sorted_summaries(summaries.begin(), summaries.end());
+        if (algorithms.size() > 1) {
+          std::cout << "Algorithm "
+                    << get_algorithm_name<Op>(algorithms[algo]) << std::endl;
+        }
+        std::cout << "Size\t\tMean\t\tMedian\t\tStdev\t\tMin\t\tMax" << std::endl;
+        for (const auto& p : sorted_summaries) {
+          std::cout << p.first << "\t\t" << p.second << std::endl;
+        }
       }
     }
   }
   if (parsed_opts.count("save-to-file")) {
-    profile.save_results(parsed_opts["save-to-file"].as<std::string>());
+    for (size_t algo = 0; algo < algorithms.size(); ++algo) {
+      profiles[algo].save_results(
+        parsed_opts["save-to-file"].as<std::string>(), algo > 0);
+    }
   }
   if (!parsed_opts.count("no-print-table")) {
-    profile.print_results();
+    for (size_t algo = 0; algo < algorithms.size(); ++algo) {
+      profiles[algo].print_results(algo == 0);
+    }
+  }
+  if (parsed_opts.count("tune-file")) {
+    write_tuning_rules(parsed_opts["tune-file"].as<std::string>(),
+                       profiles, algorithms, comm_wrapper.comm());
   }
 
   StreamManager<Backend>::finalize();
@@ -259,7 +390,7 @@ int main(int argc, char** argv) {
     ("inplace", "Use an inplace operator")
     ("nonblocking", "Use a non-blocking operator")
     ("reduction-op", "Reduction operator to use (if needed)", cxxopts::value<std::string>())
-    ("algorithm", "Operator algorithm to use", cxxopts::value<std::string>()->default_value(""))
+    ("algorithm", "Operator algorithm to use, or \"all\"", cxxopts::value<std::string>()->default_value(""))
     ("root", "Root of operator (if needed)", cxxopts::value<int>()->default_value("0"))
     ("send-rank", "Set single rank to perform sends", cxxopts::value<int>()->default_value("-1"))
     ("recv-rank", "Set single rank to perform receives", cxxopts::value<int>()->default_value("-1"))
@@ -274,6 +405,7 @@ int main(int argc, char** argv) {
     ("summarize", "Print stats summary over all ranks or a specific rank", cxxopts::value<int>()->default_value("-1"))
     ("no-print-table", "Do not print results table")
     ("permute", "Permute ranks per this list", cxxopts::value<std::vector<int>>())
+    ("tune-file", "Append rules choosing the fastest algorithm per size to this tuning table (default all algorithms)", cxxopts::value<std::string>())
     ("help", "Print help");
   auto parsed_opts = options.parse(argc, argv);
 
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "benchmark_utils.hpp"
+#include <chrono>
+#include <thread>
+#include <cxxopts.hpp>
+
+
+/**
+ * Benchmark pausing and resuming the progress engine.
+ *
+ * This reports the latency of ResumeProgress and the latency of the
+ * first small operation after resuming, compared with the same
+ * operation when the progress engine was never paused.
+ */
+void run_benchmark(cxxopts::ParseResult& parsed_opts) {
+  size_t num_iters = parsed_opts["num-iters"].as<size_t>();
+  size_t num_warmup = parsed_opts["num-warmup"].as<size_t>();
+  size_t pause_us = parsed_opts["pause-time"].as<size_t>();
+  size_t size = parsed_opts["size"].as<size_t>();
+
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  std::vector<float> buf(size, 1.0f);
+  Al::MPIBackend::req_type req;
+  auto do_op = [&]() {
+    double start = Al::get_time();
+    Al::NonblockingAllreduce<Al::MPIBackend>(
+      buf.data(), buf.size(), Al::ReductionOperator::sum, comm, req);
+    Al::Wait<Al::MPIBackend>(req);
+    return Al::get_time() - start;
+  };
+
+  std::vector<double> resume_times, paused_op_times, unpaused_op_times;
+  for (size_t trial = 0; trial < num_warmup + num_iters; ++trial) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    double unpaused_t = do_op();
+    MPI_Barrier(MPI_COMM_WORLD);
+    Al::PauseProgress();
+    // Stand-in for a compute phase.
+    std::this_thread::sleep_for(std::chrono::microseconds(pause_us));
+    double start = Al::get_time();
+    Al::ResumeProgress();
+    double resume_t = Al::get_time() - start;
+    double paused_t = do_op();
+    if (trial >= num_warmup) {
+      resume_times.push_back(resume_t);
+      paused_op_times.push_back(paused_t);
+      unpaused_op_times.push_back(unpaused_t);
+    }
+  }
+
+  SummaryStats resume_stats(resume_times);
+  SummaryStats paused_stats(paused_op_times);
+  SummaryStats unpaused_stats(unpaused_op_times);
+  if (comm.rank() == 0) {
+    std::cout << "Rank 0 results (mean median stdev min max):\n"
+              << "Resume\t" << resume_stats << "\n"
+              << "Op after resume\t" << paused_stats << "\n"
+              << "Op without pause\t" << unpaused_stats << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  test_init_aluminum(argc, argv);
+
+  cxxopts::Options options(
+    "benchmark_pause",
+    "Benchmark Aluminum progress engine pause/resume latency");
+  options.add_options()
+    ("size", "Size of allreduce to run after resuming", cxxopts::value<size_t>()->default_value("1"))
+    ("pause-time", "Microseconds to stay paused", cxxopts::value<size_t>()->default_value("10000"))
+    ("num-iters", "Number of benchmark iterations", cxxopts::value<size_t>()->default_value("100"))
+    ("num-warmup", "Number of warmup iterations", cxxopts::value<size_t>()->default_value("10"))
+    ("help", "Print help");
+  auto parsed_opts = options.parse(argc, argv);
+
+  if (parsed_opts.count("help")) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0) {
+      std::cout << options.help() << std::endl;
+    }
+    test_fini_aluminum();
+    std::exit(0);
+  }
+
+  run_benchmark(parsed_opts);
+
+  test_fini_aluminum();
+  return 0;
+}
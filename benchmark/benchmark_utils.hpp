@@ -132,29 +132,34 @@ public:
     }
   }
 
-  void print_results() {
-    write_results(std::cout);
+  void print_results(bool header = true) {
+    write_results(std::cout, header);
   }
 
-  void save_results(std::string filename) {
-    std::ofstream f(filename);
+  /**
+   * Save results to filename; if append, add them (without a header) to
+   * the end of the existing file.
+   */
+  void save_results(std::string filename, bool append = false) {
+    std::ofstream f(filename, append ? std::ios::app : std::ios::out);
     if (f.fail()) {
       std::cerr << "Error opening " << filename << std::endl;
       std::abort();
     }
-    write_results(f);
+    write_results(f, !append);
   }
 
   template <Al::AlOperation Op2 = Op,
             std::enable_if_t<Al::IsCollectiveOp<Op2>::value
                              && Al::IsOpSupported<Op2, Backend>::value, bool> = true>
-  void write_results(std::ostream& os) {
+  void write_results(std::ostream& os, bool header = true) {
     // Write times.
     auto gathered_times = gather_results_to_root();
     if (comm.rank() == 0) {
-      // Header.
-      os << "Backend Type Operation Algo NonBlocking InPlace"
-         << " Root CommSize Size CommRank Time\n";
+      if (header) {
+        os << "Backend Type Operation Algo NonBlocking InPlace"
+           << " Root CommSize Size CommRank Time\n";
+      }
       AlgoAccessor<Op, Backend> getter;
       const std::string common_start =
         std::string(Al::AlBackendName<Backend>) + " "
@@ -186,12 +191,13 @@ public:
   template <Al::AlOperation Op2 = Op,
             std::enable_if_t<Al::IsPt2PtOp<Op2>::value
                              && Al::IsOpSupported<Op2, Backend>::value, bool> = true>
-  void write_results(std::ostream& os) {
+  void write_results(std::ostream& os, bool header = true) {
     // Write times.
     auto gathered_times = gather_results_to_root();
     if (comm.rank() == 0) {
-      // Header.
-      os << "Backend Type Operation CommSize Size CommRank Time\n";
+      if (header) {
+        os << "Backend Type Operation CommSize Size CommRank Time\n";
+      }
       const std::string common_start =
         std::string(Al::AlBackendName<Backend>) + " "
         + std::string(typeid(T).name()) + " "
@@ -218,7 +224,7 @@ public:
   template <Al::AlOperation Op2 = Op,
             std::enable_if_t<(!Al::IsCollectiveOp<Op2>::value && !Al::IsPt2PtOp<Op2>::value)
                              || !Al::IsOpSupported<Op2, Backend>::value, bool> = true>
-  void write_results(std::ostream& os) {
+  void write_results(std::ostream& os, bool = true) {
     os << "Unsupported operation" << std::endl;
   }
 
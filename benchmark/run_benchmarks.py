@@ -46,6 +46,9 @@ parser.add_argument('--min-size', type=int, default=None,
                     help='Minimum message size to benchmark')
 parser.add_argument('--max-size', type=int, default=None,
                     help='Maximum message size to benchmark')
+parser.add_argument('--tune-file', type=str, default=None,
+                    help='Benchmark all MPI algorithms and append the fastest'
+                    ' per size to this tuning table')
 
 
 # TODO: This is copied from run_tests.py, I'd prefer to have a single source.
@@ -67,22 +70,88 @@ _default_algo_map = {
 OpDesc = namedtuple('OpDesc',
                     ['op', 'inplace', 'root', 'min_procs', 'algorithms'],
                     defaults=['both', False, 1, _default_algo_map])
-coll_ops = [OpDesc('allgather'),
+coll_ops = [OpDesc('allgather',
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_ring', 'mpi_recursive_doubling',
+                                       'mpi_bruck'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
             OpDesc('allreduce',
-                   algorithms={'mpi': ['automatic'],  # Excluding biring.
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_recursive_doubling',
+                                       'mpi_rabenseifner',
+                                       'mpi_ring', 'mpi_biring',
+                                       'mpi_hierarchical', 'mpi_shm'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('alltoall',
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_bruck', 'mpi_pairwise'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('barrier', inplace=False,
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_hierarchical'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('bcast', inplace=True, root=True,
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_shm', 'mpi_pipelined_chain',
+                                       'mpi_binary_tree',
+                                       'mpi_scatter_allgather'],
                                'nccl': ['automatic'],
                                'ht': ['automatic']}),
-            OpDesc('alltoall'),
-            OpDesc('bcast', inplace=True, root=True),
-            OpDesc('gather', root=True),
-            OpDesc('reduce', root=True),
-            OpDesc('reduce_scatter'),
-            OpDesc('scatter', root=True)]
-vector_coll_ops = [OpDesc('allgatherv'),
-                   OpDesc('alltoallv'),
-                   OpDesc('gatherv', root=True),
-                   OpDesc('reduce_scatterv'),
-                   OpDesc('scatterv', root=True)]
+            OpDesc('gather', root=True,
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_binomial', 'mpi_knomial',
+                                       'mpi_flow_controlled'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('reduce', root=True,
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_binomial', 'mpi_knomial'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('reduce_scatter',
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_ring', 'mpi_recursive_halving'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']}),
+            OpDesc('scatter', root=True,
+                   algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                       'mpi_binomial', 'mpi_knomial',
+                                       'mpi_flow_controlled'],
+                               'nccl': ['automatic'],
+                               'ht': ['automatic']})]
+vector_coll_ops = [OpDesc('allgatherv',
+                          algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                              'mpi_ring',
+                                              'mpi_recursive_doubling',
+                                              'mpi_bruck'],
+                                      'nccl': ['automatic'],
+                                      'ht': ['automatic']}),
+                   OpDesc('alltoallv',
+                          algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                              'mpi_sparse', 'mpi_pairwise'],
+                                      'nccl': ['automatic'],
+                                      'ht': ['automatic']}),
+                   OpDesc('gatherv', root=True,
+                          algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                              'mpi_binomial', 'mpi_knomial',
+                                              'mpi_flow_controlled'],
+                                      'nccl': ['automatic'],
+                                      'ht': ['automatic']}),
+                   OpDesc('reduce_scatterv',
+                          algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                              'mpi_ring', 'mpi_recursive_halving'],
+                                      'nccl': ['automatic'],
+                                      'ht': ['automatic']}),
+                   OpDesc('scatterv', root=True,
+                          algorithms={'mpi': ['automatic', 'mpi_passthrough',
+                                              'mpi_binomial', 'mpi_knomial',
+                                              'mpi_flow_controlled'],
+                                      'nccl': ['automatic'],
+                                      'ht': ['automatic']})]
 pt2pt_ops = [OpDesc('send', inplace=False, min_procs=2),
              OpDesc('recv', inplace=False, min_procs=2),
              OpDesc('sendrecv', inplace=False, min_procs=2)]
@@ -176,6 +245,8 @@ def run_benchmark(args, num_procs, backend, operator, datatype, algorithm,
                 '--algorithm', algorithm,
                 '--save-to-file', out_path,
                 '--no-print-table']
+    if args.tune_file:
+        test_cmd += ['--tune-file', args.tune_file]
     test_desc = f'procs:{num_procs} {backend} {operator} {datatype} {algorithm}'
     if inplace:
         test_cmd += ['--inplace']
@@ -222,6 +293,13 @@ def run_all_benchmarks(args):
                     continue
                 if num_procs < opdesc.min_procs:
                     continue
+                # Only MPI operations with a choice of algorithms are tuned.
+                # Alltoallv sizes differ between ranks, so ranks could
+                # pick algorithms that cannot be mixed; it is not tuned.
+                if args.tune_file and (backend != 'mpi'
+                                       or len(opdesc.algorithms[backend]) < 2
+                                       or opdesc.op == 'alltoallv'):
+                    continue
                 for datatype in cases['datatypes']:
                     if args.datatypes and datatype not in args.datatypes:
                         continue
@@ -232,6 +310,10 @@ def run_all_benchmarks(args):
                         blocking_cases.append(True)
                     if args.blocking is None and args.nonblocking is None:
                         blocking_cases = [False, True]
+                    if args.tune_file:
+                        # Tuning tables do not distinguish these cases,
+                        # so only tune the common one.
+                        blocking_cases = [False]
                     for nonblocking in blocking_cases:
                         # If operator only supports one mode, always use it.
                         if opdesc.inplace == 'both':
@@ -244,9 +326,14 @@ def run_all_benchmarks(args):
                                 inplace_cases = [True, False]
                         else:
                             inplace_cases = [opdesc.inplace]
+                        algorithms = opdesc.algorithms[backend]
+                        if args.tune_file:
+                            if opdesc.inplace == 'both':
+                                inplace_cases = [False]
+                            algorithms = ['all']
                         for inplace in inplace_cases:
                             root = 0 if opdesc.root else None
-                            for algorithm in opdesc.algorithms[backend]:
+                            for algorithm in algorithms:
                                 run_benchmark(
                                     args, num_procs, backend, opdesc.op,
                                     datatype, algorithm,
@@ -36,6 +36,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string>
 #include <vector>
 
 #include <mpi.h>
@@ -43,6 +44,7 @@
 #include <Al_config.hpp>
 #include "aluminum/base.hpp"
 #include "aluminum/debug_helpers.hpp"
+#include "aluminum/stats.hpp"
 #include "aluminum/trace.hpp"
 
 #if defined AL_HAS_CALIPER
@@ -102,6 +104,96 @@ void Finalize();
  * It is always safe to call this.
  */
 bool Initialized();
+/**
+ * Pause the Aluminum progress engine.
+ *
+ * Use this around compute-heavy phases with no outstanding communication.
+ * Once all in-progress operations complete, the progress thread sleeps
+ * and gives up the core it is bound to, so compute (e.g., OpenMP or TBB)
+ * threads can use it.
+ *
+ * Operations may still be issued while paused; the progress engine will
+ * wake to complete them and then sleep again, so this is always safe,
+ * but it adds wakeup latency to those operations.
+ *
+ * Setting the environment variable AL_PE_AUTO_PARK to a non-zero value
+ * makes the progress engine do this automatically after being idle for
+ * AL_PE_AUTO_PARK_IDLE_USEC microseconds.
+ */
+void PauseProgress();
+/**
+ * Resume the Aluminum progress engine after PauseProgress().
+ *
+ * This returns once the progress thread is running and bound to its
+ * core again.
+ */
+void ResumeProgress();
+/**
+ * Return latency statistics for operations run by the progress engine.
+ *
+ * There is one entry for each kind of operation (e.g., "MPIAllreduce")
+ * and size class that has run since Initialize() (or ResetOpStats()).
+ * Statistics are always collected; this may be called at any time.
+ *
+ * Setting the environment variable AL_OP_STATS to a non-zero value
+ * writes a summary of these to hostname.pid.opstats.txt at Finalize().
+ */
+std::vector<OpStats> GetOpStats();
+/** Reset all statistics returned by GetOpStats(). */
+void ResetOpStats();
+/** Write a human-readable summary of GetOpStats() to os. */
+std::ostream& WriteOpStats(std::ostream& os);
+/**
+ * Return statistics on the progress engine itself.
+ *
+ * These show how busy the progress thread is (e.g., to decide whether
+ * polling overhead matters). They are sampled, so the cost is small.
+ */
+ProgressEngineStats GetProgressEngineStats();
+/** Reset all statistics returned by GetProgressEngineStats(). */
+void ResetProgressEngineStats();
+/**
+ * Return samples of MPI_T performance variables.
+ *
+ * Setting the environment variable AL_MPI_T_PVARS to a comma-separated
+ * list of variable names (which depend on the MPI library) samples them
+ * periodically from the progress engine (see
+ * AL_MPI_T_SAMPLE_INTERVAL_USEC). These are also included in the output
+ * of AL_OP_STATS.
+ */
+std::vector<MPIPvarStats> GetMPIPvarStats();
+/**
+ * Write the communication matrix to filename on rank 0.
+ *
+ * This has the bytes and number of messages each rank has sent to each
+ * other rank over MPI-backend point-to-point operations, MultiSendRecv,
+ * and collectives Aluminum implements itself (not those passed through
+ * to MPI), on any communicator. It is only collected when the
+ * environment variable AL_COMM_MATRIX is set to a non-zero value, in
+ * which case it is also written to al_comm_matrix.txt at Finalize().
+ *
+ * This is collective over Aluminum's world communicator.
+ */
+void WriteCommMatrix(const std::string& filename);
+/**
+ * Return the arrival skew of each kind of collective.
+ *
+ * This is only collected when the environment variable AL_SKEW is set to
+ * a non-zero value. Each rank then records when it calls collectives,
+ * with clocks aligned at Initialize(), and every AL_SKEW_WINDOW
+ * collectives the times are gathered to rank 0 of the communicator, so
+ * only those ranks have statistics and the most recent collectives are
+ * not yet included. A summary of these and GetStragglerStats() is
+ * written to hostname.pid.skew.txt at Finalize().
+ */
+std::vector<SkewStats> GetSkewStats();
+/**
+ * Return how often each rank arrived last at collectives (see
+ * GetSkewStats()), with the most frequent stragglers first.
+ */
+std::vector<StragglerStats> GetStragglerStats();
+/** Write a human-readable summary of GetSkewStats() and GetStragglerStats() to os. */
+std::ostream& WriteSkewStats(std::ostream& os);
 
 /**
  * Perform an allreduce.
@@ -740,6 +832,54 @@ void NonblockingAllgatherv(T* buffer, std::vector<size_t> counts,
   Backend::template NonblockingAllgatherv<T>(buffer, counts, displs, comm, req, algo);
 }
 
+/**
+ * Perform an Allgatherv() where only the local count is known.
+ *
+ * Counts are exchanged internally and the receive buffer is allocated
+ * once they are known. See DynamicRecvBuffer.
+ *
+ * @param[in] sendbuf Buffer containing the local slice.
+ * @param[in] count Length of \p sendbuf in elements of type `T`.
+ * @param[in,out] recv Allocator for, and on return the location of,
+ * the assembled slices.
+ * @param[in] comm Communicator for this allgather.
+ */
+template <typename Backend, typename T>
+void AllgathervDynamic(const T* sendbuf, size_t count,
+                       DynamicRecvBuffer<T>& recv,
+                       typename Backend::comm_type& comm) {
+  debug::check_buffer(sendbuf, count);
+  AL_CALI_MARK_SCOPE("aluminum:AllgathervDynamic");
+  internal::trace::record_op<Backend, T>("allgatherv-dynamic", comm,
+                                         sendbuf, count);
+  Backend::template AllgathervDynamic<T>(sendbuf, count, recv, comm);
+}
+
+/**
+ * Perform a \verbatim embed:rst:inline :ref:`non-blocking <comm-nonblocking>` \endverbatim AllgathervDynamic().
+ *
+ * The fields of \p recv are set once the operation completes.
+ *
+ * @param[in] sendbuf Buffer containing the local slice.
+ * @param[in] count Length of \p sendbuf in elements of type `T`.
+ * @param[in,out] recv Allocator for, and on completion the location
+ * of, the assembled slices.
+ * @param[in] comm Communicator for this allgather.
+ * @param[out] req Request object for the asynchronous operation.
+ */
+template <typename Backend, typename T>
+void NonblockingAllgathervDynamic(const T* sendbuf, size_t count,
+                                  DynamicRecvBuffer<T>& recv,
+                                  typename Backend::comm_type& comm,
+                                  typename Backend::req_type& req) {
+  debug::check_buffer(sendbuf, count);
+  AL_CALI_MARK_SCOPE("aluminum:NonblockingAllgathervDynamic");
+  internal::trace::record_op<Backend, T>("nonblocking-allgatherv-dynamic",
+                                         comm, sendbuf, count);
+  Backend::template NonblockingAllgathervDynamic<T>(sendbuf, count, recv,
+                                                    comm, req);
+}
+
 /**
  * Perform a barrier synchronization.
  *
@@ -1063,6 +1203,67 @@ void NonblockingAlltoallv(T* buffer, std::vector<size_t> counts,
                                             req, algo);
 }
 
+/**
+ * Perform an Alltoallv() where only the send counts are known.
+ *
+ * Counts are exchanged internally and the receive buffer is allocated
+ * once they are known, with the data from each rank packed in rank
+ * order. See DynamicRecvBuffer.
+ *
+ * @param[in] sendbuf Buffer containing the local vector slices.
+ * @param[in] send_counts Length of each slice in \p sendbuf in elements of type `T`.
+ * @param[in] send_displs Offsets, in elements of type `T`, into \p sendbuf
+ * where the data for the corresponding rank begins.
+ * @param[in,out] recv Allocator for, and on return the location of,
+ * the assembled slices.
+ * @param[in] comm Communicator for this all-to-all operation.
+ */
+template <typename Backend, typename T>
+void AlltoallvDynamic(const T* sendbuf, std::vector<size_t> send_counts,
+                      std::vector<size_t> send_displs,
+                      DynamicRecvBuffer<T>& recv,
+                      typename Backend::comm_type& comm) {
+  debug::check_vector_is_comm_sized<Backend>(send_counts, comm);
+  debug::check_vector_is_comm_sized<Backend>(send_displs, comm);
+  debug::check_buffer(sendbuf, debug::sum(send_counts));
+  AL_CALI_MARK_SCOPE("aluminum:AlltoallvDynamic");
+  internal::trace::record_op<Backend, T>(
+    "alltoallv-dynamic", comm, sendbuf, send_counts, send_displs);
+  Backend::template AlltoallvDynamic<T>(sendbuf, send_counts, send_displs,
+                                        recv, comm);
+}
+
+/**
+ * Perform a \verbatim embed:rst:inline :ref:`non-blocking <comm-nonblocking>` \endverbatim AlltoallvDynamic().
+ *
+ * The fields of \p recv are set once the operation completes.
+ *
+ * @param[in] sendbuf Buffer containing the local vector slices.
+ * @param[in] send_counts Length of each slice in \p sendbuf in elements of type `T`.
+ * @param[in] send_displs Offsets, in elements of type `T`, into \p sendbuf
+ * where the data for the corresponding rank begins.
+ * @param[in,out] recv Allocator for, and on completion the location
+ * of, the assembled slices.
+ * @param[in] comm Communicator for this all-to-all operation.
+ * @param[out] req Request object for the asynchronous operation.
+ */
+template <typename Backend, typename T>
+void NonblockingAlltoallvDynamic(const T* sendbuf,
+                                 std::vector<size_t> send_counts,
+                                 std::vector<size_t> send_displs,
+                                 DynamicRecvBuffer<T>& recv,
+                                 typename Backend::comm_type& comm,
+                                 typename Backend::req_type& req) {
+  debug::check_vector_is_comm_sized<Backend>(send_counts, comm);
+  debug::check_vector_is_comm_sized<Backend>(send_displs, comm);
+  debug::check_buffer(sendbuf, debug::sum(send_counts));
+  AL_CALI_MARK_SCOPE("aluminum:NonblockingAlltoallvDynamic");
+  internal::trace::record_op<Backend, T>(
+    "nonblocking-alltoallv-dynamic", comm, sendbuf, send_counts, send_displs);
+  Backend::template NonblockingAlltoallvDynamic<T>(
+    sendbuf, send_counts, send_displs, recv, comm, req);
+}
+
 /**
  * Perform a gather-to-one.
  *
@@ -27,10 +27,13 @@
 
 #pragma once
 
+#include <cstddef>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 /** HOST_NAME_MAX is a linux only define */
 #ifndef HOST_NAME_MAX
@@ -104,4 +107,40 @@ enum class ReductionOperator {
   sum, prod, min, max, lor, land, lxor, bor, band, bxor, avg
 };
 
+/**
+ * Receive side of an operation whose receive counts are not known in
+ * advance, such as AlltoallvDynamic().
+ *
+ * If allocator is set, it is called once with the total number of
+ * elements that will be received and must return a buffer at least
+ * that large. It may be called from Aluminum's progress thread.
+ * Otherwise, the buffer comes from Aluminum's memory pool and should
+ * be returned with release().
+ *
+ * This must remain valid until the operation completes, after which
+ * buffer, counts, and displs describe the received data.
+ */
+template <typename T>
+struct DynamicRecvBuffer {
+  /** Optional allocator for the receive buffer. */
+  std::function<T*(size_t)> allocator;
+  /** Buffer holding the received data. */
+  T* buffer = nullptr;
+  /** Number of elements received from each rank. */
+  std::vector<size_t> counts;
+  /** Offset of the data from each rank in buffer. */
+  std::vector<size_t> displs;
+  /** Frees buffer when it was allocated by Aluminum. */
+  std::function<void(T*)> deleter;
+
+  /** Free buffer if Aluminum allocated it. */
+  void release() {
+    if (buffer != nullptr && deleter) {
+      deleter(buffer);
+    }
+    buffer = nullptr;
+    deleter = nullptr;
+  }
+};
+
 } // namespace Al
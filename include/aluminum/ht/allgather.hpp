@@ -71,7 +71,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTAllgather"; }
+  const char* get_name() const override { return "HTAllgather"; }
 
 protected:
   void start_mpi_op() override {
@@ -74,7 +74,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTAllgatherv"; }
+  const char* get_name() const override { return "HTAllgatherv"; }
 
 protected:
   void start_mpi_op() override {
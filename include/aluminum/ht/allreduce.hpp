@@ -69,7 +69,7 @@ class AllreduceAlState : public HostTransferCollectiveSignalAtEndState {
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTAllreduce"; }
+  const char* get_name() const override { return "HTAllreduce"; }
 
  protected:
   void start_mpi_op() override {
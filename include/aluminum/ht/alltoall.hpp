@@ -62,7 +62,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTAlltoall"; }
+  const char* get_name() const override { return "HTAlltoall"; }
 
 protected:
   void start_mpi_op() override {
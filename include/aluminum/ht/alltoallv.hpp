@@ -98,7 +98,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_recvbuf);
   }
 
-  std::string get_name() const override { return "HTAlltoallv"; }
+  const char* get_name() const override { return "HTAlltoallv"; }
 
 protected:
   void start_mpi_op() override {
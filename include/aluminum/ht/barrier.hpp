@@ -48,7 +48,7 @@ public:
     end_event.record(stream_);
   }
 
-  std::string get_name() const override { return "HTBarrier"; }
+  const char* get_name() const override { return "HTBarrier"; }
 
 protected:
   void start_mpi_op() override {
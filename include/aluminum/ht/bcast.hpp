@@ -68,7 +68,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTBcast"; }
+  const char* get_name() const override { return "HTBcast"; }
 
 protected:
   void start_mpi_op() override {
@@ -73,7 +73,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTGather"; }
+  const char* get_name() const override { return "HTGather"; }
 
 protected:
   void start_mpi_op() override {
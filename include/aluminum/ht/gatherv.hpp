@@ -81,7 +81,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTGatherv"; }
+  const char* get_name() const override { return "HTGatherv"; }
 
 protected:
   void start_mpi_op() override {
@@ -160,7 +160,7 @@ public:
     }
   }
 
-  std::string get_name() const override { return "HTMultiSendRecv"; }
+  const char* get_name() const override { return "HTMultiSendRecv"; }
 
 protected:
   void start_mpi_op() override {
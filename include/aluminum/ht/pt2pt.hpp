@@ -87,7 +87,7 @@ class SendAlState : public AlState {
   }
   void* get_compute_stream() const override { return compute_stream; }
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "HTSend"; }
+  const char* get_name() const override { return "HTSend"; }
   std::string get_desc() const override {
     return std::to_string(count) + " " + std::to_string(dest);
   }
@@ -156,7 +156,7 @@ class RecvAlState : public AlState {
   }
   void* get_compute_stream() const override { return compute_stream; }
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "HTRecv"; }
+  const char* get_name() const override { return "HTRecv"; }
   std::string get_desc() const override {
     return std::to_string(count) + " " + std::to_string(src);
   }
@@ -206,7 +206,7 @@ class SendRecvAlState : public AlState {
     return send_state.get_compute_stream();
   }
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "HTSendRecv"; }
+  const char* get_name() const override { return "HTSendRecv"; }
   std::string get_desc() const override {
     return send_state.get_desc() + " " + recv_state.get_desc();
   }
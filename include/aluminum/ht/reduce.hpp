@@ -66,7 +66,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTReduce"; }
+  const char* get_name() const override { return "HTReduce"; }
 
 protected:
   void start_mpi_op() override {
@@ -64,7 +64,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTReduceScatter"; }
+  const char* get_name() const override { return "HTReduceScatter"; }
 
 protected:
   void start_mpi_op() override {
@@ -69,7 +69,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTReduceScatterv"; }
+  const char* get_name() const override { return "HTReduceScatterv"; }
 
 protected:
   void start_mpi_op() override {
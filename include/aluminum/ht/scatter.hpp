@@ -77,7 +77,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTScatter"; }
+  const char* get_name() const override { return "HTScatter"; }
 
 protected:
   void start_mpi_op() override {
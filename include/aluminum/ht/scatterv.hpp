@@ -87,7 +87,7 @@ public:
     mempool.release<MemoryType::CUDA_PINNED_HOST>(host_mem);
   }
 
-  std::string get_name() const override { return "HTScatterv"; }
+  const char* get_name() const override { return "HTScatterv"; }
 
 protected:
   void start_mpi_op() override {
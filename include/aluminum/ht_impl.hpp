@@ -841,7 +841,7 @@ class HostTransferBackend {
     NonblockingScatterv<T>(buffer, buffer, counts, displs, root, comm, req, algo);
   }
 
-  static std::string Name() { return "HostTransferBackend"; }
+  static const char* Name() { return "HostTransferBackend"; }
 
  private:
   /** Event for synchronizing between streams. */
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "aluminum/traits/traits_base.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Algorithms the MPI backend picks for each operation on one
+ * communicator, when asked for the automatic algorithm.
+ *
+ * Choices come from the tuning table (see load_tuning_table) or, without
+ * one, the calibrated network model (see calibrate_network). They are
+ * resolved when the communicator is created for its size and ranks per
+ * node, so a lookup is just an array index. Messages are bucketed by powers of
+ * two, so a rule covering [min_bytes, max_bytes] applies to a message
+ * if it covers the largest power of two not exceeding its size.
+ *
+ * Algorithms are stored as indices into the operation's algorithm enum
+ * (e.g., MPIAllreduceAlgorithm); 0 is always automatic, which passes
+ * through to MPI.
+ */
+class AlgoSelector {
+ public:
+  /** Number of operations. */
+  static constexpr size_t num_ops =
+    static_cast<size_t>(AlOperation::multisendrecv) + 1;
+  /** Datatype sizes 1, 2, 4, 8, 16 and anything else. */
+  static constexpr size_t num_type_sizes = 6;
+  /** Zero bytes, then one bucket per power of two. */
+  static constexpr size_t num_buckets = 65;
+
+  /** Resolve the tuning table for a communicator. */
+  AlgoSelector(int comm_size, int ranks_per_node);
+
+  /** Return the algorithm for a message of count elements of type_size. */
+  int select(AlOperation op, size_t type_size, size_t count) const {
+    return choices[static_cast<size_t>(op)][type_size_index(type_size)]
+      [bucket(count * type_size)];
+  }
+
+  /** Return the index for a datatype size. */
+  static size_t type_size_index(size_t type_size) {
+    switch (type_size) {
+    case 1: return 0;
+    case 2: return 1;
+    case 4: return 2;
+    case 8: return 3;
+    case 16: return 4;
+    default: return 5;
+    }
+  }
+  /** Return the bucket for a message of bytes. */
+  static size_t bucket(size_t bytes) {
+    return bytes ? 64 - __builtin_clzll(bytes) : 0;
+  }
+
+ private:
+  std::array<std::array<std::array<uint8_t, num_buckets>, num_type_sizes>,
+             num_ops> choices;
+};
+
+/**
+ * Load the tuning table from the file named by AL_MPI_TUNING_FILE, if
+ * set; called at startup.
+ *
+ * Each line of the file is a rule (blank lines and text after '#' are
+ * ignored):
+ *
+ *   op type_size comm_size ranks_per_node min_bytes max_bytes algorithm
+ *
+ * e.g. "allreduce * 2-64 * 0 4096 mpi_recursive_doubling". op is an
+ * operation name (e.g. allreduce, bcast) and algorithm is one of its
+ * algorithm names (as from algorithm_name()). Numeric fields may be a
+ * value, a range "lo-hi", an open range "lo-", or "*" for any. The first
+ * matching rule wins, and without one the algorithm is automatic. All
+ * ranks must load the same table. Errors throw.
+ */
+void load_tuning_table();
+
+/** Return whether the tuning table has any rules. */
+bool have_tuning_rules();
+
+/**
+ * Return the name of algorithm algo for op.
+ *
+ * The string has static storage duration, so it may be traced.
+ */
+const char* algorithm_cname(AlOperation op, int algo);
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
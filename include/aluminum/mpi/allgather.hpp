@@ -54,7 +54,8 @@ public:
 
   ~AllgatherAlState() override {}
 
-  std::string get_name() const override { return "MPIAllgather"; }
+  const char* get_name() const override { return "MPIAllgather"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/schedule.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Allgather by Bruck's algorithm.
+ *
+ * Blocks are gathered in a temporary buffer rotated so this rank's is
+ * first. In each of ceil(log2(p)) steps, ranks send every block they
+ * have so far (up to the number still needed) to the rank at doubling
+ * distance behind and receive as many from the one ahead, then the
+ * blocks are rotated into place. This takes the fewest steps for any
+ * number of ranks, so suits small messages.
+ *
+ * Blocks may be anywhere in recvbuf, so this implements allgatherv.
+ */
+template <typename T>
+void bruck_nb_allgatherv(const T* sendbuf, T* recvbuf,
+                         const std::vector<size_t>& counts,
+                         const std::vector<size_t>& displs,
+                         MPICommunicator& comm, AlMPIReq& req) {
+  const int size = comm.size();
+  const int rank = comm.rank();
+  // Position j of the temporary buffer holds block rank+j.
+  std::vector<size_t> rotated_counts(size);
+  std::vector<size_t> rotated_displs(size + 1, 0);
+  std::vector<size_t> rotated_recv_displs(size);
+  for (int j = 0; j < size; ++j) {
+    const int block = (rank + j) % size;
+    rotated_counts[j] = counts[block];
+    rotated_displs[j + 1] = rotated_displs[j] + counts[block];
+    rotated_recv_displs[j] = displs[block];
+  }
+  const size_t total = rotated_displs[size];
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIBruckAllgather", IN_PLACE<T>(), recvbuf, total,
+    ReductionOperator::sum, comm, req);
+  T* tmp = state->get_tmp(total);
+  ScheduleStep<T> copy_in;
+  copy_in.copy_from = sendbuf == IN_PLACE<T>() ? recvbuf + displs[rank]
+    : sendbuf;
+  copy_in.copy_to = tmp;
+  copy_in.copy_count = counts[rank];
+  state->add_step(copy_in);
+  for (int distance = 1; distance < size; distance *= 2) {
+    const int num_blocks = std::min(distance, size - distance);
+    ScheduleStep<T> step;
+    step.send_buf = tmp;
+    step.send_count = rotated_displs[num_blocks];
+    step.send_peer = (rank - distance + size) % size;
+    step.recv_buf = tmp + rotated_displs[distance];
+    step.recv_count = rotated_displs[distance + num_blocks]
+      - rotated_displs[distance];
+    step.recv_peer = (rank + distance) % size;
+    state->add_step(step);
+  }
+  add_block_copy_steps(*state, tmp, recvbuf, rotated_displs,
+                       rotated_recv_displs, rotated_counts);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Allgather by recursive doubling.
+ *
+ * In each of log2(p) steps, ranks exchange all the blocks they have so
+ * far with a partner at doubling distance, as in MPICH. This works on
+ * the blocks in place if they are packed in rank order, and otherwise
+ * in a temporary buffer. It needs a power-of-two number of ranks;
+ * otherwise this uses Bruck's algorithm.
+ */
+template <typename T>
+void recursive_doubling_nb_allgatherv(const T* sendbuf, T* recvbuf,
+                                      const std::vector<size_t>& counts,
+                                      const std::vector<size_t>& displs,
+                                      MPICommunicator& comm, AlMPIReq& req) {
+  const int size = comm.size();
+  const int rank = comm.rank();
+  if (size & (size - 1)) {
+    bruck_nb_allgatherv(sendbuf, recvbuf, counts, displs, comm, req);
+    return;
+  }
+  bool packed = true;
+  std::vector<size_t> packed_displs(size + 1, 0);
+  for (int i = 0; i < size; ++i) {
+    packed_displs[i + 1] = packed_displs[i] + counts[i];
+    packed = packed && displs[i] - displs[0] == packed_displs[i];
+  }
+  const size_t total = packed_displs[size];
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIRecursiveDoublingAllgather", IN_PLACE<T>(), recvbuf, total,
+    ReductionOperator::sum, comm, req);
+  T* buf = packed ? recvbuf + displs[0] : state->get_tmp(total);
+  ScheduleStep<T> copy_in;
+  copy_in.copy_from = sendbuf == IN_PLACE<T>() ? recvbuf + displs[rank]
+    : sendbuf;
+  copy_in.copy_to = buf + packed_displs[rank];
+  copy_in.copy_count = counts[rank];
+  state->add_step(copy_in);
+  for (int mask = 1; mask < size; mask <<= 1) {
+    const int peer = rank ^ mask;
+    // Each rank has the blocks of the mask ranks in its aligned group.
+    const int first = rank & ~(mask - 1);
+    const int peer_first = peer & ~(mask - 1);
+    ScheduleStep<T> step;
+    step.send_buf = buf + packed_displs[first];
+    step.send_count = packed_displs[first + mask] - packed_displs[first];
+    step.send_peer = peer;
+    step.recv_buf = buf + packed_displs[peer_first];
+    step.recv_count = packed_displs[peer_first + mask]
+      - packed_displs[peer_first];
+    step.recv_peer = peer;
+    state->add_step(step);
+  }
+  if (!packed) {
+    packed_displs.pop_back();
+    add_block_copy_steps(*state, buf, recvbuf, packed_displs, displs, counts);
+  }
+  get_progress_engine()->enqueue(state);
+}
+
+template <typename T>
+void bruck_nb_allgather(const T* sendbuf, T* recvbuf, size_t count,
+                        MPICommunicator& comm, AlMPIReq& req) {
+  bruck_nb_allgatherv(sendbuf, recvbuf,
+                      std::vector<size_t>(comm.size(), count),
+                      block_displs(comm.size(), count), comm, req);
+}
+
+template <typename T>
+void recursive_doubling_nb_allgather(const T* sendbuf, T* recvbuf,
+                                     size_t count, MPICommunicator& comm,
+                                     AlMPIReq& req) {
+  recursive_doubling_nb_allgatherv(sendbuf, recvbuf,
+                                   std::vector<size_t>(comm.size(), count),
+                                   block_displs(comm.size(), count), comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Allgather with a pipelined ring.
+ *
+ * In each of p-1 steps, every rank sends one block to its successor and
+ * receives one from its predecessor, which it forwards in the next step.
+ * Blocks are split into segments of at most AL_MPI_RING_SEGMENT_BYTES,
+ * and each segment is forwarded as soon as it arrives, with at most
+ * AL_MPI_RING_PIPELINE_DEPTH in flight in each direction. Since there is
+ * no synchronization between steps, when block sizes are skewed (as in
+ * allgatherv) a large block streams through the ring behind small ones
+ * rather than holding up every link for a whole step.
+ *
+ * Blocks may be anywhere in recvbuf, so this implements allgatherv.
+ */
+template <typename T>
+class RingAllgatherAlState : public MPIState {
+public:
+  RingAllgatherAlState(const T* sendbuf_, T* recvbuf_,
+                       const std::vector<size_t>& counts,
+                       const std::vector<size_t>& displs,
+                       MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), comm(comm_),
+    tag(comm_.get_free_tag()) {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    next = (rank + 1) % size;
+    prev = (rank + size - 1) % size;
+    own_offset = displs[rank];
+    own_count = counts[rank];
+    total = sum_counts(counts);
+    const size_t seg_count = std::max<size_t>(
+      AL_MPI_RING_SEGMENT_BYTES / sizeof(T), 1);
+    auto block_segments = [&](int block, std::vector<Segment>& segs) {
+      for (size_t off = 0; off < counts[block]; off += seg_count) {
+        segs.push_back({displs[block] + off,
+                        std::min(seg_count, counts[block] - off)});
+      }
+    };
+    if (size > 1) {
+      block_segments(rank, first_sends);
+    }
+    // Step k receives block rank-k-1 and forwards it in step k+1, except
+    // in the last step.
+    num_sends = first_sends.size();
+    for (int k = 0; k < size - 1; ++k) {
+      if (k == size - 2) {
+        num_sends += recvs.size();
+      }
+      block_segments((rank - k - 1 + size) % size, recvs);
+    }
+  }
+
+  ~RingAllgatherAlState() override {}
+
+  const char* get_name() const override { return "MPIRingAllgather"; }
+  size_t get_bytes() const override { return total * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    if (sendbuf != IN_PLACE<T>()) {
+      std::copy_n(sendbuf, own_count, recvbuf + own_offset);
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  /** A contiguous piece of the buffer sent in one message. */
+  struct Segment {
+    size_t offset;
+    size_t count;
+  };
+
+  const T* sendbuf;
+  T* recvbuf;
+  MPICommunicator& comm;
+  int tag;
+  int next;
+  int prev;
+  /** Location and size of this rank's block. */
+  size_t own_offset;
+  size_t own_count;
+  /** Total elements gathered. */
+  size_t total;
+  /** Segments sent before anything has been received. */
+  std::vector<Segment> first_sends;
+  /** Segments received, in order; all but the last block are forwarded. */
+  std::vector<Segment> recvs;
+  /** Total number of sends. */
+  size_t num_sends;
+  MPI_Request send_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  MPI_Request recv_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  /** Number of sends started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+  /** Number of receives started and completed. */
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+};
+
+template <typename T>
+bool RingAllgatherAlState<T>::poll_mpi() {
+  constexpr size_t depth = AL_MPI_RING_PIPELINE_DEPTH;
+  int flag;
+  // Complete receives in order.
+  while (recvs_done < recvs_started) {
+    MPI_Test(&recv_reqs[recvs_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++recvs_done;
+  }
+  // Complete sends in order.
+  while (sends_done < sends_started) {
+    MPI_Test(&send_reqs[sends_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  // Forward segments once they have been received.
+  while (sends_started < num_sends && sends_started - sends_done < depth
+         && (sends_started < first_sends.size()
+             || sends_started - first_sends.size() < recvs_done)) {
+    const Segment& seg = sends_started < first_sends.size()
+      ? first_sends[sends_started] : recvs[sends_started - first_sends.size()];
+    MPI_Isend(recvbuf + seg.offset, seg.count, TypeMap<T>(), next, tag,
+              comm.get_comm(), &send_reqs[sends_started % depth]);
+    comm.count_send(next, seg.count*sizeof(T));
+    ++sends_started;
+  }
+  // Receive segments directly into place.
+  while (recvs_started < recvs.size() && recvs_started - recvs_done < depth) {
+    const Segment& seg = recvs[recvs_started];
+    MPI_Irecv(recvbuf + seg.offset, seg.count, TypeMap<T>(), prev, tag,
+              comm.get_comm(), &recv_reqs[recvs_started % depth]);
+    ++recvs_started;
+  }
+  return sends_done == num_sends && recvs_done == recvs.size();
+}
+
+template <typename T>
+void ring_nb_allgatherv(const T* sendbuf, T* recvbuf,
+                        const std::vector<size_t>& counts,
+                        const std::vector<size_t>& displs,
+                        MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::RingAllgatherAlState<T>* state =
+    new internal::mpi::RingAllgatherAlState<T>(
+      sendbuf, recvbuf, counts, displs, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+template <typename T>
+void ring_nb_allgather(const T* sendbuf, T* recvbuf, size_t count,
+                       MPICommunicator& comm, AlMPIReq& req) {
+  ring_nb_allgatherv(sendbuf, recvbuf, std::vector<size_t>(comm.size(), count),
+                     block_displs(comm.size(), count), comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
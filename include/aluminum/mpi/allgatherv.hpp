@@ -63,7 +63,8 @@ public:
 
   ~AllgathervAlState() override {}
 
-  std::string get_name() const override { return "MPIAllgatherv"; }
+  const char* get_name() const override { return "MPIAllgatherv"; }
+  size_t get_bytes() const override { return sum_counts(counts) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -54,7 +54,8 @@ public:
 
   ~AllreduceAlState() override {}
 
-  std::string get_name() const override { return "MPIAllreduce"; }
+  const char* get_name() const override { return "MPIAllreduce"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
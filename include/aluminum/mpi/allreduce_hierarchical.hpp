@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Node-aware allreduce.
+ *
+ * When every node has the same number of ranks, this reduce-scatters
+ * within each node, allreduces each shard among the ranks holding it on
+ * the other nodes, then allgathers within each node. Otherwise, this
+ * reduces to a leader on each node, allreduces among the leaders, and
+ * broadcasts within each node. Either way, inter-node traffic is cut by
+ * the number of ranks per node.
+ *
+ * If the communicator has no hierarchy (see MPICommunicator::get_node_comm),
+ * this is a plain allreduce.
+ */
+template <typename T>
+class HierarchicalAllreduceAlState : public MPIState {
+public:
+  HierarchicalAllreduceAlState(const T* sendbuf_, T* recvbuf_, size_t count_,
+                               ReductionOperator op_, MPICommunicator& comm_,
+                               AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), count(count_),
+    op(ReductionOperator2MPI_Op<T>(op_)), comm(comm_),
+    node_comm(comm_.get_node_comm()) {
+    if (node_comm && node_comm->is_uniform()) {
+      const int local_size = comm.local_size();
+      counts.resize(local_size);
+      displs.resize(local_size);
+      for (int i = 0; i < local_size; ++i) {
+        counts[i] = count / local_size
+          + (static_cast<size_t>(i) < count % local_size ? 1 : 0);
+        displs[i] = i ? displs[i - 1] + counts[i - 1] : 0;
+      }
+    }
+  }
+
+  ~HierarchicalAllreduceAlState() override {}
+
+  const char* get_name() const override { return "MPIHierarchicalAllreduce"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    start_phase();
+  }
+
+  bool poll_mpi() override {
+    while (true) {
+      int flag;
+      MPI_Test(get_mpi_req(), &flag, MPI_STATUS_IGNORE);
+      if (!flag) {
+        return false;
+      }
+      if (!node_comm || ++phase == 3) {
+        return true;
+      }
+      start_phase();
+    }
+  }
+
+private:
+  /** Post the MPI operation for the current phase. */
+  void start_phase() {
+    if (!node_comm) {
+      MPI_Iallreduce(buf_or_inplace(sendbuf), recvbuf, count, TypeMap<T>(),
+                     op, comm.get_comm(), get_mpi_req());
+    } else if (node_comm->is_uniform()) {
+      start_sharded_phase();
+    } else {
+      start_leader_phase();
+    }
+  }
+
+  /** Phases for the reduce-scatter/allreduce/allgather version. */
+  void start_sharded_phase() {
+    const int local_rank = comm.local_rank();
+    T* shard = recvbuf + displs[local_rank];
+    switch (phase) {
+    case 0:
+      if (sendbuf == IN_PLACE<T>()) {
+        // The result lands at the start of recvbuf; moved in phase 1.
+        MPI_Ireduce_scatter(MPI_IN_PLACE, recvbuf, counts.data(),
+                            TypeMap<T>(), op, comm.get_local_comm(),
+                            get_mpi_req());
+      } else {
+        MPI_Ireduce_scatter(sendbuf, shard, counts.data(), TypeMap<T>(), op,
+                            comm.get_local_comm(), get_mpi_req());
+      }
+      break;
+    case 1:
+      if (sendbuf == IN_PLACE<T>() && shard != recvbuf) {
+        std::copy_backward(recvbuf, recvbuf + counts[local_rank],
+                           shard + counts[local_rank]);
+      }
+      MPI_Iallreduce(MPI_IN_PLACE, shard, counts[local_rank], TypeMap<T>(),
+                     op, node_comm->get_cross_comm(), get_mpi_req());
+      break;
+    case 2:
+      MPI_Iallgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, recvbuf,
+                      counts.data(), displs.data(), TypeMap<T>(),
+                      comm.get_local_comm(), get_mpi_req());
+      break;
+    }
+  }
+
+  /** Phases for the reduce/leader allreduce/broadcast version. */
+  void start_leader_phase() {
+    const bool leader = comm.local_rank() == 0;
+    switch (phase) {
+    case 0:
+      if (leader) {
+        MPI_Ireduce(buf_or_inplace(sendbuf), recvbuf, count, TypeMap<T>(), op,
+                    0, comm.get_local_comm(), get_mpi_req());
+      } else {
+        MPI_Ireduce(sendbuf == IN_PLACE<T>() ? recvbuf : sendbuf, nullptr,
+                    count, TypeMap<T>(), op, 0, comm.get_local_comm(),
+                    get_mpi_req());
+      }
+      break;
+    case 1:
+      if (leader) {
+        MPI_Iallreduce(MPI_IN_PLACE, recvbuf, count, TypeMap<T>(), op,
+                       node_comm->get_cross_comm(), get_mpi_req());
+      }
+      // Other ranks have nothing to do, and their request is null.
+      break;
+    case 2:
+      MPI_Ibcast(recvbuf, count, TypeMap<T>(), 0, comm.get_local_comm(),
+                 get_mpi_req());
+      break;
+    }
+  }
+
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  MPI_Op op;
+  MPICommunicator& comm;
+  const NodeComm* node_comm;
+  /** Shard sizes and offsets on each node, when nodes are uniform. */
+  std::vector<int> counts;
+  std::vector<int> displs;
+  /** Current phase (0 to 2) when running hierarchically. */
+  int phase = 0;
+};
+
+template <typename T>
+void hierarchical_nb_allreduce(const T* sendbuf, T* recvbuf, size_t count,
+                               ReductionOperator op, MPICommunicator& comm,
+                               AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::HierarchicalAllreduceAlState<T>* state =
+    new internal::mpi::HierarchicalAllreduceAlState<T>(
+      sendbuf, recvbuf, count, op, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+} // namespace mpi
+} // namespace internal
+} // namespace Al
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/schedule.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Allreduce by recursive doubling.
+ *
+ * In each of log2(p) steps, ranks exchange their entire buffer with a
+ * partner at doubling distance and reduce, so this is latency-optimal
+ * and suits small messages. Non-power-of-two sizes are folded first.
+ */
+template <typename T>
+void recursive_doubling_nb_allreduce(const T* sendbuf, T* recvbuf,
+                                     size_t count, ReductionOperator op,
+                                     MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIRecursiveDoublingAllreduce", sendbuf, recvbuf, count, op, comm, req);
+  PowerOfTwoFold fold = add_fold_in_steps(*state, recvbuf, count, comm);
+  if (!fold.is_extra()) {
+    T* tmp = state->get_tmp(count);
+    for (int mask = 1; mask < fold.pof2; mask <<= 1) {
+      const int peer = fold.real_rank(fold.newrank ^ mask);
+      ScheduleStep<T> step;
+      step.send_buf = recvbuf;
+      step.send_count = count;
+      step.send_peer = peer;
+      step.recv_buf = tmp;
+      step.recv_count = count;
+      step.recv_peer = peer;
+      step.reduce_into = recvbuf;
+      state->add_step(step);
+    }
+  }
+  add_fold_out_steps(*state, recvbuf, count, fold);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Allreduce by Rabenseifner's algorithm.
+ *
+ * This is a reduce-scatter by recursive halving followed by an allgather
+ * by recursive doubling, as in MPICH. Each rank sends about 2n bytes in
+ * 2*log2(p) steps, so this suits medium messages. Non-power-of-two sizes
+ * are folded first.
+ */
+template <typename T>
+void rabenseifner_nb_allreduce(const T* sendbuf, T* recvbuf,
+                               size_t count, ReductionOperator op,
+                               MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIRabenseifnerAllreduce", sendbuf, recvbuf, count, op, comm, req);
+  PowerOfTwoFold fold = add_fold_in_steps(*state, recvbuf, count, comm);
+  if (!fold.is_extra()) {
+    const int pof2 = fold.pof2;
+    T* tmp = state->get_tmp(count);
+    // Split the buffer into pof2 blocks.
+    std::vector<size_t> displs(pof2 + 1, 0);
+    for (int i = 0; i < pof2; ++i) {
+      displs[i + 1] = displs[i] + count / pof2
+        + (static_cast<size_t>(i) < count % pof2 ? 1 : 0);
+    }
+    auto add_exchange = [&](int peer, int send_idx, int send_end,
+                            int recv_idx, int recv_end, bool reduce) {
+      ScheduleStep<T> step;
+      step.send_buf = recvbuf + displs[send_idx];
+      step.send_count = displs[send_end] - displs[send_idx];
+      step.send_peer = peer;
+      step.recv_buf = (reduce ? tmp : recvbuf) + displs[recv_idx];
+      step.recv_count = displs[recv_end] - displs[recv_idx];
+      step.recv_peer = peer;
+      step.reduce_into = reduce ? recvbuf + displs[recv_idx] : nullptr;
+      state->add_step(step);
+    };
+    // Reduce-scatter: halve the blocks exchanged at each step.
+    int send_idx = 0;
+    int recv_idx = 0;
+    int last_idx = pof2;
+    int mask = 1;
+    while (mask < pof2) {
+      const int newpeer = fold.newrank ^ mask;
+      if (fold.newrank < newpeer) {
+        send_idx = recv_idx + pof2 / (mask*2);
+        add_exchange(fold.real_rank(newpeer), send_idx, last_idx,
+                     recv_idx, send_idx, true);
+      } else {
+        recv_idx = send_idx + pof2 / (mask*2);
+        add_exchange(fold.real_rank(newpeer), send_idx, recv_idx,
+                     recv_idx, last_idx, true);
+      }
+      send_idx = recv_idx;
+      mask <<= 1;
+      // last_idx is needed unchanged for the allgather.
+      if (mask < pof2) {
+        last_idx = recv_idx + pof2 / mask;
+      }
+    }
+    // Allgather: the reverse, doubling the blocks exchanged.
+    mask >>= 1;
+    while (mask > 0) {
+      const int newpeer = fold.newrank ^ mask;
+      if (fold.newrank < newpeer) {
+        if (mask != pof2 / 2) {
+          last_idx = last_idx + pof2 / (mask*2);
+        }
+        recv_idx = send_idx + pof2 / (mask*2);
+        add_exchange(fold.real_rank(newpeer), send_idx, recv_idx,
+                     recv_idx, last_idx, false);
+      } else {
+        recv_idx = send_idx - pof2 / (mask*2);
+        add_exchange(fold.real_rank(newpeer), send_idx, last_idx,
+                     recv_idx, send_idx, false);
+        send_idx = recv_idx;
+      }
+      mask >>= 1;
+    }
+  }
+  add_fold_out_steps(*state, recvbuf, count, fold);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * One direction of a pipelined ring allreduce over a buffer.
+ *
+ * This is a reduce-scatter followed by an allgather, each of p-1 steps
+ * in which every rank sends one chunk (1/p of the buffer) to its
+ * successor and receives one from its predecessor. Chunks are split into
+ * segments of at most AL_MPI_RING_SEGMENT_BYTES, and each segment is
+ * forwarded as soon as it has been received (and reduced), so reducing
+ * one segment overlaps with transferring the next. At most
+ * AL_MPI_RING_PIPELINE_DEPTH segments are in flight in each direction.
+ *
+ * Messages are matched by order, so all use the same tag.
+ */
+template <typename T>
+class RingAllreducer {
+public:
+  /**
+   * Set up a ring allreduce of buf (which holds this rank's input) that
+   * sends to the next rank (or the previous rank if reverse).
+   */
+  RingAllreducer(T* buf_, size_t count, ReductionOperator op_,
+                 MPICommunicator& comm_, bool reverse, int tag_) :
+    buf(buf_), op(op_), comm(comm_), tag(tag_) {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    next = (rank + (reverse ? size - 1 : 1)) % size;
+    prev = (rank + (reverse ? 1 : size - 1)) % size;
+    // The chunk each rank starts sending is its own rank's position in
+    // the ring, which is reversed when going the other way.
+    const int pos = reverse ? (size - rank) % size : rank;
+    // Segments need be no larger than a chunk.
+    seg_count = std::max<size_t>(
+      std::min<size_t>(AL_MPI_RING_SEGMENT_BYTES / sizeof(T),
+                       (count + size - 1) / size), 1);
+    // Chunks are as even as possible, in ring order.
+    auto chunk_segments = [&](int chunk, bool reduce, std::vector<Segment>& segs) {
+      const size_t base = count / size;
+      const size_t extra = count % size;
+      const size_t chunk_count = base + (static_cast<size_t>(chunk) < extra ? 1 : 0);
+      const size_t chunk_offset = base*chunk + std::min<size_t>(chunk, extra);
+      for (size_t off = 0; off < chunk_count; off += seg_count) {
+        segs.push_back({chunk_offset + off,
+                        std::min(seg_count, chunk_count - off), reduce});
+      }
+    };
+    if (size > 1) {
+      chunk_segments(pos, false, first_sends);
+    }
+    // Step k of the reduce-scatter receives chunk pos-k-1 and reduces it,
+    // then step k of the allgather receives the fully-reduced chunk pos-k.
+    // Everything received is forwarded, except in the last step.
+    num_sends = first_sends.size();
+    for (int k = 0; k < 2*(size - 1); ++k) {
+      if (k == size - 2) {
+        num_reduce_scatter_sends = first_sends.size() + recvs.size();
+      }
+      if (k == 2*(size - 1) - 1) {
+        num_sends += recvs.size();
+      }
+      const int chunk = (pos - k - 1 + 2*size) % size;
+      chunk_segments(chunk, k < size - 1, recvs);
+    }
+    tmp = mempool.allocate<MemoryType::HOST, T>(
+      AL_MPI_RING_PIPELINE_DEPTH * seg_count);
+  }
+
+  ~RingAllreducer() {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  RingAllreducer(const RingAllreducer&) = delete;
+  RingAllreducer& operator=(const RingAllreducer&) = delete;
+
+  /** Start and make progress on messages; return true when complete. */
+  bool step();
+
+private:
+  /** A contiguous piece of the buffer sent in one message. */
+  struct Segment {
+    size_t offset;
+    size_t count;
+    /** Whether this is reduced into the buffer rather than copied. */
+    bool reduce;
+  };
+
+  T* buf;
+  ReductionOperator op;
+  MPICommunicator& comm;
+  int tag;
+  int next;
+  int prev;
+  /** Maximum elements in a segment. */
+  size_t seg_count;
+  /** Segments sent before anything has been received. */
+  std::vector<Segment> first_sends;
+  /** Segments received, in order; all but the last chunk are forwarded. */
+  std::vector<Segment> recvs;
+  /** Total number of sends. */
+  size_t num_sends;
+  /** Number of sends in the reduce-scatter. */
+  size_t num_reduce_scatter_sends = 0;
+  /** Buffers for segments being received for reduction. */
+  T* tmp = nullptr;
+  MPI_Request send_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  MPI_Request recv_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  /** Number of sends started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+  /** Number of receives started and completed (and reduced). */
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+};
+
+template <typename T>
+bool RingAllreducer<T>::step() {
+  constexpr size_t depth = AL_MPI_RING_PIPELINE_DEPTH;
+  int flag;
+  // Complete receives in order, reducing them into the buffer.
+  while (recvs_done < recvs_started) {
+    MPI_Test(&recv_reqs[recvs_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    const Segment& seg = recvs[recvs_done];
+    if (seg.reduce) {
+      reduce_local(tmp + (recvs_done % depth)*seg_count, buf + seg.offset,
+                   seg.count, op);
+    }
+    ++recvs_done;
+  }
+  // Complete sends in order.
+  while (sends_done < sends_started) {
+    MPI_Test(&send_reqs[sends_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  // Forward segments once they have been received.
+  while (sends_started < num_sends && sends_started - sends_done < depth
+         && (sends_started < first_sends.size()
+             || sends_started - first_sends.size() < recvs_done)) {
+    const Segment& seg = sends_started < first_sends.size()
+      ? first_sends[sends_started] : recvs[sends_started - first_sends.size()];
+    MPI_Isend(buf + seg.offset, seg.count, TypeMap<T>(), next, tag,
+              comm.get_comm(), &send_reqs[sends_started % depth]);
+    comm.count_send(next, seg.count*sizeof(T));
+    ++sends_started;
+  }
+  // Post receives. The allgather receives directly into the buffer, so
+  // wait for the reduce-scatter sends from it to complete first.
+  while (recvs_started < recvs.size() && recvs_started - recvs_done < depth) {
+    const Segment& seg = recvs[recvs_started];
+    if (!seg.reduce && sends_done < num_reduce_scatter_sends) {
+      break;
+    }
+    T* dst = seg.reduce ? tmp + (recvs_started % depth)*seg_count
+      : buf + seg.offset;
+    MPI_Irecv(dst, seg.count, TypeMap<T>(), prev, tag, comm.get_comm(),
+              &recv_reqs[recvs_started % depth]);
+    ++recvs_started;
+  }
+  return sends_done == num_sends && recvs_done == recvs.size();
+}
+
+template <typename T>
+class RingAllreduceAlState : public MPIState {
+public:
+  /**
+   * Allreduce with a pipelined ring, or with two rings in opposite
+   * directions, each over half the buffer, if bidirectional.
+   */
+  RingAllreduceAlState(const T* sendbuf_, T* recvbuf_, size_t count_,
+                       ReductionOperator op, MPICommunicator& comm,
+                       bool bidirectional_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), count(count_),
+    bidirectional(bidirectional_) {
+    if (bidirectional) {
+      const size_t half = count / 2;
+      rings.emplace_back(std::make_unique<RingAllreducer<T>>(
+                           recvbuf, half, op, comm, false, comm.get_free_tag()));
+      rings.emplace_back(std::make_unique<RingAllreducer<T>>(
+                           recvbuf + half, count - half, op, comm, true,
+                           comm.get_free_tag()));
+    } else {
+      rings.emplace_back(std::make_unique<RingAllreducer<T>>(
+                           recvbuf, count, op, comm, false, comm.get_free_tag()));
+    }
+  }
+
+  ~RingAllreduceAlState() override {}
+
+  const char* get_name() const override {
+    return bidirectional ? "MPIBiringAllreduce" : "MPIRingAllreduce";
+  }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    if (sendbuf != IN_PLACE<T>()) {
+      std::copy_n(sendbuf, count, recvbuf);
+    }
+  }
+
+  bool poll_mpi() override {
+    bool done = true;
+    for (auto& ring : rings) {
+      done = ring->step() && done;
+    }
+    return done;
+  }
+
+private:
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  bool bidirectional;
+  std::vector<std::unique_ptr<RingAllreducer<T>>> rings;
+};
+
+template <typename T>
+void ring_nb_allreduce(const T* sendbuf, T* recvbuf, size_t count,
+                       ReductionOperator op, MPICommunicator& comm,
+                       bool bidirectional, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::RingAllreduceAlState<T>* state =
+    new internal::mpi::RingAllreduceAlState<T>(
+      sendbuf, recvbuf, count, op, comm, bidirectional, req);
+  get_progress_engine()->enqueue(state);
+}
+
+} // namespace mpi
+} // namespace internal
+} // namespace Al
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/allreduce.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/shm.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Allreduce among ranks on one node through shared memory.
+ *
+ * The buffer is processed in rounds of up to the shared buffer size.
+ * In each round, every rank copies its data into its shared buffer;
+ * then rank i reduces the i'th slice of all buffers in place, reading
+ * its peers' buffers directly; then every rank copies all the reduced
+ * slices out. Each byte is thus copied in once and out once.
+ */
+template <typename T>
+class ShmAllreduceAlState : public MPIState {
+public:
+  ShmAllreduceAlState(const T* sendbuf_, T* recvbuf_, size_t count_,
+                      ReductionOperator op_, MPICommunicator& comm_,
+                      AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_ == IN_PLACE<T>() ? recvbuf_ : sendbuf_),
+    recvbuf(recvbuf_), count(count_), op(op_),
+    shm(*comm_.get_node_shm()),
+    rank(comm_.local_rank()), size(comm_.local_size()),
+    round_count(shm.buffer_bytes() / sizeof(T)),
+    num_steps(3 * ((count + round_count - 1) / round_count)) {}
+
+  ~ShmAllreduceAlState() override {}
+
+  const char* get_name() const override { return "MPIShmAllreduce"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    ticket = shm.take_ticket();
+  }
+
+  bool poll_mpi() override {
+    if (!shm.is_turn(ticket)) {
+      return false;
+    }
+    for (; cur_step < num_steps; ++cur_step) {
+      if (!shm.ready()) {
+        return false;
+      }
+      run_step();
+      shm.finish_step();
+    }
+    shm.release();
+    return true;
+  }
+
+private:
+  /** Return the start of rank i's slice of n elements. */
+  size_t slice_start(size_t n, int i) const {
+    return (n / size) * i + std::min<size_t>(i, n % size);
+  }
+  /** Return the length of rank i's slice of n elements. */
+  size_t slice_count(size_t n, int i) const {
+    return n / size + (static_cast<size_t>(i) < n % size ? 1 : 0);
+  }
+
+  void run_step() {
+    const size_t offset = (cur_step / 3) * round_count;
+    const size_t n = std::min(round_count, count - offset);
+    switch (cur_step % 3) {
+    case 0:
+      std::copy_n(sendbuf + offset, n, shm.get_buffer<T>(rank));
+      break;
+    case 1:
+      {
+        const size_t start = slice_start(n, rank);
+        const size_t len = slice_count(n, rank);
+        T* mine = shm.get_buffer<T>(rank) + start;
+        for (int i = 0; i < size; ++i) {
+          if (i != rank) {
+            reduce_local(shm.get_buffer<T>(i) + start, mine, len, op);
+          }
+        }
+      }
+      break;
+    case 2:
+      for (int i = 0; i < size; ++i) {
+        const size_t start = slice_start(n, i);
+        std::copy_n(shm.get_buffer<T>(i) + start, slice_count(n, i),
+                    recvbuf + offset + start);
+      }
+      break;
+    }
+  }
+
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  ReductionOperator op;
+  NodeShm& shm;
+  int rank;
+  int size;
+  /** Elements in each round. */
+  size_t round_count;
+  size_t num_steps;
+  size_t cur_step = 0;
+  uint64_t ticket = 0;
+};
+
+/**
+ * Allreduce through shared memory if comm is on one node, otherwise
+ * pass through to MPI.
+ */
+template <typename T>
+void shm_nb_allreduce(const T* sendbuf, T* recvbuf, size_t count,
+                      ReductionOperator op, MPICommunicator& comm,
+                      AlMPIReq& req) {
+  if (!comm.get_node_shm() || comm.local_size() != comm.size()
+      || comm.get_node_shm()->buffer_bytes() < sizeof(T)) {
+    passthrough_nb_allreduce(sendbuf, recvbuf, count, op, comm, req);
+    return;
+  }
+  req = get_free_request();
+  internal::mpi::ShmAllreduceAlState<T>* state =
+    new internal::mpi::ShmAllreduceAlState<T>(
+      sendbuf, recvbuf, count, op, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+} // namespace mpi
+} // namespace internal
+} // namespace Al
@@ -54,7 +54,8 @@ public:
 
   ~AlltoallAlState() override {}
 
-  std::string get_name() const override { return "MPIAlltoall"; }
+  const char* get_name() const override { return "MPIAlltoall"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/schedule.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Alltoall by Bruck's algorithm.
+ *
+ * Blocks are first rotated so that position j holds the block for rank
+ * rank+j. In each of ceil(log2(p)) steps, the blocks at positions with
+ * bit k set are packed and sent to the rank 2^k ahead, and the same
+ * positions are received from the rank 2^k behind and unpacked. Position
+ * j then holds the block from rank rank-j, and the blocks are rotated
+ * into place. Each rank sends about (p/2)*log2(p) blocks but in only
+ * log2(p) messages, so this suits small blocks. All local copies move
+ * whole blocks, merging adjacent ones.
+ */
+template <typename T>
+void bruck_nb_alltoall(const T* sendbuf, T* recvbuf, size_t count,
+                       MPICommunicator& comm, AlMPIReq& req) {
+  const int size = comm.size();
+  const int rank = comm.rank();
+  const size_t half = static_cast<size_t>((size + 1) / 2);
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIBruckAlltoall", IN_PLACE<T>(), recvbuf, size*count,
+    ReductionOperator::sum, comm, req);
+  // Rotated blocks, then buffers for packed blocks to send and receive.
+  T* rotated = state->get_tmp(size*count + 2*half*count);
+  T* send_pack = rotated + size*count;
+  T* recv_pack = send_pack + half*count;
+  const std::vector<size_t> counts(size, count);
+  std::vector<size_t> from_displs(size);
+  for (int j = 0; j < size; ++j) {
+    from_displs[j] = ((rank + j) % size) * count;
+  }
+  add_block_copy_steps(*state,
+                       sendbuf == IN_PLACE<T>() ? recvbuf : sendbuf,
+                       rotated, from_displs, block_displs(size, count),
+                       counts);
+  for (int distance = 1; distance < size; distance *= 2) {
+    std::vector<size_t> positions;
+    for (int j = 0; j < size; ++j) {
+      if (j & distance) {
+        positions.push_back(j * count);
+      }
+    }
+    const std::vector<size_t> pack_counts(positions.size(), count);
+    const std::vector<size_t> pack_displs =
+      block_displs(positions.size(), count);
+    add_block_copy_steps(*state, rotated, send_pack, positions,
+                         pack_displs, pack_counts);
+    ScheduleStep<T> step;
+    step.send_buf = send_pack;
+    step.send_count = positions.size() * count;
+    step.send_peer = (rank + distance) % size;
+    step.recv_buf = recv_pack;
+    step.recv_count = positions.size() * count;
+    step.recv_peer = (rank - distance + size) % size;
+    state->add_step(step);
+    add_block_copy_steps(*state, recv_pack, rotated, pack_displs,
+                         positions, pack_counts);
+  }
+  for (int i = 0; i < size; ++i) {
+    from_displs[i] = ((rank - i + size) % size) * count;
+  }
+  add_block_copy_steps(*state, rotated, recvbuf, from_displs,
+                       block_displs(size, count), counts);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Alltoall by pairwise exchange.
+ *
+ * In exchange k (for k = 1, ..., p-1), each rank sends its block for
+ * rank+k and receives the block from rank-k, so every rank sends to and
+ * receives from a different peer at once. At most
+ * AL_MPI_ALLTOALL_WINDOW exchanges are in flight, rather than posting
+ * every message at once, to avoid flooding the network and receivers
+ * with large blocks.
+ */
+template <typename T>
+class PairwiseAlltoallAlState : public MPIState {
+public:
+  PairwiseAlltoallAlState(const T* sendbuf_, T* recvbuf_, size_t count_,
+                          MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), count(count_), comm(comm_),
+    tag(comm_.get_free_tag()) {
+    // In place, blocks are received over ones not yet sent, so send
+    // from a copy.
+    if (sendbuf == IN_PLACE<T>()) {
+      tmp = mempool.allocate<MemoryType::HOST, T>(
+        std::max<size_t>(comm.size()*count, 1));
+    }
+  }
+
+  ~PairwiseAlltoallAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return "MPIPairwiseAlltoall"; }
+  size_t get_bytes() const override { return comm.size() * count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    const int rank = comm.rank();
+    if (tmp) {
+      std::copy_n(recvbuf, comm.size()*count, tmp);
+      sendbuf = tmp;
+    } else {
+      std::copy_n(sendbuf + rank*count, count, recvbuf + rank*count);
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  MPICommunicator& comm;
+  int tag;
+  /** Copy of the input when in place. */
+  T* tmp = nullptr;
+  /** Receive and send requests for each exchange in flight. */
+  MPI_Request reqs[2*AL_MPI_ALLTOALL_WINDOW];
+  /** Number of exchanges started and completed, excluding this rank. */
+  int started = 0;
+  int done = 0;
+};
+
+template <typename T>
+bool PairwiseAlltoallAlState<T>::poll_mpi() {
+  constexpr int window = AL_MPI_ALLTOALL_WINDOW;
+  const int rank = comm.rank();
+  const int size = comm.size();
+  int flag;
+  // Complete exchanges in order.
+  while (done < started) {
+    MPI_Testall(2, &reqs[2*(done % window)], &flag, MPI_STATUSES_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++done;
+  }
+  while (started < size - 1 && started - done < window) {
+    const int k = started + 1;
+    const int dst = (rank + k) % size;
+    const int src = (rank - k + size) % size;
+    MPI_Request* r = &reqs[2*(started % window)];
+    MPI_Irecv(recvbuf + src*count, count, TypeMap<T>(), src, tag,
+              comm.get_comm(), &r[0]);
+    MPI_Isend(sendbuf + dst*count, count, TypeMap<T>(), dst, tag,
+              comm.get_comm(), &r[1]);
+    comm.count_send(dst, count*sizeof(T));
+    ++started;
+  }
+  return done == size - 1;
+}
+
+template <typename T>
+void pairwise_nb_alltoall(const T* sendbuf, T* recvbuf, size_t count,
+                          MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::PairwiseAlltoallAlState<T>* state =
+    new internal::mpi::PairwiseAlltoallAlState<T>(
+      sendbuf, recvbuf, count, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
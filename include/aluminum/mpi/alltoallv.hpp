@@ -76,7 +76,8 @@ public:
 
   ~AlltoallvAlState() override {}
 
-  std::string get_name() const override { return "MPIAlltoallv"; }
+  const char* get_name() const override { return "MPIAlltoallv"; }
+  size_t get_bytes() const override { return sum_counts(send_counts) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
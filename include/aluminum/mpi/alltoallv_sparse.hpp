@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Alltoallv by point-to-point messages between peers with data only.
+ *
+ * Peers are visited in pairwise-exchange order (rank+k and rank-k for
+ * k = 1, ..., p-1), skipping any with nothing to send or receive, and at
+ * most AL_MPI_ALLTOALL_WINDOW sends are in flight. When few peers have
+ * data, all receives are posted up front. Above
+ * AL_MPI_ALLTOALLV_DENSE_PERCENT of peers (or if dense), receives are
+ * windowed like sends, so this becomes a pairwise exchange.
+ *
+ * Since a rank sends to a peer exactly when that peer receives from it,
+ * ranks can choose between the two schedules independently.
+ */
+template <typename T>
+class SparseAlltoallvAlState : public MPIState {
+public:
+  SparseAlltoallvAlState(const T* sendbuf_,
+                         const std::vector<size_t>& send_counts,
+                         const std::vector<size_t>& send_displs,
+                         T* recvbuf_,
+                         const std::vector<size_t>& recv_counts,
+                         const std::vector<size_t>& recv_displs,
+                         MPICommunicator& comm_, bool dense,
+                         AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), comm(comm_),
+    tag(comm_.get_free_tag()) {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    for (int k = 1; k < size; ++k) {
+      const int dst = (rank + k) % size;
+      const int src = (rank - k + size) % size;
+      if (send_counts[dst]) {
+        sends.push_back({dst, send_displs[dst], send_counts[dst]});
+      }
+      if (recv_counts[src]) {
+        recvs.push_back({src, recv_displs[src], recv_counts[src]});
+      }
+    }
+    self_send_offset = send_displs[rank];
+    self_recv_offset = recv_displs[rank];
+    self_count = send_counts[rank];
+    bytes = sum_counts(send_counts) * sizeof(T);
+    dense = dense || 100*(sends.size() + recvs.size())
+      > AL_MPI_ALLTOALLV_DENSE_PERCENT*2*static_cast<size_t>(size - 1);
+    recv_window = dense ? std::min<size_t>(AL_MPI_ALLTOALL_WINDOW, recvs.size())
+      : recvs.size();
+    recv_reqs.resize(recv_window, MPI_REQUEST_NULL);
+    // In place, data is received over data not yet sent, so send from a
+    // copy.
+    if (sendbuf == IN_PLACE<T>()) {
+      for (int i = 0; i < size; ++i) {
+        tmp_count = std::max(tmp_count, send_displs[i] + send_counts[i]);
+      }
+      tmp = mempool.allocate<MemoryType::HOST, T>(std::max<size_t>(tmp_count, 1));
+    }
+  }
+
+  ~SparseAlltoallvAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return "MPISparseAlltoallv"; }
+  size_t get_bytes() const override { return bytes; }
+
+protected:
+  void start_mpi_op() override {
+    if (tmp) {
+      std::copy_n(recvbuf, tmp_count, tmp);
+      sendbuf = tmp;
+    } else {
+      std::copy_n(sendbuf + self_send_offset, self_count,
+                  recvbuf + self_recv_offset);
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  /** A message to or from a peer. */
+  struct Message {
+    int peer;
+    size_t offset;
+    size_t count;
+  };
+
+  const T* sendbuf;
+  T* recvbuf;
+  MPICommunicator& comm;
+  int tag;
+  size_t bytes;
+  /** Where this rank's own block is and how large it is. */
+  size_t self_send_offset;
+  size_t self_recv_offset;
+  size_t self_count;
+  /** Nonempty messages to other ranks, in the order they are posted. */
+  std::vector<Message> sends;
+  std::vector<Message> recvs;
+  /** Maximum receives in flight. */
+  size_t recv_window;
+  MPI_Request send_reqs[AL_MPI_ALLTOALL_WINDOW];
+  std::vector<MPI_Request> recv_reqs;
+  /** Number of sends and receives started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+  /** Copy of the input when in place. */
+  T* tmp = nullptr;
+  size_t tmp_count = 0;
+};
+
+template <typename T>
+bool SparseAlltoallvAlState<T>::poll_mpi() {
+  constexpr size_t window = AL_MPI_ALLTOALL_WINDOW;
+  int flag;
+  while (recvs_done < recvs_started) {
+    MPI_Test(&recv_reqs[recvs_done % recv_window], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++recvs_done;
+  }
+  while (sends_done < sends_started) {
+    MPI_Test(&send_reqs[sends_done % window], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  while (recvs_started < recvs.size()
+         && recvs_started - recvs_done < recv_window) {
+    const Message& msg = recvs[recvs_started];
+    MPI_Irecv(recvbuf + msg.offset, msg.count, TypeMap<T>(), msg.peer, tag,
+              comm.get_comm(), &recv_reqs[recvs_started % recv_window]);
+    ++recvs_started;
+  }
+  while (sends_started < sends.size() && sends_started - sends_done < window) {
+    const Message& msg = sends[sends_started];
+    MPI_Isend(sendbuf + msg.offset, msg.count, TypeMap<T>(), msg.peer, tag,
+              comm.get_comm(), &send_reqs[sends_started % window]);
+    comm.count_send(msg.peer, msg.count*sizeof(T));
+    ++sends_started;
+  }
+  return sends_done == sends.size() && recvs_done == recvs.size();
+}
+
+template <typename T>
+void sparse_nb_alltoallv(const T* sendbuf,
+                         const std::vector<size_t>& send_counts,
+                         const std::vector<size_t>& send_displs,
+                         T* recvbuf,
+                         const std::vector<size_t>& recv_counts,
+                         const std::vector<size_t>& recv_displs,
+                         MPICommunicator& comm, bool dense, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::SparseAlltoallvAlState<T>* state =
+    new internal::mpi::SparseAlltoallvAlState<T>(
+      sendbuf, send_counts, send_displs,
+      recvbuf, recv_counts, recv_displs, comm, dense, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -46,7 +46,7 @@ public:
       : MPIState(req_), comm(comm_.get_comm()) {}
   ~BarrierAlState() override {}
 
-  std::string get_name() const override { return "MPIBarrier"; }
+  const char* get_name() const override { return "MPIBarrier"; }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/barrier.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/shm.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Barrier through shared memory on each node, with a dissemination
+ * barrier among node leaders (local rank 0).
+ *
+ * Ranks arrive by finishing a step of the node's shared-memory step
+ * counters, and the leader waits for all of them. Leaders then run a
+ * dissemination barrier: in round k, each sends an empty message to the
+ * leader 2^k after it and waits for one from the leader 2^k before it.
+ * Finally, the leader finishes another step, which releases the rest of
+ * its node. The counters only grow, so, unlike a sense-reversing flag,
+ * they never need to be reset between barriers.
+ *
+ * With one rank per node, every rank is a leader.
+ */
+class HierarchicalBarrierAlState : public MPIState {
+public:
+  HierarchicalBarrierAlState(MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    shm(comm_.get_node_shm()), tag(comm_.get_free_tag()),
+    is_leader(comm_.local_rank() == 0) {
+    if (!is_leader || comm_.local_size() == comm_.size()) {
+      return;
+    }
+    // Without node communicators, there is one rank per node.
+    leader_comm = comm_.get_node_comm()
+      ? comm_.get_node_comm()->get_cross_comm() : comm_.get_comm();
+    MPI_Comm_rank(leader_comm, &leader_rank);
+    MPI_Comm_size(leader_comm, &num_leaders);
+  }
+
+  ~HierarchicalBarrierAlState() override {}
+
+  const char* get_name() const override { return "MPIHierarchicalBarrier"; }
+
+protected:
+  void start_mpi_op() override {
+    if (shm) {
+      ticket = shm->take_ticket();
+    }
+  }
+
+  bool poll_mpi() override {
+    if (shm) {
+      if (!shm->is_turn(ticket)) {
+        return false;
+      }
+      if (!arrived) {
+        shm->finish_step();
+        arrived = true;
+      }
+      if (is_leader && !all_arrived) {
+        if (!shm->ready()) {
+          return false;
+        }
+        all_arrived = true;
+      }
+    }
+    if (is_leader && !disseminate()) {
+      return false;
+    }
+    if (shm) {
+      if (!is_leader && !shm->is_ahead(0)) {
+        return false;
+      }
+      shm->finish_step();
+      shm->release();
+    }
+    return true;
+  }
+
+private:
+  /** Advance the dissemination barrier; return true when done. */
+  bool disseminate() {
+    while (distance < num_leaders) {
+      if (!round_started) {
+        MPI_Irecv(nullptr, 0, MPI_BYTE,
+                  (leader_rank - distance + num_leaders) % num_leaders, tag,
+                  leader_comm, &reqs[0]);
+        MPI_Isend(nullptr, 0, MPI_BYTE, (leader_rank + distance) % num_leaders,
+                  tag, leader_comm, &reqs[1]);
+        round_started = true;
+      }
+      int flag;
+      MPI_Testall(2, reqs, &flag, MPI_STATUSES_IGNORE);
+      if (!flag) {
+        return false;
+      }
+      round_started = false;
+      distance *= 2;
+    }
+    return true;
+  }
+
+  /** Node shared memory, or null if this is the only rank on the node. */
+  NodeShm* shm;
+  int tag;
+  bool is_leader;
+  /** Communicator of leaders (null on one node or off leaders). */
+  MPI_Comm leader_comm = MPI_COMM_NULL;
+  int leader_rank = 0;
+  int num_leaders = 1;
+  uint64_t ticket = 0;
+  /** Whether this rank, and on the leader all local ranks, arrived. */
+  bool arrived = false;
+  bool all_arrived = false;
+  /** Distance of the current dissemination round. */
+  int distance = 1;
+  bool round_started = false;
+  MPI_Request reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+};
+
+/**
+ * Barrier through shared memory within nodes and dissemination among
+ * them, or pass through to MPI if shared memory is disabled.
+ */
+inline void hierarchical_nb_barrier(MPICommunicator& comm, AlMPIReq& req) {
+  if (AL_MPI_SHM_BYTES == 0) {
+    passthrough_nb_barrier(comm, req);
+    return;
+  }
+  req = get_free_request();
+  internal::mpi::HierarchicalBarrierAlState* state =
+    new internal::mpi::HierarchicalBarrierAlState(comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -53,7 +53,8 @@ public:
 
   ~BcastAlState() override {}
 
-  std::string get_name() const override { return "MPIBcast"; }
+  const char* get_name() const override { return "MPIBcast"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
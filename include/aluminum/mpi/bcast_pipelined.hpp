@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Broadcast by pipelining segments down a tree rooted at the root.
+ *
+ * Ranks, numbered relative to the root, form a complete tree where
+ * rank v has children fanout*v + 1, ..., fanout*v + fanout; a fanout of
+ * one is a chain. The buffer is split into segments of at most
+ * AL_MPI_BCAST_SEGMENT_BYTES, and each rank forwards a segment to its
+ * children as soon as it has received it, so transfers on different
+ * levels of the tree overlap. At most AL_MPI_BCAST_PIPELINE_DEPTH
+ * segments are in flight in each direction.
+ *
+ * Messages are matched by order, so all use the same tag.
+ */
+template <typename T>
+class PipelinedBcastAlState : public MPIState {
+public:
+  /** Maximum supported fanout. */
+  static constexpr int max_fanout = 2;
+
+  PipelinedBcastAlState(T* buf_, size_t count_, int root, int fanout,
+                        MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    buf(buf_), count(count_), comm(comm_), tag(comm_.get_free_tag()),
+    name(fanout == 1 ? "MPIPipelinedChainBcast" : "MPIBinaryTreeBcast") {
+    const int size = comm.size();
+    const int vrank = (comm.rank() - root + size) % size;
+    if (vrank != 0) {
+      parent = ((vrank - 1) / fanout + root) % size;
+    }
+    for (int i = 1; i <= fanout; ++i) {
+      const int child = fanout*vrank + i;
+      if (child < size) {
+        children[num_children++] = (child + root) % size;
+      }
+    }
+    seg_count = std::max<size_t>(AL_MPI_BCAST_SEGMENT_BYTES / sizeof(T), 1);
+    const size_t num_segs = (count + seg_count - 1) / seg_count;
+    num_recvs = parent >= 0 ? num_segs : 0;
+    num_sends = num_children > 0 ? num_segs : 0;
+    std::fill_n(send_reqs, AL_MPI_BCAST_PIPELINE_DEPTH*max_fanout,
+                MPI_REQUEST_NULL);
+  }
+
+  ~PipelinedBcastAlState() override {}
+
+  const char* get_name() const override { return name; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {}
+  bool poll_mpi() override;
+
+private:
+  /** Return a pointer to the start of segment seg. */
+  T* segment(size_t seg) const { return buf + seg*seg_count; }
+  /** Return the number of elements in segment seg. */
+  size_t segment_count(size_t seg) const {
+    return std::min(seg_count, count - seg*seg_count);
+  }
+
+  T* buf;
+  size_t count;
+  MPICommunicator& comm;
+  int tag;
+  const char* name;
+  /** Rank to receive from, or -1 on the root. */
+  int parent = -1;
+  /** Ranks to forward to. */
+  int children[max_fanout];
+  int num_children = 0;
+  /** Maximum elements in a segment. */
+  size_t seg_count;
+  /** Number of segments this rank receives and forwards. */
+  size_t num_recvs;
+  size_t num_sends;
+  MPI_Request recv_reqs[AL_MPI_BCAST_PIPELINE_DEPTH];
+  /** Requests for the sends of a segment to each child. */
+  MPI_Request send_reqs[AL_MPI_BCAST_PIPELINE_DEPTH*max_fanout];
+  /** Number of receives started and completed. */
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+  /** Number of segments whose sends were started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+};
+
+template <typename T>
+bool PipelinedBcastAlState<T>::poll_mpi() {
+  constexpr size_t depth = AL_MPI_BCAST_PIPELINE_DEPTH;
+  int flag;
+  // Complete receives in order.
+  while (recvs_done < recvs_started) {
+    MPI_Test(&recv_reqs[recvs_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++recvs_done;
+  }
+  // Complete sends in order.
+  while (sends_done < sends_started) {
+    MPI_Testall(num_children, &send_reqs[(sends_done % depth)*max_fanout],
+                &flag, MPI_STATUSES_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  // Forward segments once they have been received.
+  while (sends_started < num_sends && sends_started - sends_done < depth
+         && (parent < 0 || sends_started < recvs_done)) {
+    MPI_Request* reqs = &send_reqs[(sends_started % depth)*max_fanout];
+    const size_t seg_elems = segment_count(sends_started);
+    for (int i = 0; i < num_children; ++i) {
+      MPI_Isend(segment(sends_started), seg_elems, TypeMap<T>(), children[i],
+                tag, comm.get_comm(), &reqs[i]);
+      comm.count_send(children[i], seg_elems*sizeof(T));
+    }
+    ++sends_started;
+  }
+  // Receive segments directly into the buffer.
+  while (recvs_started < num_recvs && recvs_started - recvs_done < depth) {
+    MPI_Irecv(segment(recvs_started), segment_count(recvs_started),
+              TypeMap<T>(), parent, tag, comm.get_comm(),
+              &recv_reqs[recvs_started % depth]);
+    ++recvs_started;
+  }
+  return sends_done == num_sends && recvs_done == num_recvs;
+}
+
+/** Broadcast by pipelining segments down a chain of all ranks. */
+template <typename T>
+void pipelined_chain_nb_bcast(T* buf, size_t count, int root,
+                              MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::PipelinedBcastAlState<T>* state =
+    new internal::mpi::PipelinedBcastAlState<T>(
+      buf, count, root, 1, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+/** Broadcast by pipelining segments down a binary tree. */
+template <typename T>
+void binary_tree_nb_bcast(T* buf, size_t count, int root,
+                          MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::PipelinedBcastAlState<T>* state =
+    new internal::mpi::PipelinedBcastAlState<T>(
+      buf, count, root, 2, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
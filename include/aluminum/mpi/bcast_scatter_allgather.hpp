@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/schedule.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Broadcast by a scatter followed by an allgather (van de Geijn).
+ *
+ * The buffer is split into one chunk per rank. The root scatters the
+ * chunks with a binomial tree, then a ring allgather assembles them on
+ * every rank. Each rank sends about 2n bytes, rather than the n*log2(p)
+ * of a binomial tree broadcast, so this suits large messages.
+ */
+template <typename T>
+void scatter_allgather_nb_bcast(T* buf, size_t count, int root,
+                                MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIScatterAllgatherBcast", IN_PLACE<T>(), buf, count,
+    ReductionOperator::sum, comm, req);
+  const int size = comm.size();
+  const int vrank = (comm.rank() - root + size) % size;
+  auto real_rank = [&](int r) { return (r + root) % size; };
+  // Chunks are as even as possible and ordered by rank relative to the
+  // root, so every subtree of the scatter holds a contiguous range.
+  std::vector<size_t> displs(size + 1, 0);
+  for (int i = 0; i < size; ++i) {
+    displs[i + 1] = displs[i] + count / size
+      + (static_cast<size_t>(i) < count % size ? 1 : 0);
+  }
+  auto chunks = [&](int first, int last) {
+    last = std::min(last, size);
+    return std::make_pair(buf + displs[first], displs[last] - displs[first]);
+  };
+  // Scatter: receive this rank's subtree from its parent, then hand
+  // halves of it down, largest first.
+  int mask = 1;
+  while (mask < size) {
+    if (vrank & mask) {
+      ScheduleStep<T> step;
+      std::tie(step.recv_buf, step.recv_count) = chunks(vrank, vrank + mask);
+      step.recv_peer = real_rank(vrank - mask);
+      state->add_step(step);
+      break;
+    }
+    mask <<= 1;
+  }
+  for (mask >>= 1; mask > 0; mask >>= 1) {
+    if (vrank + mask < size) {
+      ScheduleStep<T> step;
+      const auto sub = chunks(vrank + mask, vrank + 2*mask);
+      step.send_buf = sub.first;
+      step.send_count = sub.second;
+      step.send_peer = real_rank(vrank + mask);
+      state->add_step(step);
+    }
+  }
+  // Allgather: pass chunks around the ring.
+  for (int k = 0; k < size - 1; ++k) {
+    ScheduleStep<T> step;
+    const int send_chunk = (vrank - k + size) % size;
+    const int recv_chunk = (vrank - k - 1 + size) % size;
+    std::tie(step.send_buf, step.send_count) = chunks(send_chunk, send_chunk + 1);
+    step.send_peer = real_rank((vrank + 1) % size);
+    std::tie(step.recv_buf, step.recv_count) = chunks(recv_chunk, recv_chunk + 1);
+    step.recv_peer = real_rank((vrank - 1 + size) % size);
+    state->add_step(step);
+  }
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/bcast.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/shm.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Broadcast among ranks on one node through shared memory.
+ *
+ * In rounds of up to the shared buffer size, the root copies its data
+ * into its shared buffer, then every other rank copies it out.
+ */
+template <typename T>
+class ShmBcastAlState : public MPIState {
+public:
+  ShmBcastAlState(T* buf_, size_t count_, int root_,
+                  MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    buf(buf_), count(count_), root(root_),
+    shm(*comm_.get_node_shm()),
+    // On a single node, local ranks are ranks.
+    is_root(comm_.local_rank() == root_),
+    round_count(shm.buffer_bytes() / sizeof(T)),
+    num_steps(2 * ((count + round_count - 1) / round_count)) {}
+
+  ~ShmBcastAlState() override {}
+
+  const char* get_name() const override { return "MPIShmBcast"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    ticket = shm.take_ticket();
+  }
+
+  bool poll_mpi() override {
+    if (!shm.is_turn(ticket)) {
+      return false;
+    }
+    for (; cur_step < num_steps; ++cur_step) {
+      if (!shm.ready()) {
+        return false;
+      }
+      const size_t offset = (cur_step / 2) * round_count;
+      const size_t n = std::min(round_count, count - offset);
+      if (cur_step % 2 == 0 && is_root) {
+        std::copy_n(buf + offset, n, shm.get_buffer<T>(root));
+      } else if (cur_step % 2 == 1 && !is_root) {
+        std::copy_n(shm.get_buffer<T>(root), n, buf + offset);
+      }
+      shm.finish_step();
+    }
+    shm.release();
+    return true;
+  }
+
+private:
+  T* buf;
+  size_t count;
+  int root;
+  NodeShm& shm;
+  bool is_root;
+  /** Elements in each round. */
+  size_t round_count;
+  size_t num_steps;
+  size_t cur_step = 0;
+  uint64_t ticket = 0;
+};
+
+/**
+ * Broadcast through shared memory if comm is on one node, otherwise
+ * pass through to MPI.
+ */
+template <typename T>
+void shm_nb_bcast(T* buf, size_t count, int root, MPICommunicator& comm,
+                  AlMPIReq& req) {
+  if (!comm.get_node_shm() || comm.local_size() != comm.size()
+      || comm.get_node_shm()->buffer_bytes() < sizeof(T)) {
+    passthrough_nb_bcast(buf, count, root, comm, req);
+    return;
+  }
+  req = get_free_request();
+  internal::mpi::ShmBcastAlState<T>* state =
+    new internal::mpi::ShmBcastAlState<T>(buf, count, root, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
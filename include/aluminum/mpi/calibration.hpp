@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mpi.h>
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * LogGP parameters of a link between two ranks, in seconds.
+ *
+ * L is the latency, o the overhead of sending or receiving a message, g
+ * the gap between consecutive messages, and G the gap per byte (inverse
+ * bandwidth).
+ */
+struct LinkModel {
+  double L = 0.0;
+  double o = 0.0;
+  double g = 0.0;
+  double G = 0.0;
+  /** Whether the link was measured. */
+  bool valid = false;
+
+  /** Return the time to send a message of bytes over the link. */
+  double time(double bytes) const {
+    return L + 2*o + (bytes > 1.0 ? (bytes - 1.0)*G : 0.0);
+  }
+};
+
+/** Models of the links between ranks on the same and different nodes. */
+struct NetworkModel {
+  LinkModel intra;
+  LinkModel inter;
+};
+
+/**
+ * Calibrate the network model, if AL_MPI_CALIBRATE is set to a non-zero
+ * value; collective over comm, and called at startup.
+ *
+ * This times ping-pongs and message streams between world rank 0 and a
+ * rank on its node and on another node, for at most
+ * AL_MPI_CALIBRATION_MS. Results are cached in a file keyed by the set
+ * of hostnames, in AL_MPI_CALIBRATION_DIR (default $HOME), so later runs
+ * on the same nodes skip the probes.
+ */
+void calibrate_network(MPI_Comm comm);
+
+/** Return the network model; links are invalid if not calibrated. */
+const NetworkModel& get_network_model();
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mpi.h>
+
+#include <Al_config.hpp>
+#include "aluminum/tuning_params.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/** Tag for acknowledging cross-memory attach transfers. */
+constexpr int cma_ack_tag = 3;
+
+/**
+ * Which peers of a communicator can be read with Linux cross-memory
+ * attach (process_vm_readv).
+ *
+ * Point-to-point messages of at least AL_MPI_CMA_THRESHOLD_BYTES to such
+ * peers send only the address of the buffer; the receiver then copies
+ * the data directly out of the sender's memory, and acknowledges this
+ * so the sender can complete. The send and receive counts must match.
+ */
+class CMAPeers {
+ public:
+  /** Set up for comm, whose ranks on this node are local_comm. */
+  CMAPeers(MPI_Comm comm, MPI_Comm local_comm);
+
+  /** Return true if a message of bytes to or from peer uses CMA. */
+  bool use_for(int peer, size_t bytes) const {
+    return bytes >= AL_MPI_CMA_THRESHOLD_BYTES && on_node[peer];
+  }
+
+ private:
+  /** Whether each rank in the communicator is on this node. */
+  std::vector<char> on_node;
+};
+
+/**
+ * Return CMA peers for comm, or null if CMA is not supported, disabled,
+ * or not permitted between ranks on this node.
+ *
+ * This is collective over local_comm.
+ */
+std::unique_ptr<CMAPeers> make_cma_peers(MPI_Comm comm, MPI_Comm local_comm,
+                                         int local_size);
+
+/** Check whether CMA is disabled (AL_MPI_CMA=0); called at startup. */
+void init_cma();
+
+/** Address of a buffer, sent in place of the data. */
+struct CMAControl {
+  int64_t pid;
+  uint64_t addr;
+  uint64_t bytes;
+};
+
+/** Send side of a cross-memory attach transfer. */
+class CMASend {
+ public:
+  /** Send the address of buf, and wait for the acknowledgement. */
+  void start(const void* buf, size_t bytes, int dest, MPI_Comm comm);
+  /** Return true once the receiver has copied the data. */
+  bool test();
+
+ private:
+  CMAControl ctrl;
+  MPI_Request reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+};
+
+/** Receive side of a cross-memory attach transfer. */
+class CMARecv {
+ public:
+  /** Receive the address of the data to copy into buf. */
+  void start(void* buf_, size_t bytes_, int src_, MPI_Comm comm_);
+  /** Copy the data once its address arrives; return true when done. */
+  bool test();
+
+ private:
+  void* buf;
+  size_t bytes;
+  int src;
+  MPI_Comm comm;
+  CMAControl ctrl;
+  MPI_Request req = MPI_REQUEST_NULL;
+  bool copied = false;
+};
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Bytes and messages sent to each peer of one communicator.
+ *
+ * These are only kept when communication matrix instrumentation is
+ * enabled (see comm_matrix_enabled()). Counts are updated with relaxed
+ * atomics, so they may be added from the progress engine and user
+ * threads concurrently.
+ */
+class PeerTraffic {
+ public:
+  /** Set up counters for comm, which has size ranks. */
+  PeerTraffic(MPI_Comm comm, int size);
+  PeerTraffic(const PeerTraffic&) = delete;
+  PeerTraffic& operator=(const PeerTraffic&) = delete;
+  /** Add the totals for this communicator to the retired totals. */
+  ~PeerTraffic();
+
+  /** Count one message of bytes sent to peer. */
+  void add_send(int peer, size_t bytes) {
+    sent_bytes[peer].fetch_add(bytes, std::memory_order_relaxed);
+    sent_messages[peer].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Add these counts to bytes and messages, indexed by world rank. */
+  void accumulate(std::vector<uint64_t>& bytes,
+                  std::vector<uint64_t>& messages) const;
+
+ private:
+  /** Rank in Aluminum's world communicator of each peer. */
+  std::vector<int> world_ranks;
+  std::unique_ptr<std::atomic<uint64_t>[]> sent_bytes;
+  std::unique_ptr<std::atomic<uint64_t>[]> sent_messages;
+};
+
+/**
+ * Return true if communication matrix instrumentation is enabled.
+ *
+ * This is set by the AL_COMM_MATRIX environment variable at
+ * initialization; only communicators created after that count traffic.
+ */
+bool comm_matrix_enabled();
+
+/**
+ * Gather the bytes and messages each rank has sent to each other rank
+ * to world rank 0, which writes them as matrices to filename.
+ *
+ * This includes traffic on all communicators, past and present, and is
+ * collective over Aluminum's world communicator.
+ */
+void write_comm_matrix(const std::string& filename);
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -27,8 +27,14 @@
 
 #pragma once
 
+#include <memory>
 #include <mpi.h>
 #include "aluminum/mpi_comm_and_stream_wrapper.hpp"
+#include "aluminum/mpi/algo_select.hpp"
+#include "aluminum/mpi/cma.hpp"
+#include "aluminum/mpi/comm_matrix.hpp"
+#include "aluminum/mpi/node_comm.hpp"
+#include "aluminum/mpi/shm.hpp"
 
 namespace Al {
 namespace internal {
@@ -56,7 +62,16 @@ class MPICommunicator : public MPICommAndStreamWrapper<int> {
    * The MPI backend currently ignores streams.
    */
   MPICommunicator(MPI_Comm comm_, int = 0) :
-    MPICommAndStreamWrapper<int>(comm_, 0) {}
+    MPICommAndStreamWrapper<int>(comm_, 0),
+    node_extents(get_node_extents(get_comm(), local_size())),
+    algo_selector(size(), node_extents.max_local_size),
+    node_comm(make_node_comm(get_comm(), size(), local_rank(), node_extents)),
+    node_shm(make_node_shm(get_local_comm(), local_rank(), local_size())),
+    cma_peers(make_cma_peers(get_comm(), get_local_comm(), local_size())) {
+    if (comm_matrix_enabled()) {
+      traffic = std::make_unique<PeerTraffic>(get_comm(), size());
+    }
+  }
   /** Cannot copy this. */
   MPICommunicator(const MPICommunicator& other) = delete;
   /** Default move constructor. */
@@ -72,6 +87,40 @@ class MPICommunicator : public MPICommAndStreamWrapper<int> {
     return MPICommunicator(get_comm(), stream);
   }
 
+  /**
+   * Count a message of bytes sent to peer, for the communication matrix.
+   *
+   * Algorithms should call this for every message they send, so the
+   * matrix reflects actual traffic. This does nothing unless the
+   * communication matrix is enabled.
+   */
+  void count_send(int peer, size_t bytes) const {
+    if (traffic) {
+      traffic->add_send(peer, bytes);
+    }
+  }
+
+  /** Return the algorithms to use when asked for automatic. */
+  const AlgoSelector& get_algo_selector() const { return algo_selector; }
+
+  /**
+   * Return the node communicators for hierarchical algorithms, or null
+   * if this communicator is on one node or has one rank per node.
+   */
+  const NodeComm* get_node_comm() const { return node_comm.get(); }
+
+  /**
+   * Return the shared-memory buffers of ranks on this node, or null if
+   * this is the only rank on the node.
+   */
+  NodeShm* get_node_shm() const { return node_shm.get(); }
+
+  /**
+   * Return which peers point-to-point messages may reach by cross-memory
+   * attach, or null if none.
+   */
+  const CMAPeers* get_cma_peers() const { return cma_peers.get(); }
+
   /**
    * Return the next free tag on this communicator.
    *
@@ -94,6 +143,18 @@ class MPICommunicator : public MPICommAndStreamWrapper<int> {
   static constexpr int starting_free_tag = 10;
   /** Free tag for communication. */
   int free_tag = starting_free_tag;
+  /** Smallest and largest number of ranks on a node. */
+  NodeExtents node_extents;
+  /** Algorithms chosen by the tuning table. */
+  AlgoSelector algo_selector;
+  /** Cached communicators for node-aware algorithms. */
+  std::unique_ptr<NodeComm> node_comm;
+  /** Shared-memory buffers for intra-node algorithms. */
+  std::unique_ptr<NodeShm> node_shm;
+  /** Peers reachable by cross-memory attach. */
+  std::unique_ptr<CMAPeers> cma_peers;
+  /** Per-peer traffic counters, if the communication matrix is enabled. */
+  std::unique_ptr<PeerTraffic> traffic;
 };
 
 } // namespace mpi
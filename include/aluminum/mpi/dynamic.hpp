@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Fill in packed displacements for out.counts and allocate its buffer.
+ *
+ * This uses out.allocator if present, otherwise the memory pool.
+ */
+template <typename T>
+void setup_dynamic_recv(DynamicRecvBuffer<T>& out) {
+  out.displs.resize(out.counts.size());
+  size_t total = 0;
+  for (size_t i = 0; i < out.counts.size(); ++i) {
+    out.displs[i] = total;
+    total += out.counts[i];
+  }
+  if (out.allocator) {
+    out.buffer = out.allocator(total);
+    out.deleter = nullptr;
+  } else {
+    out.buffer = mempool.allocate<MemoryType::HOST, T>(std::max<size_t>(total, 1));
+    out.deleter = [](T* ptr) { mempool.release<MemoryType::HOST>(ptr); };
+  }
+}
+
+/**
+ * Alltoallv where only the send counts are known.
+ *
+ * Send counts are exchanged with a nonblocking alltoall, while the
+ * payload is sent to every peer with data at the same time. Once the
+ * counts arrive, the receive buffer is allocated and receives posted,
+ * so the payload is only held up by the count exchange on the
+ * receiving side.
+ */
+template <typename T>
+class DynamicAlltoallvAlState : public MPIState {
+public:
+  DynamicAlltoallvAlState(const T* sendbuf_,
+                          const std::vector<size_t>& send_counts_,
+                          const std::vector<size_t>& send_displs_,
+                          DynamicRecvBuffer<T>& out_,
+                          MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), send_counts(send_counts_), send_displs(send_displs_),
+    out(out_), comm(comm_), tag(comm_.get_free_tag()),
+    bytes(sum_counts(send_counts_) * sizeof(T)) {
+    out.counts.assign(comm.size(), 0);
+  }
+
+  const char* get_name() const override { return "MPIDynamicAlltoallv"; }
+  size_t get_bytes() const override { return bytes; }
+
+protected:
+  void start_mpi_op() override {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    MPI_Ialltoall(send_counts.data(), 1, TypeMap<size_t>(),
+                  out.counts.data(), 1, TypeMap<size_t>(),
+                  comm.get_comm(), get_mpi_req());
+    for (int k = 1; k < size; ++k) {
+      const int dst = (rank + k) % size;
+      if (send_counts[dst]) {
+        reqs.push_back(MPI_REQUEST_NULL);
+        MPI_Isend(sendbuf + send_displs[dst], send_counts[dst], TypeMap<T>(),
+                  dst, tag, comm.get_comm(), &reqs.back());
+        comm.count_send(dst, send_counts[dst]*sizeof(T));
+      }
+    }
+  }
+
+  bool poll_mpi() override {
+    if (!counts_known) {
+      if (!MPIState::poll_mpi()) {
+        return false;
+      }
+      counts_known = true;
+      post_recvs();
+    }
+    int flag;
+    MPI_Testall(reqs.size(), reqs.data(), &flag, MPI_STATUSES_IGNORE);
+    return flag;
+  }
+
+private:
+  const T* sendbuf;
+  std::vector<size_t> send_counts;
+  std::vector<size_t> send_displs;
+  DynamicRecvBuffer<T>& out;
+  MPICommunicator& comm;
+  int tag;
+  size_t bytes;
+  /** Whether the count exchange has completed. */
+  bool counts_known = false;
+  /** Requests for the payload sends and receives. */
+  std::vector<MPI_Request> reqs;
+
+  /** Allocate the receive buffer and post receives for the payload. */
+  void post_recvs() {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    setup_dynamic_recv(out);
+    std::copy_n(sendbuf + send_displs[rank], send_counts[rank],
+                out.buffer + out.displs[rank]);
+    for (int k = 1; k < size; ++k) {
+      const int src = (rank - k + size) % size;
+      if (out.counts[src]) {
+        if (!check_count_fits_mpi(out.counts[src])) {
+          terminate_al("Message count too large for MPI");
+        }
+        reqs.push_back(MPI_REQUEST_NULL);
+        MPI_Irecv(out.buffer + out.displs[src], out.counts[src], TypeMap<T>(),
+                  src, tag, comm.get_comm(), &reqs.back());
+      }
+    }
+  }
+};
+
+/**
+ * Allgatherv where only the local count is known.
+ *
+ * Counts are exchanged with a nonblocking allgather, after which the
+ * receive buffer is allocated and the payload gathered with a
+ * nonblocking allgatherv, so the MPI library still chooses the
+ * algorithm for the data itself.
+ */
+template <typename T>
+class DynamicAllgathervAlState : public MPIState {
+public:
+  DynamicAllgathervAlState(const T* sendbuf_, size_t send_count_,
+                           DynamicRecvBuffer<T>& out_,
+                           MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), send_count(send_count_), out(out_), comm(comm_) {
+    out.counts.assign(comm.size(), 0);
+  }
+
+  const char* get_name() const override { return "MPIDynamicAllgatherv"; }
+  size_t get_bytes() const override { return send_count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    MPI_Iallgather(&send_count, 1, TypeMap<size_t>(),
+                   out.counts.data(), 1, TypeMap<size_t>(),
+                   comm.get_comm(), get_mpi_req());
+  }
+
+  bool poll_mpi() override {
+    if (!MPIState::poll_mpi()) {
+      return false;
+    }
+    if (counts_known) {
+      return true;
+    }
+    counts_known = true;
+    setup_dynamic_recv(out);
+    if (!check_count_fits_mpi(out.displs.back() + out.counts.back())) {
+      terminate_al("Message count too large for MPI");
+    }
+    int_counts = intify_size_t_vector(out.counts);
+    int_displs = intify_size_t_vector(out.displs);
+    MPI_Iallgatherv(sendbuf, send_count, TypeMap<T>(),
+                    out.buffer, int_counts.data(), int_displs.data(),
+                    TypeMap<T>(), comm.get_comm(), get_mpi_req());
+    return false;
+  }
+
+private:
+  const T* sendbuf;
+  size_t send_count;
+  DynamicRecvBuffer<T>& out;
+  MPICommunicator& comm;
+  /** Whether the count exchange has completed. */
+  bool counts_known = false;
+  /** Counts and displacements in the form MPI needs. */
+  std::vector<int> int_counts;
+  std::vector<int> int_displs;
+};
+
+template <typename T>
+void dynamic_nb_alltoallv(const T* sendbuf,
+                          const std::vector<size_t>& send_counts,
+                          const std::vector<size_t>& send_displs,
+                          DynamicRecvBuffer<T>& out,
+                          MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::DynamicAlltoallvAlState<T>* state =
+    new internal::mpi::DynamicAlltoallvAlState<T>(
+      sendbuf, send_counts, send_displs, out, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+template <typename T>
+void dynamic_nb_allgatherv(const T* sendbuf, size_t send_count,
+                           DynamicRecvBuffer<T>& out,
+                           MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::DynamicAllgathervAlState<T>* state =
+    new internal::mpi::DynamicAllgathervAlState<T>(
+      sendbuf, send_count, out, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
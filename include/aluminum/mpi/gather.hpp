@@ -58,7 +58,8 @@ public:
 
   ~GatherAlState() override {}
 
-  std::string get_name() const override { return "MPIGather"; }
+  const char* get_name() const override { return "MPIGather"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
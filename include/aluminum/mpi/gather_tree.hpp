@@ -0,0 +1,226 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/knomial_tree.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Gatherv up a k-nomial tree to the root.
+ *
+ * Each rank receives the packed blocks of its children's subtrees,
+ * then sends its whole subtree to its parent as one message. The root
+ * thus receives from only radix - 1 ranks per level of the tree. It
+ * receives directly into recvbuf when a subtree's blocks are laid out
+ * in order there, and otherwise unpacks them.
+ *
+ * This needs the counts of every rank on every rank.
+ */
+template <typename T>
+class TreeGathervAlState : public MPIState {
+public:
+  TreeGathervAlState(const T* sendbuf_, T* recvbuf_,
+                     const std::vector<size_t>& counts_,
+                     const std::vector<size_t>& displs_,
+                     int root_, int radix,
+                     MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), counts(counts_), displs(displs_),
+    root(root_), comm(comm_), tag(comm_.get_free_tag()),
+    name(radix == 2 ? "MPIBinomialGatherv" : "MPIKnomialGatherv"),
+    tree((comm_.rank() - root_ + comm_.size()) % comm_.size(), comm_.size(),
+         radix),
+    offsets(subtree_offsets(tree, counts_, root_)) {
+    if (tree.parent >= 0 && !check_count_fits_mpi(offsets.back())) {
+      throw_al_exception("Message count too large for MPI");
+    }
+    const bool is_root = tree.parent < 0;
+    for (const auto& child : tree.children) {
+      const bool packed = is_root
+        && subtree_is_packed(child, counts, displs, root);
+      direct.push_back(packed);
+      if (!packed) {
+        need_tmp = true;
+      }
+    }
+    if (need_tmp) {
+      tmp = mempool.allocate<MemoryType::HOST, T>(
+        std::max<size_t>(offsets.back(), 1));
+    }
+    recv_reqs.resize(tree.children.size(), MPI_REQUEST_NULL);
+  }
+
+  ~TreeGathervAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return name; }
+  size_t get_bytes() const override {
+    return counts[comm.rank()] * sizeof(T);
+  }
+
+protected:
+  void start_mpi_op() override;
+  bool poll_mpi() override;
+
+private:
+  /** Return the rank of a vrank. */
+  int to_rank(int vrank) const { return (vrank + root) % comm.size(); }
+
+  const T* sendbuf;
+  T* recvbuf;
+  std::vector<size_t> counts;
+  std::vector<size_t> displs;
+  int root;
+  MPICommunicator& comm;
+  int tag;
+  const char* name;
+  KnomialTree tree;
+  /** Offsets of each block of this rank's subtree when packed. */
+  std::vector<size_t> offsets;
+  /** Whether each child's subtree is received directly into recvbuf. */
+  std::vector<bool> direct;
+  bool need_tmp = false;
+  /** This rank's subtree, packed. */
+  T* tmp = nullptr;
+  std::vector<MPI_Request> recv_reqs;
+  /** Whether all children's subtrees have arrived. */
+  bool recvs_done = false;
+};
+
+template <typename T>
+void TreeGathervAlState<T>::start_mpi_op() {
+  const int rank = comm.rank();
+  const bool is_root = tree.parent < 0;
+  // Off the root, in-place data is in recvbuf.
+  if (sendbuf == IN_PLACE<T>() && !is_root) {
+    sendbuf = recvbuf;
+  }
+  for (size_t i = 0; i < tree.children.size(); ++i) {
+    const auto& child = tree.children[i];
+    const size_t offset = offsets[child.vrank - tree.vrank];
+    const size_t child_count =
+      offsets[child.vrank - tree.vrank + child.extent] - offset;
+    T* dst = direct[i] ? recvbuf + displs[to_rank(child.vrank)] : tmp + offset;
+    MPI_Irecv(dst, child_count, TypeMap<T>(), to_rank(child.vrank), tag,
+              comm.get_comm(), &recv_reqs[i]);
+  }
+  if (is_root) {
+    if (sendbuf != IN_PLACE<T>()) {
+      std::copy_n(sendbuf, counts[rank], recvbuf + displs[rank]);
+    }
+  } else if (tree.children.empty()) {
+    // Leaves send their block directly.
+    MPI_Isend(sendbuf, counts[rank], TypeMap<T>(), to_rank(tree.parent), tag,
+              comm.get_comm(), get_mpi_req());
+    comm.count_send(to_rank(tree.parent), counts[rank]*sizeof(T));
+  } else {
+    std::copy_n(sendbuf, counts[rank], tmp);
+  }
+}
+
+template <typename T>
+bool TreeGathervAlState<T>::poll_mpi() {
+  if (!recvs_done) {
+    int flag;
+    MPI_Testall(recv_reqs.size(), recv_reqs.data(), &flag,
+                MPI_STATUSES_IGNORE);
+    if (!flag) {
+      return false;
+    }
+    recvs_done = true;
+    if (tree.parent < 0) {
+      for (size_t i = 0; i < tree.children.size(); ++i) {
+        if (direct[i]) {
+          continue;
+        }
+        const auto& child = tree.children[i];
+        for (int v = child.vrank; v < child.vrank + child.extent; ++v) {
+          std::copy_n(tmp + offsets[v - tree.vrank], counts[to_rank(v)],
+                      recvbuf + displs[to_rank(v)]);
+        }
+      }
+      return true;
+    } else if (!tree.children.empty()) {
+      MPI_Isend(tmp, offsets.back(), TypeMap<T>(), to_rank(tree.parent), tag,
+                comm.get_comm(), get_mpi_req());
+      comm.count_send(to_rank(tree.parent), offsets.back()*sizeof(T));
+    }
+  }
+  return tree.parent < 0 || MPIState::poll_mpi();
+}
+
+/**
+ * Gatherv up a tree with the given radix (2 is binomial).
+ *
+ * Off the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void tree_nb_gatherv(const T* sendbuf, T* recvbuf,
+                     const std::vector<size_t>& counts,
+                     const std::vector<size_t>& displs,
+                     int root, int radix,
+                     MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::TreeGathervAlState<T>* state =
+    new internal::mpi::TreeGathervAlState<T>(
+      sendbuf, recvbuf, counts, displs, root, radix, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Gather up a tree with the given radix (2 is binomial).
+ *
+ * Off the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void tree_nb_gather(const T* sendbuf, T* recvbuf, size_t count,
+                    int root, int radix,
+                    MPICommunicator& comm, AlMPIReq& req) {
+  const std::vector<size_t> counts(comm.size(), count);
+  tree_nb_gatherv(sendbuf, recvbuf, counts,
+                  block_displs(comm.size(), count), root, radix, comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
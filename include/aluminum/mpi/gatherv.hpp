@@ -69,7 +69,8 @@ public:
 
   ~GathervAlState() override {}
 
-  std::string get_name() const override { return "MPIGatherv"; }
+  const char* get_name() const override { return "MPIGatherv"; }
+  size_t get_bytes() const override { return sum_counts(counts) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * One rank's place in a k-nomial tree.
+ *
+ * Ranks are numbered relative to the root (vrank = (rank - root) mod p).
+ * The parent of vrank clears its lowest nonzero base-radix digit, so
+ * with radix 2 this is a binomial tree. Every subtree covers a
+ * contiguous range of vranks starting at its root, which lets gathers
+ * and scatters move a whole subtree's data as one message.
+ */
+struct KnomialTree {
+  /** A child and the number of vranks in its subtree. */
+  struct Child {
+    int vrank;
+    int extent;
+  };
+
+  KnomialTree(int vrank_, int size, int radix) : vrank(vrank_) {
+    long mask = 1;
+    while (mask < size) {
+      const long digit = (vrank / mask) % radix;
+      if (digit) {
+        parent = static_cast<int>(vrank - digit*mask);
+        break;
+      }
+      mask *= radix;
+    }
+    extent = static_cast<int>(std::min<long>(mask, size - vrank));
+    // Children with the largest subtrees come first.
+    for (mask /= radix; mask >= 1; mask /= radix) {
+      for (int j = 1; j < radix; ++j) {
+        const long child = vrank + j*mask;
+        if (child >= vrank + extent) {
+          break;
+        }
+        children.push_back(
+          {static_cast<int>(child),
+           static_cast<int>(std::min<long>(mask, vrank + extent - child))});
+      }
+    }
+  }
+
+  /** This rank's vrank. */
+  int vrank;
+  /** The parent's vrank, or -1 on the root. */
+  int parent = -1;
+  /** Number of vranks in this rank's subtree, including itself. */
+  int extent;
+  /** Children, ordered by decreasing subtree size. */
+  std::vector<Child> children;
+};
+
+/**
+ * Return the offset of each vrank's block in tree's subtree when the
+ * blocks are packed in vrank order, followed by the total.
+ *
+ * counts are indexed by rank.
+ */
+inline std::vector<size_t> subtree_offsets(const KnomialTree& tree,
+                                           const std::vector<size_t>& counts,
+                                           int root) {
+  const int size = static_cast<int>(counts.size());
+  std::vector<size_t> offsets(tree.extent + 1);
+  offsets[0] = 0;
+  for (int i = 0; i < tree.extent; ++i) {
+    offsets[i + 1] = offsets[i] + counts[(tree.vrank + i + root) % size];
+  }
+  return offsets;
+}
+
+/**
+ * Return whether the blocks of a child's subtree are already packed in
+ * vrank order at displs, so they can be sent or received in place.
+ */
+inline bool subtree_is_packed(const KnomialTree::Child& child,
+                              const std::vector<size_t>& counts,
+                              const std::vector<size_t>& displs, int root) {
+  const int size = static_cast<int>(counts.size());
+  const int first = (child.vrank + root) % size;
+  if (first + child.extent > size) {
+    return false;
+  }
+  for (int r = first; r < first + child.extent - 1; ++r) {
+    if (displs[r] + counts[r] != displs[r + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -32,6 +32,7 @@
 #include "aluminum/progress.hpp"
 #include "aluminum/mpi/base_state.hpp"
 #include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/pt2pt.hpp"
 #include "aluminum/mpi/utils.hpp"
 #include "aluminum/utils/caching_allocator.hpp"
 #include "aluminum/mempool.hpp"
@@ -57,6 +58,30 @@ void passthrough_multisendrecv(std::vector<const T*> send_buffers,
   }
   std::vector<int> send_counts = intify_size_t_vector(send_counts_);
   std::vector<int> recv_counts = intify_size_t_vector(recv_counts_);
+  if (const CMAPeers* cma = comm.get_cma_peers()) {
+    // Some messages may use cross-memory attach.
+    std::vector<PeerRecv<T>> recvs(recv_buffers.size());
+    std::vector<PeerSend<T>> sends(send_buffers.size());
+    for (size_t i = 0; i < recv_buffers.size(); ++i) {
+      recvs[i].start(recv_buffers[i], recv_counts[i], srcs[i],
+                     comm.get_comm(), cma);
+    }
+    for (size_t i = 0; i < send_buffers.size(); ++i) {
+      sends[i].start(send_buffers[i], send_counts[i], dests[i],
+                     comm.get_comm(), cma);
+    }
+    bool done = false;
+    while (!done) {
+      done = true;
+      for (auto& recv : recvs) {
+        done = recv.test() && done;
+      }
+      for (auto& send : sends) {
+        done = send.test() && done;
+      }
+    }
+    return;
+  }
   std::vector<MPI_Request> reqs(send_buffers.size() + recv_buffers.size());
   for (size_t i = 0; i < recv_buffers.size(); ++i) {
     MPI_Irecv(recv_buffers[i], recv_counts[i], TypeMap<T>(), srcs[i],
@@ -114,7 +139,9 @@ public:
     recv_counts(intify_size_t_vector(recv_counts_)),
     srcs(std::move(srcs_)),
     comm(comm_.get_comm()),
-    mpi_reqs(send_buffers.size() + recv_buffers.size())
+    cma(comm_.get_cma_peers()),
+    recvs(recv_buffers.size()),
+    sends(send_buffers.size())
   {}
 
   // In-place version which sets up necessary buffers/etc.
@@ -132,7 +159,9 @@ public:
     recv_counts(intify_size_t_vector(counts)),
     srcs(std::move(srcs_)),
     comm(comm_.get_comm()),
-    mpi_reqs(send_buffers.size() + recv_buffers.size()) {
+    cma(comm_.get_cma_peers()),
+    recvs(recv_buffers.size()),
+    sends(send_buffers.size()) {
     // Allocate space and set up pointers but do not copy.
     size_t total_size = std::accumulate(counts.begin(), counts.end(), size_t{0});
     tmp_buf = internal::mempool.allocate<internal::MemoryType::HOST, T>(total_size);
@@ -150,7 +179,8 @@ public:
   }
 
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "MPIMultiSendRecv"; }
+  const char* get_name() const override { return "MPIMultiSendRecv"; }
+  size_t get_bytes() const override { return (sum_counts(send_counts) + sum_counts(recv_counts)) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -163,19 +193,22 @@ protected:
       }
     }
     for (size_t i = 0; i < recv_buffers.size(); ++i) {
-      MPI_Irecv(recv_buffers[i], recv_counts[i], TypeMap<T>(), srcs[i],
-                pt2pt_tag, comm, &mpi_reqs[i]);
+      recvs[i].start(recv_buffers[i], recv_counts[i], srcs[i], comm, cma);
     }
     for (size_t i = 0; i < send_buffers.size(); ++i) {
-      MPI_Isend(send_buffers[i], send_counts[i], TypeMap<T>(), dests[i],
-                pt2pt_tag, comm, &mpi_reqs[recv_buffers.size() + i]);
+      sends[i].start(send_buffers[i], send_counts[i], dests[i], comm, cma);
     }
   }
 
   bool poll_mpi() override {
-    int flag;
-    MPI_Testall(mpi_reqs.size(), mpi_reqs.data(), &flag, MPI_STATUSES_IGNORE);
-    return flag;
+    bool done = true;
+    for (auto& recv : recvs) {
+      done = recv.test() && done;
+    }
+    for (auto& send : sends) {
+      done = send.test() && done;
+    }
+    return done;
   }
 
 private:
@@ -186,7 +219,9 @@ private:
   std::vector<int> recv_counts;
   std::vector<int> srcs;
   MPI_Comm comm;
-  std::vector<MPI_Request> mpi_reqs;
+  const CMAPeers* cma;
+  std::vector<PeerRecv<T>> recvs;
+  std::vector<PeerSend<T>> sends;
   T* tmp_buf = nullptr;
 };
 
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+
+#include <mpi.h>
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Communicators for node-aware (hierarchical) algorithms.
+ *
+ * The cross-node communicator connects the ranks that have the same
+ * local rank on each node. For local rank 0, this is the communicator
+ * of node leaders.
+ */
+class NodeComm {
+ public:
+  /** Split comm by local_rank; uniform is whether all nodes are equal. */
+  NodeComm(MPI_Comm comm, int local_rank, bool uniform_);
+  NodeComm(const NodeComm&) = delete;
+  NodeComm& operator=(const NodeComm&) = delete;
+  ~NodeComm();
+
+  /** Return the communicator of ranks with this local rank. */
+  MPI_Comm get_cross_comm() const { return cross_comm; }
+  /** Return true if every node has the same number of ranks. */
+  bool is_uniform() const { return uniform; }
+
+ private:
+  MPI_Comm cross_comm = MPI_COMM_NULL;
+  bool uniform;
+};
+
+/** Smallest and largest number of ranks of a communicator on a node. */
+struct NodeExtents {
+  int min_local_size;
+  int max_local_size;
+};
+
+/** Return the node extents of comm; collective over comm. */
+NodeExtents get_node_extents(MPI_Comm comm, int local_size);
+
+/**
+ * Create node communicators for comm.
+ *
+ * This is collective over comm. It returns null when there is no
+ * hierarchy to exploit, i.e. comm is on a single node or has one rank
+ * per node.
+ */
+std::unique_ptr<NodeComm> make_node_comm(MPI_Comm comm, int size,
+                                         int local_rank,
+                                         const NodeExtents& extents);
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -29,6 +29,7 @@
 
 #include "aluminum/progress.hpp"
 #include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/cma.hpp"
 #include "aluminum/mpi/communicator.hpp"
 #include "aluminum/mpi/utils.hpp"
 #include "aluminum/utils/caching_allocator.hpp"
@@ -40,9 +41,78 @@ namespace Al {
 namespace internal {
 namespace mpi {
 
+/**
+ * A point-to-point send using MPI or, when cma says so, cross-memory
+ * attach.
+ */
+template <typename T>
+class PeerSend {
+ public:
+  void start(const T* buf, size_t count, int dest, MPI_Comm comm,
+             const CMAPeers* cma) {
+    use_cma = cma && cma->use_for(dest, count*sizeof(T));
+    if (use_cma) {
+      cma_send.start(buf, count*sizeof(T), dest, comm);
+    } else {
+      MPI_Isend(buf, count, TypeMap<T>(), dest, pt2pt_tag, comm, &req);
+    }
+  }
+  bool test() {
+    if (use_cma) {
+      return cma_send.test();
+    }
+    int flag;
+    MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+    return flag;
+  }
+
+ private:
+  bool use_cma = false;
+  CMASend cma_send;
+  MPI_Request req = MPI_REQUEST_NULL;
+};
+
+/**
+ * A point-to-point receive using MPI or, when cma says so, cross-memory
+ * attach.
+ */
+template <typename T>
+class PeerRecv {
+ public:
+  void start(T* buf, size_t count, int src, MPI_Comm comm,
+             const CMAPeers* cma) {
+    use_cma = cma && cma->use_for(src, count*sizeof(T));
+    if (use_cma) {
+      cma_recv.start(buf, count*sizeof(T), src, comm);
+    } else {
+      MPI_Irecv(buf, count, TypeMap<T>(), src, pt2pt_tag, comm, &req);
+    }
+  }
+  bool test() {
+    if (use_cma) {
+      return cma_recv.test();
+    }
+    int flag;
+    MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+    return flag;
+  }
+
+ private:
+  bool use_cma = false;
+  CMARecv cma_recv;
+  MPI_Request req = MPI_REQUEST_NULL;
+};
+
 template <typename T>
 void passthrough_send(const T* sendbuf, size_t count, int dest,
                       MPICommunicator& comm) {
+  const CMAPeers* cma = comm.get_cma_peers();
+  if (cma && cma->use_for(dest, count*sizeof(T))) {
+    PeerSend<T> send;
+    send.start(sendbuf, count, dest, comm.get_comm(), cma);
+    while (!send.test()) {}
+    return;
+  }
   MPI_Send(sendbuf, count, TypeMap<T>(), dest, pt2pt_tag, comm.get_comm());
 }
 
@@ -54,16 +124,21 @@ class SendAlState : public MPIState {
               MPICommunicator& comm_, AlMPIReq req_) :
     MPIState(req_),
     sendbuf(sendbuf_), count(count_), dest(dest_),
-    comm(comm_.get_comm()) {}
+    comm(comm_.get_comm()), cma(comm_.get_cma_peers()) {}
 
   ~SendAlState() override {}
 
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "MPISend"; }
+  const char* get_name() const override { return "MPISend"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
-    MPI_Isend(sendbuf, count, TypeMap<T>(), dest, pt2pt_tag, comm, get_mpi_req());
+    send.start(sendbuf, count, dest, comm, cma);
+  }
+
+  bool poll_mpi() override {
+    return send.test();
   }
 
  private:
@@ -71,6 +146,8 @@ protected:
   size_t count;
   int dest;
   MPI_Comm comm;
+  const CMAPeers* cma;
+  PeerSend<T> send;
 };
 
 template <typename T>
@@ -86,6 +163,13 @@ void passthrough_nb_send(const T* sendbuf, size_t count, int dest,
 template <typename T>
 void passthrough_recv(T* recvbuf, size_t count, int src,
                       MPICommunicator& comm) {
+  const CMAPeers* cma = comm.get_cma_peers();
+  if (cma && cma->use_for(src, count*sizeof(T))) {
+    PeerRecv<T> recv;
+    recv.start(recvbuf, count, src, comm.get_comm(), cma);
+    while (!recv.test()) {}
+    return;
+  }
   MPI_Recv(recvbuf, count, TypeMap<T>(), src, pt2pt_tag, comm.get_comm(),
            MPI_STATUS_IGNORE);
 }
@@ -97,16 +181,21 @@ class RecvAlState : public MPIState {
               MPICommunicator& comm_, AlMPIReq req_) :
     MPIState(req_),
     recvbuf(recvbuf_), count(count_), src(src_),
-    comm(comm_.get_comm()) {}
+    comm(comm_.get_comm()), cma(comm_.get_cma_peers()) {}
 
   ~RecvAlState() override {}
 
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "MPIRecv"; }
+  const char* get_name() const override { return "MPIRecv"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
-    MPI_Irecv(recvbuf, count, mpi::TypeMap<T>(), src, pt2pt_tag, comm, get_mpi_req());
+    recv.start(recvbuf, count, src, comm, cma);
+  }
+
+  bool poll_mpi() override {
+    return recv.test();
   }
 
  private:
@@ -114,6 +203,8 @@ protected:
   size_t count;
   int src;
   MPI_Comm comm;
+  const CMAPeers* cma;
+  PeerRecv<T> recv;
 };
 
 template <typename T>
@@ -130,6 +221,32 @@ template <typename T>
 void passthrough_sendrecv(const T* sendbuf, size_t send_count, int dest,
                           T* recvbuf, size_t recv_count, int src,
                           MPICommunicator& comm) {
+  if (const CMAPeers* cma = comm.get_cma_peers();
+      cma && (cma->use_for(dest, send_count*sizeof(T))
+              || cma->use_for(src, recv_count*sizeof(T)))) {
+    T* tmp_buf = nullptr;
+    if (sendbuf == internal::IN_PLACE<T>()) {
+      tmp_buf = internal::mempool.allocate<internal::MemoryType::HOST, T>(
+        recv_count);
+      std::copy_n(recvbuf, recv_count, tmp_buf);
+      sendbuf = tmp_buf;
+      send_count = recv_count;
+    }
+    PeerRecv<T> recv;
+    PeerSend<T> send;
+    recv.start(recvbuf, recv_count, src, comm.get_comm(), cma);
+    send.start(sendbuf, send_count, dest, comm.get_comm(), cma);
+    bool recv_done = false;
+    bool send_done = false;
+    while (!recv_done || !send_done) {
+      recv_done = recv.test();
+      send_done = send.test();
+    }
+    if (tmp_buf) {
+      internal::mempool.release<internal::MemoryType::HOST>(tmp_buf);
+    }
+    return;
+  }
   if (sendbuf == internal::IN_PLACE<T>()) {
     MPI_Sendrecv_replace(recvbuf, recv_count, TypeMap<T>(), dest, pt2pt_tag,
                          src, pt2pt_tag, comm.get_comm(), MPI_STATUS_IGNORE);
@@ -149,7 +266,7 @@ class SendRecvAlState : public MPIState {
     MPIState(req_),
     sendbuf(sendbuf_), send_count(send_count_), dest(dest_),
     recvbuf(recvbuf_), recv_count(recv_count_), src(src_),
-    comm(comm_.get_comm()), tmp_buf(nullptr) {
+    comm(comm_.get_comm()), cma(comm_.get_cma_peers()), tmp_buf(nullptr) {
     if (sendbuf == internal::IN_PLACE<T>()) {
       tmp_buf = internal::mempool.allocate<internal::MemoryType::HOST, T>(
         recv_count);
@@ -164,7 +281,8 @@ class SendRecvAlState : public MPIState {
   }
 
   RunType get_run_type() const override { return RunType::unbounded; }
-  std::string get_name() const override { return "MPISendRecv"; }
+  const char* get_name() const override { return "MPISendRecv"; }
+  size_t get_bytes() const override { return (send_count + recv_count) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -173,22 +291,18 @@ protected:
     if (sendbuf == internal::IN_PLACE<T>()) {
       // Copy the send buffer to the temporary buffer.
       std::copy_n(recvbuf, recv_count, tmp_buf);
-      MPI_Irecv(recvbuf, recv_count, TypeMap<T>(), src, pt2pt_tag, comm,
-                &mpi_reqs[0]);
-      MPI_Isend(tmp_buf, recv_count, TypeMap<T>(), dest, pt2pt_tag, comm,
-                &mpi_reqs[1]);
+      recv.start(recvbuf, recv_count, src, comm, cma);
+      send.start(tmp_buf, recv_count, dest, comm, cma);
     } else {
-      MPI_Irecv(recvbuf, recv_count, TypeMap<T>(), src, pt2pt_tag, comm,
-                &mpi_reqs[0]);
-      MPI_Isend(sendbuf, send_count, TypeMap<T>(), dest, pt2pt_tag, comm,
-                &mpi_reqs[1]);
+      recv.start(recvbuf, recv_count, src, comm, cma);
+      send.start(sendbuf, send_count, dest, comm, cma);
     }
   }
 
   bool poll_mpi() override {
-    int flag;
-    MPI_Testall(2, mpi_reqs, &flag, MPI_STATUSES_IGNORE);
-    return flag;
+    const bool recv_done = recv.test();
+    const bool send_done = send.test();
+    return recv_done && send_done;
   }
 
  private:
@@ -199,7 +313,9 @@ protected:
   size_t recv_count;
   int src;
   MPI_Comm comm;
-  MPI_Request mpi_reqs[2];
+  const CMAPeers* cma;
+  PeerRecv<T> recv;
+  PeerSend<T> send;
   T* tmp_buf;
 };
 
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include <mpi.h>
+
+#include "aluminum/stats.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Set up sampling of the MPI_T performance variables listed (separated
+ * by commas) in the AL_MPI_T_PVARS environment variable, if any.
+ *
+ * Variables bound to a communicator are bound to comm. Variables that
+ * do not exist or cannot be read are skipped with a warning.
+ */
+void init_pvars(MPI_Comm comm);
+/** Stop sampling performance variables and clean up MPI_T. */
+void finalize_pvars();
+
+/** Return true if any performance variables are being sampled. */
+bool pvars_enabled();
+
+/**
+ * Sample all performance variables, if it has been at least
+ * AL_MPI_T_SAMPLE_INTERVAL_USEC since the last sample.
+ *
+ * This is called periodically by the progress engine.
+ */
+void sample_pvars();
+
+/** Write a human-readable summary of performance variable stats to os. */
+std::ostream& write_pvar_stats(std::ostream& os,
+                               const std::vector<MPIPvarStats>& stats);
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
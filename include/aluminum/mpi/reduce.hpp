@@ -59,7 +59,8 @@ public:
 
   ~ReduceAlState() override {}
 
-  std::string get_name() const override { return "MPIReduce"; }
+  const char* get_name() const override { return "MPIReduce"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
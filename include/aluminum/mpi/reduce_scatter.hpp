@@ -57,7 +57,8 @@ public:
 
   ~ReduceScatterAlState() override {}
 
-  std::string get_name() const override { return "MPIReduceScatter"; }
+  const char* get_name() const override { return "MPIReduceScatter"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/schedule.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Reduce-scatter by recursive halving.
+ *
+ * In each of log2(p) steps, ranks exchange half of the data they are
+ * still responsible for with a partner at halving distance and reduce,
+ * so each rank sends about n bytes in few messages, as in MPICH. Chunk
+ * sizes are given by counts, so this also implements reduce-scatterv.
+ * Non-power-of-two sizes are folded first, and each extra rank is sent
+ * its chunk at the end.
+ *
+ * If sendbuf is IN_PLACE, recvbuf holds the input for every rank and
+ * the result is left at its start.
+ */
+template <typename T>
+void recursive_halving_nb_reduce_scatterv(const T* sendbuf, T* recvbuf,
+                                          const std::vector<size_t>& counts,
+                                          ReductionOperator op,
+                                          MPICommunicator& comm,
+                                          AlMPIReq& req) {
+  const int size = comm.size();
+  const int rank = comm.rank();
+  std::vector<size_t> displs(size + 1, 0);
+  for (int i = 0; i < size; ++i) {
+    displs[i + 1] = displs[i] + counts[i];
+  }
+  const size_t total = displs[size];
+  req = get_free_request();
+  ScheduleAlState<T>* state = new ScheduleAlState<T>(
+    "MPIRecursiveHalvingReduceScatter", IN_PLACE<T>(), recvbuf, total, op,
+    comm, req);
+  // The fold also uses the first temporary buffer for receiving.
+  T* work;
+  T* tmp;
+  if (sendbuf == IN_PLACE<T>()) {
+    work = recvbuf;
+    tmp = state->get_tmp(total);
+  } else {
+    tmp = state->get_tmp(2*total);
+    work = tmp + total;
+    ScheduleStep<T> step;
+    step.copy_from = sendbuf;
+    step.copy_to = work;
+    step.copy_count = total;
+    state->add_step(step);
+  }
+  PowerOfTwoFold fold = add_fold_in_steps(*state, work, total, comm);
+  if (!fold.is_extra()) {
+    // Block i of the power-of-two part is the chunk of rank real_rank(i),
+    // preceded by that of the extra rank it stands in for, if any.
+    std::vector<size_t> block_displs(fold.pof2 + 1, total);
+    for (int i = 0; i < fold.pof2; ++i) {
+      block_displs[i] = displs[i < fold.rem ? 2*i : i + fold.rem];
+    }
+    int lo = 0;
+    for (int mask = fold.pof2 / 2; mask > 0; mask >>= 1) {
+      // Keep the half of [lo, lo + 2*mask) containing this rank's block.
+      const int keep = (fold.newrank & mask) ? lo + mask : lo;
+      const int give = (fold.newrank & mask) ? lo : lo + mask;
+      const int peer = fold.real_rank(fold.newrank ^ mask);
+      ScheduleStep<T> step;
+      step.send_buf = work + block_displs[give];
+      step.send_count = block_displs[give + mask] - block_displs[give];
+      step.send_peer = peer;
+      step.recv_buf = tmp + block_displs[keep];
+      step.recv_count = block_displs[keep + mask] - block_displs[keep];
+      step.recv_peer = peer;
+      step.reduce_into = work + block_displs[keep];
+      state->add_step(step);
+      lo = keep;
+    }
+  }
+  if (fold.is_extra()) {
+    ScheduleStep<T> step;
+    step.recv_buf = recvbuf;
+    step.recv_count = counts[rank];
+    step.recv_peer = rank + 1;
+    state->add_step(step);
+  } else {
+    if (fold.has_extra()) {
+      ScheduleStep<T> step;
+      step.send_buf = work + displs[rank - 1];
+      step.send_count = counts[rank - 1];
+      step.send_peer = rank - 1;
+      state->add_step(step);
+    }
+    // In place, the chunk moves towards the start of the buffer, so
+    // copying forward is safe once the extra rank's chunk is sent.
+    ScheduleStep<T> step;
+    step.copy_from = work + displs[rank];
+    step.copy_to = recvbuf;
+    step.copy_count = counts[rank];
+    state->add_step(step);
+  }
+  get_progress_engine()->enqueue(state);
+}
+
+template <typename T>
+void recursive_halving_nb_reduce_scatter(const T* sendbuf, T* recvbuf,
+                                         size_t count, ReductionOperator op,
+                                         MPICommunicator& comm,
+                                         AlMPIReq& req) {
+  recursive_halving_nb_reduce_scatterv(
+    sendbuf, recvbuf, std::vector<size_t>(comm.size(), count), op, comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Reduce-scatter with a pipelined ring.
+ *
+ * In each of p-1 steps, every rank sends one chunk to its successor and
+ * receives one from its predecessor, which it reduces and forwards in
+ * the next step; the last chunk a rank receives is its own, fully
+ * reduced. Chunk sizes are given by counts, so this also implements
+ * reduce-scatterv. As with the ring allreduce, chunks are split into
+ * segments of at most AL_MPI_RING_SEGMENT_BYTES, each forwarded as soon
+ * as it has been reduced, with at most AL_MPI_RING_PIPELINE_DEPTH in
+ * flight in each direction.
+ *
+ * If sendbuf is IN_PLACE, recvbuf holds the input for every rank and
+ * the result is left at its start.
+ */
+template <typename T>
+class RingReduceScatterAlState : public MPIState {
+public:
+  RingReduceScatterAlState(const T* sendbuf_, T* recvbuf_,
+                           const std::vector<size_t>& counts,
+                           ReductionOperator op_, MPICommunicator& comm_,
+                           AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), op(op_), comm(comm_),
+    tag(comm_.get_free_tag()) {
+    const int rank = comm.rank();
+    const int size = comm.size();
+    next = (rank + 1) % size;
+    prev = (rank + size - 1) % size;
+    std::vector<size_t> displs(size + 1, 0);
+    for (int i = 0; i < size; ++i) {
+      displs[i + 1] = displs[i] + counts[i];
+    }
+    total = displs[size];
+    result_offset = displs[rank];
+    result_count = counts[rank];
+    // Segments need be no larger than a chunk.
+    seg_count = std::max<size_t>(
+      std::min<size_t>(AL_MPI_RING_SEGMENT_BYTES / sizeof(T),
+                       *std::max_element(counts.begin(), counts.end())), 1);
+    auto chunk_segments = [&](int chunk, std::vector<Segment>& segs) {
+      for (size_t off = 0; off < counts[chunk]; off += seg_count) {
+        segs.push_back({displs[chunk] + off,
+                        std::min(seg_count, counts[chunk] - off)});
+      }
+    };
+    if (size > 1) {
+      chunk_segments(prev, first_sends);
+    }
+    // Step k receives chunk rank-k-2 and forwards it in step k+1, except
+    // in the last step, which receives this rank's chunk.
+    num_sends = first_sends.size();
+    for (int k = 0; k < size - 1; ++k) {
+      if (k == size - 2) {
+        num_sends += recvs.size();
+      }
+      chunk_segments((rank - k - 2 + 2*size) % size, recvs);
+    }
+    if (sendbuf == IN_PLACE<T>()) {
+      work = recvbuf;
+    } else {
+      work = mempool.allocate<MemoryType::HOST, T>(std::max<size_t>(total, 1));
+    }
+    tmp = mempool.allocate<MemoryType::HOST, T>(
+      AL_MPI_RING_PIPELINE_DEPTH * seg_count);
+  }
+
+  ~RingReduceScatterAlState() override {
+    if (work != recvbuf) {
+      mempool.release<MemoryType::HOST>(work);
+    }
+    mempool.release<MemoryType::HOST>(tmp);
+  }
+
+  const char* get_name() const override { return "MPIRingReduceScatter"; }
+  size_t get_bytes() const override { return total * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    if (work != recvbuf) {
+      std::copy_n(sendbuf, total, work);
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  /** A contiguous piece of the buffer sent in one message. */
+  struct Segment {
+    size_t offset;
+    size_t count;
+  };
+
+  const T* sendbuf;
+  T* recvbuf;
+  ReductionOperator op;
+  MPICommunicator& comm;
+  int tag;
+  int next;
+  int prev;
+  /** Total elements in the input. */
+  size_t total;
+  /** Location and size of this rank's chunk. */
+  size_t result_offset;
+  size_t result_count;
+  /** Maximum elements in a segment. */
+  size_t seg_count;
+  /** Segments sent before anything has been received. */
+  std::vector<Segment> first_sends;
+  /** Segments received, in order; all but the last chunk are forwarded. */
+  std::vector<Segment> recvs;
+  /** Total number of sends. */
+  size_t num_sends;
+  /** Buffer reduced into, holding every rank's chunk. */
+  T* work = nullptr;
+  /** Buffers for segments being received for reduction. */
+  T* tmp = nullptr;
+  MPI_Request send_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  MPI_Request recv_reqs[AL_MPI_RING_PIPELINE_DEPTH];
+  /** Number of sends started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+  /** Number of receives started and completed (and reduced). */
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+};
+
+template <typename T>
+bool RingReduceScatterAlState<T>::poll_mpi() {
+  constexpr size_t depth = AL_MPI_RING_PIPELINE_DEPTH;
+  int flag;
+  // Complete receives in order, reducing them into the buffer.
+  while (recvs_done < recvs_started) {
+    MPI_Test(&recv_reqs[recvs_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    const Segment& seg = recvs[recvs_done];
+    reduce_local(tmp + (recvs_done % depth)*seg_count, work + seg.offset,
+                 seg.count, op);
+    ++recvs_done;
+  }
+  // Complete sends in order.
+  while (sends_done < sends_started) {
+    MPI_Test(&send_reqs[sends_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  // Forward segments once they have been reduced.
+  while (sends_started < num_sends && sends_started - sends_done < depth
+         && (sends_started < first_sends.size()
+             || sends_started - first_sends.size() < recvs_done)) {
+    const Segment& seg = sends_started < first_sends.size()
+      ? first_sends[sends_started] : recvs[sends_started - first_sends.size()];
+    MPI_Isend(work + seg.offset, seg.count, TypeMap<T>(), next, tag,
+              comm.get_comm(), &send_reqs[sends_started % depth]);
+    comm.count_send(next, seg.count*sizeof(T));
+    ++sends_started;
+  }
+  while (recvs_started < recvs.size() && recvs_started - recvs_done < depth) {
+    const Segment& seg = recvs[recvs_started];
+    MPI_Irecv(tmp + (recvs_started % depth)*seg_count, seg.count,
+              TypeMap<T>(), prev, tag, comm.get_comm(),
+              &recv_reqs[recvs_started % depth]);
+    ++recvs_started;
+  }
+  if (sends_done < num_sends || recvs_done < recvs.size()) {
+    return false;
+  }
+  // Move this rank's chunk into place. In place, it moves towards the
+  // start of the buffer, so copying forward is safe.
+  if (work + result_offset != recvbuf) {
+    std::copy_n(work + result_offset, result_count, recvbuf);
+  }
+  return true;
+}
+
+template <typename T>
+void ring_nb_reduce_scatterv(const T* sendbuf, T* recvbuf,
+                             const std::vector<size_t>& counts,
+                             ReductionOperator op, MPICommunicator& comm,
+                             AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::RingReduceScatterAlState<T>* state =
+    new internal::mpi::RingReduceScatterAlState<T>(
+      sendbuf, recvbuf, counts, op, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+template <typename T>
+void ring_nb_reduce_scatter(const T* sendbuf, T* recvbuf, size_t count,
+                            ReductionOperator op, MPICommunicator& comm,
+                            AlMPIReq& req) {
+  ring_nb_reduce_scatterv(sendbuf, recvbuf,
+                          std::vector<size_t>(comm.size(), count),
+                          op, comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -62,7 +62,8 @@ public:
 
   ~ReduceScattervAlState() override {}
 
-  std::string get_name() const override { return "MPIReduceScatterv"; }
+  const char* get_name() const override { return "MPIReduceScatterv"; }
+  size_t get_bytes() const override { return sum_counts(counts) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
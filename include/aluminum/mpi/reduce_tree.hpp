@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/knomial_tree.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Reduce by pipelining segments up a k-nomial tree to the root.
+ *
+ * The buffer is split into segments of at most
+ * AL_MPI_REDUCE_SEGMENT_BYTES. Each rank receives a segment from all
+ * its children, reduces them into its own data, and forwards the result
+ * to its parent while later segments are still arriving. At most
+ * AL_MPI_REDUCE_PIPELINE_DEPTH segments are in flight in each
+ * direction. The root only receives from its radix - 1 children per
+ * level, rather than from every rank.
+ *
+ * Messages are matched by order, so all use the same tag.
+ */
+template <typename T>
+class TreeReduceAlState : public MPIState {
+public:
+  TreeReduceAlState(const T* sendbuf_, T* recvbuf_, size_t count_,
+                    ReductionOperator op_, int root, int radix,
+                    MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), count(count_), op(op_),
+    comm(comm_), tag(comm_.get_free_tag()),
+    name(radix == 2 ? "MPIBinomialReduce" : "MPIKnomialReduce"),
+    tree((comm_.rank() - root + comm_.size()) % comm_.size(), comm_.size(),
+         radix) {
+    const int size = comm.size();
+    if (tree.parent >= 0) {
+      parent = (tree.parent + root) % size;
+    }
+    for (const auto& child : tree.children) {
+      children.push_back((child.vrank + root) % size);
+    }
+    seg_count = std::max<size_t>(AL_MPI_REDUCE_SEGMENT_BYTES / sizeof(T), 1);
+    num_segs = (count + seg_count - 1) / seg_count;
+    recv_reqs.resize(AL_MPI_REDUCE_PIPELINE_DEPTH*children.size(),
+                     MPI_REQUEST_NULL);
+    if (!children.empty()) {
+      // Segments from each child, then, off the root, the partial result.
+      const size_t slots = AL_MPI_REDUCE_PIPELINE_DEPTH*children.size();
+      tmp = mempool.allocate<MemoryType::HOST, T>(std::max<size_t>(
+        slots*std::min(seg_count, count) + (parent >= 0 ? count : 0), 1));
+    }
+  }
+
+  ~TreeReduceAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return name; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+protected:
+  void start_mpi_op() override {
+    // Off the root, in-place data is in recvbuf.
+    if (sendbuf == IN_PLACE<T>() && parent >= 0) {
+      sendbuf = recvbuf;
+    }
+    if (parent < 0) {
+      acc = recvbuf;
+      if (sendbuf != IN_PLACE<T>()) {
+        std::copy_n(sendbuf, count, acc);
+      }
+    } else if (!children.empty()) {
+      acc = tmp + AL_MPI_REDUCE_PIPELINE_DEPTH*children.size()
+        * std::min(seg_count, count);
+      std::copy_n(sendbuf, count, acc);
+    } else {
+      // Leaves forward their input unchanged.
+      acc = const_cast<T*>(sendbuf);
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  /** Return the number of elements in segment seg. */
+  size_t segment_count(size_t seg) const {
+    return std::min(seg_count, count - seg*seg_count);
+  }
+  /** Return the buffer for segment seg from child i. */
+  T* recv_slot(size_t seg, size_t i) const {
+    return tmp + ((seg % AL_MPI_REDUCE_PIPELINE_DEPTH)*children.size() + i)
+      * std::min(seg_count, count);
+  }
+
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  ReductionOperator op;
+  MPICommunicator& comm;
+  int tag;
+  const char* name;
+  KnomialTree tree;
+  /** Rank to send to, or -1 on the root. */
+  int parent = -1;
+  /** Ranks to receive from. */
+  std::vector<int> children;
+  /** Maximum elements in a segment. */
+  size_t seg_count;
+  size_t num_segs;
+  /** Buffer the reduction accumulates in (or, on leaves, the input). */
+  T* acc = nullptr;
+  /** Receive slots, followed by the partial result off the root. */
+  T* tmp = nullptr;
+  /** Requests for the receives of a segment from each child. */
+  std::vector<MPI_Request> recv_reqs;
+  MPI_Request send_reqs[AL_MPI_REDUCE_PIPELINE_DEPTH];
+  /** Number of segments whose receives were started and reduced. */
+  size_t recvs_started = 0;
+  size_t recvs_done = 0;
+  /** Number of sends started and completed. */
+  size_t sends_started = 0;
+  size_t sends_done = 0;
+};
+
+template <typename T>
+bool TreeReduceAlState<T>::poll_mpi() {
+  constexpr size_t depth = AL_MPI_REDUCE_PIPELINE_DEPTH;
+  const size_t num_children = children.size();
+  const size_t num_recvs = num_children ? num_segs : 0;
+  const size_t num_sends = parent >= 0 ? num_segs : 0;
+  int flag;
+  // Reduce segments in order once every child's has arrived.
+  while (recvs_done < recvs_started) {
+    MPI_Testall(num_children, &recv_reqs[(recvs_done % depth)*num_children],
+                &flag, MPI_STATUSES_IGNORE);
+    if (!flag) {
+      break;
+    }
+    const size_t seg_elems = segment_count(recvs_done);
+    for (size_t i = 0; i < num_children; ++i) {
+      reduce_local(recv_slot(recvs_done, i), acc + recvs_done*seg_count,
+                   seg_elems, op);
+    }
+    ++recvs_done;
+  }
+  while (sends_done < sends_started) {
+    MPI_Test(&send_reqs[sends_done % depth], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++sends_done;
+  }
+  // Forward segments once they have been reduced.
+  while (sends_started < num_sends && sends_started - sends_done < depth
+         && (num_children == 0 || sends_started < recvs_done)) {
+    const size_t seg_elems = segment_count(sends_started);
+    MPI_Isend(acc + sends_started*seg_count, seg_elems, TypeMap<T>(),
+              parent, tag, comm.get_comm(), &send_reqs[sends_started % depth]);
+    comm.count_send(parent, seg_elems*sizeof(T));
+    ++sends_started;
+  }
+  while (recvs_started < num_recvs && recvs_started - recvs_done < depth) {
+    MPI_Request* reqs = &recv_reqs[(recvs_started % depth)*num_children];
+    for (size_t i = 0; i < num_children; ++i) {
+      MPI_Irecv(recv_slot(recvs_started, i), segment_count(recvs_started),
+                TypeMap<T>(), children[i], tag, comm.get_comm(), &reqs[i]);
+    }
+    ++recvs_started;
+  }
+  return sends_done == num_sends && recvs_done == num_recvs;
+}
+
+/** Reduce up a tree with the given radix (2 is binomial). */
+template <typename T>
+void tree_nb_reduce(const T* sendbuf, T* recvbuf, size_t count,
+                    ReductionOperator op, int root, int radix,
+                    MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::TreeReduceAlState<T>* state =
+    new internal::mpi::TreeReduceAlState<T>(
+      sendbuf, recvbuf, count, op, root, radix, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
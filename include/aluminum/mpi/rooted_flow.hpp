@@ -0,0 +1,319 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Gatherv where at most AL_MPI_ROOT_FANIN ranks send to the root at once.
+ *
+ * The root sends each rank with data an empty clear-to-send message
+ * when it has a receive posted for it, and ranks wait for this before
+ * sending. Ranks are served in order starting after the root. This
+ * keeps a large job from flooding the root with messages it has not
+ * yet posted receives for.
+ */
+template <typename T>
+class FlowControlledGathervAlState : public MPIState {
+public:
+  FlowControlledGathervAlState(const T* sendbuf_, T* recvbuf_,
+                               const std::vector<size_t>& counts_,
+                               const std::vector<size_t>& displs_,
+                               int root_,
+                               MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), counts(counts_), displs(displs_),
+    root(root_), comm(comm_), tag(comm_.get_free_tag()) {
+    const int size = comm.size();
+    if (comm.rank() == root) {
+      for (int k = 1; k < size; ++k) {
+        const int peer = (root + k) % size;
+        if (counts[peer]) {
+          peers.push_back(peer);
+        }
+      }
+    }
+    std::fill_n(reqs, 2*AL_MPI_ROOT_FANIN, MPI_REQUEST_NULL);
+  }
+
+  ~FlowControlledGathervAlState() override {}
+
+  const char* get_name() const override { return "MPIFlowControlledGatherv"; }
+  size_t get_bytes() const override {
+    return counts[comm.rank()] * sizeof(T);
+  }
+
+protected:
+  void start_mpi_op() override {
+    const int rank = comm.rank();
+    if (rank == root) {
+      if (sendbuf != IN_PLACE<T>()) {
+        std::copy_n(sendbuf, counts[rank], recvbuf + displs[rank]);
+      }
+    } else if (counts[rank]) {
+      // Off the root, in-place data is in recvbuf.
+      if (sendbuf == IN_PLACE<T>()) {
+        sendbuf = recvbuf;
+      }
+      MPI_Irecv(nullptr, 0, MPI_BYTE, root, tag, comm.get_comm(),
+                get_mpi_req());
+    } else {
+      sent = true;
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  const T* sendbuf;
+  T* recvbuf;
+  std::vector<size_t> counts;
+  std::vector<size_t> displs;
+  int root;
+  MPICommunicator& comm;
+  int tag;
+  /** On the root, ranks with data, in the order they are served. */
+  std::vector<int> peers;
+  /** The clear-to-send and data receive requests for each slot. */
+  MPI_Request reqs[2*AL_MPI_ROOT_FANIN];
+  /** On the root, number of peers started and completed. */
+  size_t started = 0;
+  size_t done = 0;
+  /** Off the root, whether this rank's data has been sent. */
+  bool sent = false;
+};
+
+template <typename T>
+bool FlowControlledGathervAlState<T>::poll_mpi() {
+  const int rank = comm.rank();
+  if (rank != root) {
+    if (!sent) {
+      if (!MPIState::poll_mpi()) {
+        return false;
+      }
+      sent = true;
+      MPI_Isend(sendbuf, counts[rank], TypeMap<T>(), root, tag,
+                comm.get_comm(), get_mpi_req());
+      comm.count_send(root, counts[rank]*sizeof(T));
+    }
+    return counts[rank] == 0 || MPIState::poll_mpi();
+  }
+  constexpr size_t window = AL_MPI_ROOT_FANIN;
+  int flag;
+  while (done < started) {
+    MPI_Testall(2, &reqs[2*(done % window)], &flag, MPI_STATUSES_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++done;
+  }
+  while (started < peers.size() && started - done < window) {
+    const int peer = peers[started];
+    MPI_Request* slot = &reqs[2*(started % window)];
+    MPI_Irecv(recvbuf + displs[peer], counts[peer], TypeMap<T>(), peer, tag,
+              comm.get_comm(), &slot[1]);
+    MPI_Isend(nullptr, 0, MPI_BYTE, peer, tag, comm.get_comm(), &slot[0]);
+    ++started;
+  }
+  return done == peers.size();
+}
+
+/**
+ * Scatterv where the root sends to at most AL_MPI_ROOT_FANIN ranks at
+ * once.
+ *
+ * Ranks are served in order starting after the root.
+ */
+template <typename T>
+class FlowControlledScattervAlState : public MPIState {
+public:
+  FlowControlledScattervAlState(const T* sendbuf_, T* recvbuf_,
+                                const std::vector<size_t>& counts_,
+                                const std::vector<size_t>& displs_,
+                                int root_,
+                                MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), counts(counts_), displs(displs_),
+    root(root_), comm(comm_), tag(comm_.get_free_tag()) {
+    const int size = comm.size();
+    if (comm.rank() == root) {
+      for (int k = 1; k < size; ++k) {
+        const int peer = (root + k) % size;
+        if (counts[peer]) {
+          peers.push_back(peer);
+        }
+      }
+    }
+    std::fill_n(reqs, AL_MPI_ROOT_FANIN, MPI_REQUEST_NULL);
+  }
+
+  ~FlowControlledScattervAlState() override {}
+
+  const char* get_name() const override { return "MPIFlowControlledScatterv"; }
+  size_t get_bytes() const override {
+    return counts[comm.rank()] * sizeof(T);
+  }
+
+protected:
+  void start_mpi_op() override {
+    const int rank = comm.rank();
+    if (rank == root) {
+      // In-place data is in recvbuf and the root's block stays there.
+      if (sendbuf == IN_PLACE<T>()) {
+        sendbuf = recvbuf;
+      } else {
+        std::copy_n(sendbuf + displs[rank], counts[rank], recvbuf);
+      }
+    } else if (counts[rank]) {
+      MPI_Irecv(recvbuf, counts[rank], TypeMap<T>(), root, tag,
+                comm.get_comm(), get_mpi_req());
+    }
+  }
+
+  bool poll_mpi() override;
+
+private:
+  const T* sendbuf;
+  T* recvbuf;
+  std::vector<size_t> counts;
+  std::vector<size_t> displs;
+  int root;
+  MPICommunicator& comm;
+  int tag;
+  /** On the root, ranks with data, in the order they are served. */
+  std::vector<int> peers;
+  MPI_Request reqs[AL_MPI_ROOT_FANIN];
+  /** On the root, number of sends started and completed. */
+  size_t started = 0;
+  size_t done = 0;
+};
+
+template <typename T>
+bool FlowControlledScattervAlState<T>::poll_mpi() {
+  if (comm.rank() != root) {
+    return counts[comm.rank()] == 0 || MPIState::poll_mpi();
+  }
+  constexpr size_t window = AL_MPI_ROOT_FANIN;
+  int flag;
+  while (done < started) {
+    MPI_Test(&reqs[done % window], &flag, MPI_STATUS_IGNORE);
+    if (!flag) {
+      break;
+    }
+    ++done;
+  }
+  while (started < peers.size() && started - done < window) {
+    const int peer = peers[started];
+    MPI_Isend(sendbuf + displs[peer], counts[peer], TypeMap<T>(), peer, tag,
+              comm.get_comm(), &reqs[started % window]);
+    comm.count_send(peer, counts[peer]*sizeof(T));
+    ++started;
+  }
+  return done == peers.size();
+}
+
+/**
+ * Gatherv with bounded fan-in at the root.
+ *
+ * Off the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void flow_controlled_nb_gatherv(const T* sendbuf, T* recvbuf,
+                                const std::vector<size_t>& counts,
+                                const std::vector<size_t>& displs,
+                                int root,
+                                MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::FlowControlledGathervAlState<T>* state =
+    new internal::mpi::FlowControlledGathervAlState<T>(
+      sendbuf, recvbuf, counts, displs, root, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Scatterv with bounded fan-out at the root.
+ *
+ * At the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void flow_controlled_nb_scatterv(const T* sendbuf, T* recvbuf,
+                                 const std::vector<size_t>& counts,
+                                 const std::vector<size_t>& displs,
+                                 int root,
+                                 MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::FlowControlledScattervAlState<T>* state =
+    new internal::mpi::FlowControlledScattervAlState<T>(
+      sendbuf, recvbuf, counts, displs, root, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Gather with bounded fan-in at the root.
+ *
+ * Off the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void flow_controlled_nb_gather(const T* sendbuf, T* recvbuf, size_t count,
+                               int root,
+                               MPICommunicator& comm, AlMPIReq& req) {
+  const std::vector<size_t> counts(comm.size(), count);
+  flow_controlled_nb_gatherv(sendbuf, recvbuf, counts,
+                             block_displs(comm.size(), count), root, comm,
+                             req);
+}
+
+/**
+ * Scatter with bounded fan-out at the root.
+ *
+ * At the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void flow_controlled_nb_scatter(const T* sendbuf, T* recvbuf, size_t count,
+                                int root,
+                                MPICommunicator& comm, AlMPIReq& req) {
+  const std::vector<size_t> counts(comm.size(), count);
+  flow_controlled_nb_scatterv(sendbuf, recvbuf, counts,
+                              block_displs(comm.size(), count), root, comm,
+                              req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -60,7 +60,8 @@ public:
 
   ~ScatterAlState() override {}
 
-  std::string get_name() const override { return "MPIScatter"; }
+  const char* get_name() const override { return "MPIScatter"; }
+  size_t get_bytes() const override { return count * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
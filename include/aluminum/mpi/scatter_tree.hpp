@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/knomial_tree.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Scatterv down a k-nomial tree from the root.
+ *
+ * The root sends each child the packed blocks of that child's subtree
+ * as one message, sending directly from the input when the blocks are
+ * laid out in order there, and each rank forwards its children's parts
+ * of what it receives. The root thus sends to only radix - 1 ranks per
+ * level of the tree.
+ *
+ * This needs the counts of every rank on every rank.
+ */
+template <typename T>
+class TreeScattervAlState : public MPIState {
+public:
+  TreeScattervAlState(const T* sendbuf_, T* recvbuf_,
+                      const std::vector<size_t>& counts_,
+                      const std::vector<size_t>& displs_,
+                      int root_, int radix,
+                      MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    sendbuf(sendbuf_), recvbuf(recvbuf_), counts(counts_), displs(displs_),
+    root(root_), comm(comm_), tag(comm_.get_free_tag()),
+    name(radix == 2 ? "MPIBinomialScatterv" : "MPIKnomialScatterv"),
+    tree((comm_.rank() - root_ + comm_.size()) % comm_.size(), comm_.size(),
+         radix),
+    offsets(subtree_offsets(tree, counts_, root_)) {
+    if (tree.parent >= 0 && !check_count_fits_mpi(offsets.back())) {
+      throw_al_exception("Message count too large for MPI");
+    }
+    const bool is_root = tree.parent < 0;
+    for (const auto& child : tree.children) {
+      const bool packed = is_root
+        && subtree_is_packed(child, counts, displs, root);
+      direct.push_back(packed);
+      if (!packed) {
+        need_tmp = true;
+      }
+    }
+    if (need_tmp) {
+      tmp = mempool.allocate<MemoryType::HOST, T>(
+        std::max<size_t>(offsets.back(), 1));
+    }
+    send_reqs.resize(tree.children.size(), MPI_REQUEST_NULL);
+  }
+
+  ~TreeScattervAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return name; }
+  size_t get_bytes() const override {
+    return counts[comm.rank()] * sizeof(T);
+  }
+
+protected:
+  void start_mpi_op() override;
+  bool poll_mpi() override;
+
+private:
+  /** Return the rank of a vrank. */
+  int to_rank(int vrank) const { return (vrank + root) % comm.size(); }
+  /** Send each child its subtree's part of src (packed unless direct). */
+  void send_to_children(const T* src);
+
+  const T* sendbuf;
+  T* recvbuf;
+  std::vector<size_t> counts;
+  std::vector<size_t> displs;
+  int root;
+  MPICommunicator& comm;
+  int tag;
+  const char* name;
+  KnomialTree tree;
+  /** Offsets of each block of this rank's subtree when packed. */
+  std::vector<size_t> offsets;
+  /** Whether each child's subtree is sent directly from the input. */
+  std::vector<bool> direct;
+  bool need_tmp = false;
+  /** This rank's subtree, packed. */
+  T* tmp = nullptr;
+  std::vector<MPI_Request> send_reqs;
+  /** Whether this rank's subtree has arrived. */
+  bool recv_done = false;
+};
+
+template <typename T>
+void TreeScattervAlState<T>::send_to_children(const T* src) {
+  for (size_t i = 0; i < tree.children.size(); ++i) {
+    const auto& child = tree.children[i];
+    const int child_rank = to_rank(child.vrank);
+    const size_t offset = offsets[child.vrank - tree.vrank];
+    const size_t child_count =
+      offsets[child.vrank - tree.vrank + child.extent] - offset;
+    const T* buf = direct[i] ? src + displs[child_rank] : tmp + offset;
+    MPI_Isend(buf, child_count, TypeMap<T>(), child_rank, tag,
+              comm.get_comm(), &send_reqs[i]);
+    comm.count_send(child_rank, child_count*sizeof(T));
+  }
+}
+
+template <typename T>
+void TreeScattervAlState<T>::start_mpi_op() {
+  const int rank = comm.rank();
+  if (tree.parent >= 0) {
+    // Leaves receive their block directly.
+    T* dst = tree.children.empty() ? recvbuf : tmp;
+    MPI_Irecv(dst, offsets.back(), TypeMap<T>(), to_rank(tree.parent), tag,
+              comm.get_comm(), get_mpi_req());
+    return;
+  }
+  // At the root, in-place data is in recvbuf and its block stays there.
+  const T* src = sendbuf == IN_PLACE<T>() ? recvbuf : sendbuf;
+  for (size_t i = 0; i < tree.children.size(); ++i) {
+    if (direct[i]) {
+      continue;
+    }
+    const auto& child = tree.children[i];
+    for (int v = child.vrank; v < child.vrank + child.extent; ++v) {
+      std::copy_n(src + displs[to_rank(v)], counts[to_rank(v)],
+                  tmp + offsets[v]);
+    }
+  }
+  send_to_children(src);
+  if (sendbuf != IN_PLACE<T>()) {
+    std::copy_n(sendbuf + displs[rank], counts[rank], recvbuf);
+  }
+  recv_done = true;
+}
+
+template <typename T>
+bool TreeScattervAlState<T>::poll_mpi() {
+  if (!recv_done) {
+    if (!MPIState::poll_mpi()) {
+      return false;
+    }
+    recv_done = true;
+    if (!tree.children.empty()) {
+      send_to_children(tmp);
+      std::copy_n(tmp, counts[comm.rank()], recvbuf);
+    }
+  }
+  int flag;
+  MPI_Testall(send_reqs.size(), send_reqs.data(), &flag, MPI_STATUSES_IGNORE);
+  return flag;
+}
+
+/**
+ * Scatterv down a tree with the given radix (2 is binomial).
+ *
+ * At the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void tree_nb_scatterv(const T* sendbuf, T* recvbuf,
+                      const std::vector<size_t>& counts,
+                      const std::vector<size_t>& displs,
+                      int root, int radix,
+                      MPICommunicator& comm, AlMPIReq& req) {
+  req = get_free_request();
+  internal::mpi::TreeScattervAlState<T>* state =
+    new internal::mpi::TreeScattervAlState<T>(
+      sendbuf, recvbuf, counts, displs, root, radix, comm, req);
+  get_progress_engine()->enqueue(state);
+}
+
+/**
+ * Scatter down a tree with the given radix (2 is binomial).
+ *
+ * At the root, in-place data is in recvbuf.
+ */
+template <typename T>
+void tree_nb_scatter(const T* sendbuf, T* recvbuf, size_t count,
+                     int root, int radix,
+                     MPICommunicator& comm, AlMPIReq& req) {
+  const std::vector<size_t> counts(comm.size(), count);
+  tree_nb_scatterv(sendbuf, recvbuf, counts,
+                   block_displs(comm.size(), count), root, radix, comm, req);
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -71,7 +71,8 @@ public:
 
   ~ScattervAlState() override {}
 
-  std::string get_name() const override { return "MPIScatterv"; }
+  const char* get_name() const override { return "MPIScatterv"; }
+  size_t get_bytes() const override { return sum_counts(counts) * sizeof(T); }
 
 protected:
   void start_mpi_op() override {
@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "aluminum/progress.hpp"
+#include "aluminum/mempool.hpp"
+#include "aluminum/mpi/base_state.hpp"
+#include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * One step of a schedule: an optional send and an optional receive,
+ * after which the received data may be reduced into a buffer and data
+ * may be copied locally.
+ */
+template <typename T>
+struct ScheduleStep {
+  /** Buffer, count, and destination to send; peer -1 for no send. */
+  const T* send_buf = nullptr;
+  size_t send_count = 0;
+  int send_peer = -1;
+  /** Buffer, count, and source to receive; peer -1 for no receive. */
+  T* recv_buf = nullptr;
+  size_t recv_count = 0;
+  int recv_peer = -1;
+  /** If not null, reduce the received data into this. */
+  T* reduce_into = nullptr;
+  /** If not null, then copy copy_count elements from copy_from to this. */
+  const T* copy_from = nullptr;
+  T* copy_to = nullptr;
+  size_t copy_count = 0;
+};
+
+/**
+ * Runs a fixed schedule of steps on the progress engine.
+ *
+ * This is a building block for collectives Aluminum implements itself as
+ * a sequence of point-to-point exchanges (e.g., recursive doubling).
+ * Each step starts once the previous one has completed, so steps may
+ * depend on data received or reduced earlier. All messages use a single
+ * tag and are matched by order.
+ */
+template <typename T>
+class ScheduleAlState : public MPIState {
+public:
+  /**
+   * Set up an empty schedule.
+   *
+   * name must be a string with static storage duration. If sendbuf is
+   * not IN_PLACE, it is first copied to recvbuf (count elements).
+   */
+  ScheduleAlState(const char* name_, const T* sendbuf_, T* recvbuf_,
+                  size_t count_, ReductionOperator op_,
+                  MPICommunicator& comm_, AlMPIReq req_) :
+    MPIState(req_),
+    name(name_), sendbuf(sendbuf_), recvbuf(recvbuf_), count(count_),
+    op(op_), comm(comm_), tag(comm_.get_free_tag()) {}
+
+  ~ScheduleAlState() override {
+    if (tmp) {
+      mempool.release<MemoryType::HOST>(tmp);
+    }
+  }
+
+  const char* get_name() const override { return name; }
+  size_t get_bytes() const override { return count * sizeof(T); }
+
+  /** Return a temporary buffer of size elements, owned by this. */
+  T* get_tmp(size_t size) {
+    if (!tmp) {
+      tmp = mempool.allocate<MemoryType::HOST, T>(std::max<size_t>(size, 1));
+    }
+    return tmp;
+  }
+
+  /** Add a step to the schedule. */
+  void add_step(const ScheduleStep<T>& step) { steps.push_back(step); }
+
+protected:
+  void start_mpi_op() override {
+    if (sendbuf != IN_PLACE<T>() && sendbuf != recvbuf) {
+      std::copy_n(sendbuf, count, recvbuf);
+    }
+    if (!steps.empty()) {
+      start_step();
+    }
+  }
+
+  bool poll_mpi() override {
+    while (cur_step < steps.size()) {
+      int flag;
+      MPI_Testall(2, reqs, &flag, MPI_STATUSES_IGNORE);
+      if (!flag) {
+        return false;
+      }
+      const ScheduleStep<T>& step = steps[cur_step];
+      if (step.reduce_into) {
+        reduce_local(step.recv_buf, step.reduce_into, step.recv_count, op);
+      }
+      if (step.copy_to && step.copy_to != step.copy_from) {
+        std::copy_n(step.copy_from, step.copy_count, step.copy_to);
+      }
+      if (++cur_step < steps.size()) {
+        start_step();
+      }
+    }
+    return true;
+  }
+
+private:
+  /** Post the messages for the current step. */
+  void start_step() {
+    const ScheduleStep<T>& step = steps[cur_step];
+    if (step.recv_peer >= 0) {
+      MPI_Irecv(step.recv_buf, step.recv_count, TypeMap<T>(), step.recv_peer,
+                tag, comm.get_comm(), &reqs[0]);
+    }
+    if (step.send_peer >= 0) {
+      MPI_Isend(step.send_buf, step.send_count, TypeMap<T>(), step.send_peer,
+                tag, comm.get_comm(), &reqs[1]);
+      comm.count_send(step.send_peer, step.send_count*sizeof(T));
+    }
+  }
+
+  const char* name;
+  const T* sendbuf;
+  T* recvbuf;
+  size_t count;
+  ReductionOperator op;
+  MPICommunicator& comm;
+  int tag;
+  std::vector<ScheduleStep<T>> steps;
+  /** Index of the step in progress. */
+  size_t cur_step = 0;
+  /** Requests for the receive and send of the current step. */
+  MPI_Request reqs[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+  T* tmp = nullptr;
+};
+
+/**
+ * Add steps copying block i, of counts[i] elements, from
+ * from + from_displs[i] to to + to_displs[i], merging copies of blocks
+ * that are adjacent in both.
+ */
+template <typename T>
+void add_block_copy_steps(ScheduleAlState<T>& state,
+                          const T* from, T* to,
+                          const std::vector<size_t>& from_displs,
+                          const std::vector<size_t>& to_displs,
+                          const std::vector<size_t>& counts) {
+  ScheduleStep<T> step;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (step.copy_to
+        && from + from_displs[i] == step.copy_from + step.copy_count
+        && to + to_displs[i] == step.copy_to + step.copy_count) {
+      step.copy_count += counts[i];
+      continue;
+    }
+    if (step.copy_to) {
+      state.add_step(step);
+    }
+    step.copy_from = from + from_displs[i];
+    step.copy_to = to + to_displs[i];
+    step.copy_count = counts[i];
+  }
+  if (step.copy_to) {
+    state.add_step(step);
+  }
+}
+
+/**
+ * Ranks of a communicator folded to a power of two.
+ *
+ * Of p ranks, the first 2*(p - pof2) are paired up, and the even rank
+ * of each pair sits out (its data is handled by the odd one), as in
+ * MPICH, so that power-of-two algorithms can run among the rest.
+ */
+struct PowerOfTwoFold {
+  PowerOfTwoFold(int rank_, int size) : rank(rank_) {
+    pof2 = 1;
+    while (pof2 * 2 <= size) {
+      pof2 *= 2;
+    }
+    rem = size - pof2;
+    if (rank < 2*rem) {
+      newrank = (rank % 2) ? rank / 2 : -1;
+    } else {
+      newrank = rank - rem;
+    }
+  }
+
+  /** Return the rank of the process with new rank r. */
+  int real_rank(int r) const { return r < rem ? r*2 + 1 : r + rem; }
+  /** Return true if this rank sits out the power-of-two part. */
+  bool is_extra() const { return newrank < 0; }
+  /** Return true if this rank handles an extra rank's data. */
+  bool has_extra() const { return rank < 2*rem && !is_extra(); }
+
+  int rank;
+  int pof2;
+  int rem;
+  /** Rank among the power-of-two ranks, or -1 if not participating. */
+  int newrank;
+};
+
+/**
+ * Add steps to fold the data of extra ranks into their partners, and
+ * return the fold.
+ */
+template <typename T>
+PowerOfTwoFold add_fold_in_steps(ScheduleAlState<T>& state, T* buf,
+                                 size_t count, MPICommunicator& comm) {
+  PowerOfTwoFold fold(comm.rank(), comm.size());
+  ScheduleStep<T> step;
+  if (fold.is_extra()) {
+    step.send_buf = buf;
+    step.send_count = count;
+    step.send_peer = fold.rank + 1;
+    state.add_step(step);
+  } else if (fold.has_extra()) {
+    step.recv_buf = state.get_tmp(count);
+    step.recv_count = count;
+    step.recv_peer = fold.rank - 1;
+    step.reduce_into = buf;
+    state.add_step(step);
+  }
+  return fold;
+}
+
+/** Add steps to send the final result back to extra ranks. */
+template <typename T>
+void add_fold_out_steps(ScheduleAlState<T>& state, T* buf, size_t count,
+                        const PowerOfTwoFold& fold) {
+  ScheduleStep<T> step;
+  if (fold.is_extra()) {
+    step.recv_buf = buf;
+    step.recv_count = count;
+    step.recv_peer = fold.rank + 1;
+    state.add_step(step);
+  } else if (fold.has_extra()) {
+    step.send_buf = buf;
+    step.send_count = count;
+    step.send_peer = fold.rank - 1;
+    state.add_step(step);
+  }
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
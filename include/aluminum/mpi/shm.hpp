@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mpi.h>
+
+#include "aluminum/tuning_params.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+/**
+ * Shared-memory buffers for the ranks of a communicator on one node.
+ *
+ * Each rank has a buffer of AL_MPI_SHM_BYTES, allocated with
+ * MPI_Win_allocate_shared, which every rank on the node can load from
+ * and store to directly. Ranks synchronize with a flag per rank in the
+ * same segment rather than with MPI:
+ *
+ * Operations run as a sequence of steps, the same on every rank. Before
+ * doing step n, a rank waits until ready(), i.e. every rank has finished
+ * step n-1, then calls finish_step() after it. So data a rank writes to
+ * its buffer in one step can be read by all in the next, and it can be
+ * overwritten in the step after that. Steps continue across operations.
+ *
+ * Only one operation may use the buffers at a time, which is arbitrated
+ * by tickets taken in start order (all ranks start operations on a
+ * communicator in the same order). This is only used by the progress
+ * engine.
+ */
+class NodeShm {
+ public:
+  /** Allocate buffers; collective over local_comm. */
+  NodeShm(MPI_Comm local_comm, int local_rank_, int local_size_);
+  NodeShm(const NodeShm&) = delete;
+  NodeShm& operator=(const NodeShm&) = delete;
+  ~NodeShm();
+
+  /** Return the size in bytes of each rank's buffer. */
+  size_t buffer_bytes() const { return AL_MPI_SHM_BYTES; }
+  /** Return the buffer of a local rank. */
+  template <typename T>
+  T* get_buffer(int rank) const {
+    return reinterpret_cast<T*>(buffers[rank]);
+  }
+
+  /** Return a ticket for using the buffers; called when starting. */
+  uint64_t take_ticket() { return next_ticket++; }
+  /** Return true if the operation with ticket may use the buffers. */
+  bool is_turn(uint64_t ticket) const { return ticket == now_serving; }
+  /** Let the next operation use the buffers. */
+  void release() { ++now_serving; }
+
+  /** Return true if all ranks have finished the previous step. */
+  bool ready() const {
+    for (int i = 0; i < local_size; ++i) {
+      if (flags[i]->load(std::memory_order_acquire) < step) {
+        return false;
+      }
+    }
+    return true;
+  }
+  /** Return true if rank has finished the step this rank is on. */
+  bool is_ahead(int rank) const {
+    return flags[rank]->load(std::memory_order_acquire) > step;
+  }
+  /** Mark this rank as having finished the current step. */
+  void finish_step() {
+    flags[local_rank]->store(++step, std::memory_order_release);
+  }
+
+ private:
+  MPI_Win win = MPI_WIN_NULL;
+  int local_rank;
+  int local_size;
+  /** Each rank's step counter. */
+  std::vector<std::atomic<uint64_t>*> flags;
+  /** Each rank's buffer. */
+  std::vector<char*> buffers;
+  /** Steps this rank has finished. */
+  uint64_t step = 0;
+  uint64_t next_ticket = 0;
+  uint64_t now_serving = 0;
+};
+
+/**
+ * Allocate shared-memory buffers for the ranks of a communicator on this
+ * node.
+ *
+ * This is collective over local_comm. It returns null if there is only
+ * one rank on the node or AL_MPI_SHM_BYTES is 0.
+ */
+std::unique_ptr<NodeShm> make_node_shm(MPI_Comm local_comm, int local_rank,
+                                       int local_size);
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
 #include <vector>
 
 #include <mpi.h>
@@ -90,6 +91,33 @@ inline std::vector<int> intify_size_t_vector(const std::vector<size_t> v) {
   return std::vector<int>(v.begin(), v.end());
 }
 
+/** Return the sum of a vector of MPI counts. */
+inline size_t sum_counts(const std::vector<int>& counts) {
+  size_t sum = 0;
+  for (const auto& c : counts) {
+    sum += static_cast<size_t>(c);
+  }
+  return sum;
+}
+
+/** Return the sum of a vector of counts. */
+inline size_t sum_counts(const std::vector<size_t>& counts) {
+  size_t sum = 0;
+  for (const auto& c : counts) {
+    sum += c;
+  }
+  return sum;
+}
+
+/** Return the displacements of num_blocks consecutive blocks of count. */
+inline std::vector<size_t> block_displs(size_t num_blocks, size_t count) {
+  std::vector<size_t> displs(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    displs[i] = i * count;
+  }
+  return displs;
+}
+
 /** True if count elements can be sent by MPI. */
 inline bool check_count_fits_mpi(size_t count) {
   return count <= static_cast<size_t>(std::numeric_limits<int>::max());
@@ -188,6 +216,45 @@ inline MPI_Op ReductionOperator2MPI_Op<al_bfloat16>(ReductionOperator op) {
 }
 #endif
 
+/**
+ * Reduce count elements of in into inout with op, on the host.
+ *
+ * This is for algorithms Aluminum implements itself. Arithmetic types
+ * use plain loops the compiler can vectorize; other types (e.g., half)
+ * and operators use MPI_Reduce_local.
+ */
+template <typename T>
+void reduce_local(const T* in, T* inout, size_t count, ReductionOperator op) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    switch (op) {
+    case ReductionOperator::sum:
+      for (size_t i = 0; i < count; ++i) {
+        inout[i] += in[i];
+      }
+      return;
+    case ReductionOperator::prod:
+      for (size_t i = 0; i < count; ++i) {
+        inout[i] *= in[i];
+      }
+      return;
+    case ReductionOperator::min:
+      for (size_t i = 0; i < count; ++i) {
+        inout[i] = in[i] < inout[i] ? in[i] : inout[i];
+      }
+      return;
+    case ReductionOperator::max:
+      for (size_t i = 0; i < count; ++i) {
+        inout[i] = in[i] > inout[i] ? in[i] : inout[i];
+      }
+      return;
+    default:
+      break;
+    }
+  }
+  MPI_Reduce_local(in, inout, static_cast<int>(count), TypeMap<T>(),
+                   ReductionOperator2MPI_Op<T>(op));
+}
+
 }  // namespace mpi
 }  // namespace internal
 }  // namespace Al
@@ -29,6 +29,9 @@
 
 #include <Al_config.hpp>
 #include "aluminum/base.hpp"
+#include "aluminum/skew.hpp"
+
+#include <memory>
 
 #include <mpi.h>
 
@@ -62,6 +65,9 @@ public:
                         &local_comm);
     MPI_Comm_rank(local_comm, &rank_in_local_comm);
     MPI_Comm_size(local_comm, &size_of_local_comm);
+    if (skew::skew_enabled() && size_of_comm > 1) {
+      arrival_log = std::make_unique<skew::ArrivalLog>(comm);
+    }
   }
   /** Cannot copy this. */
   MPICommAndStreamWrapper(const MPICommAndStreamWrapper& other) = delete;
@@ -78,6 +84,7 @@ public:
       terminate_al("Attempting to destruct with null MPI communicators");
     }
 
+    arrival_log.reset();
     int finalized;
     MPI_Finalized(&finalized);
     if (!finalized) {
@@ -111,6 +118,9 @@ public:
   /** Return the assoicated compute stream. */
   Stream get_stream() const { return stream; }
 
+  /** Return the arrival log for skew detection, or null if disabled. */
+  skew::ArrivalLog* get_arrival_log() const { return arrival_log.get(); }
+
 private:
   /** Associated compute stream. */
   Stream stream;
@@ -126,6 +136,8 @@ private:
   int rank_in_local_comm;
   /** Size of the local communicator. */
   int size_of_local_comm;
+  /** Arrival times of collectives, when skew detection is enabled. */
+  std::unique_ptr<skew::ArrivalLog> arrival_log;
 };
 
 } // namespace internal
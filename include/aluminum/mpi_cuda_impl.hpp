@@ -103,7 +103,7 @@ class MPICUDABackend {
   }
 #endif // AL_HAS_MPI_CUDA_RMA
 
-  static std::string Name() { return "MPICUDABackend"; }
+  static const char* Name() { return "MPICUDABackend"; }
 };
 
 template <>
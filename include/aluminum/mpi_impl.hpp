@@ -38,23 +38,44 @@
 #include "aluminum/internal.hpp"
 #include "aluminum/progress.hpp"
 #include "aluminum/state.hpp"
+#include "aluminum/trace.hpp"
 
 #include "aluminum/mpi/communicator.hpp"
 #include "aluminum/mpi/utils.hpp"
 #include "aluminum/mpi/allgather.hpp"
+#include "aluminum/mpi/allgather_recursive.hpp"
+#include "aluminum/mpi/allgather_ring.hpp"
 #include "aluminum/mpi/allgatherv.hpp"
 #include "aluminum/mpi/allreduce.hpp"
+#include "aluminum/mpi/allreduce_hierarchical.hpp"
+#include "aluminum/mpi/allreduce_recursive.hpp"
+#include "aluminum/mpi/allreduce_ring.hpp"
+#include "aluminum/mpi/allreduce_shm.hpp"
 #include "aluminum/mpi/alltoall.hpp"
+#include "aluminum/mpi/alltoall_bruck.hpp"
+#include "aluminum/mpi/alltoall_pairwise.hpp"
 #include "aluminum/mpi/alltoallv.hpp"
+#include "aluminum/mpi/alltoallv_sparse.hpp"
 #include "aluminum/mpi/barrier.hpp"
+#include "aluminum/mpi/barrier_hierarchical.hpp"
 #include "aluminum/mpi/bcast.hpp"
+#include "aluminum/mpi/bcast_pipelined.hpp"
+#include "aluminum/mpi/bcast_scatter_allgather.hpp"
+#include "aluminum/mpi/bcast_shm.hpp"
+#include "aluminum/mpi/dynamic.hpp"
 #include "aluminum/mpi/gather.hpp"
+#include "aluminum/mpi/gather_tree.hpp"
 #include "aluminum/mpi/gatherv.hpp"
 #include "aluminum/mpi/multisendrecv.hpp"
 #include "aluminum/mpi/reduce.hpp"
+#include "aluminum/mpi/reduce_tree.hpp"
 #include "aluminum/mpi/reduce_scatter.hpp"
+#include "aluminum/mpi/reduce_scatter_recursive.hpp"
+#include "aluminum/mpi/reduce_scatter_ring.hpp"
 #include "aluminum/mpi/reduce_scatterv.hpp"
+#include "aluminum/mpi/rooted_flow.hpp"
 #include "aluminum/mpi/scatter.hpp"
+#include "aluminum/mpi/scatter_tree.hpp"
 #include "aluminum/mpi/scatterv.hpp"
 #include "aluminum/mpi/pt2pt.hpp"
 #include "mpi/multisendrecv.hpp"
@@ -72,13 +93,26 @@ void finalize();
 }  // namespace mpi
 }  // namespace internal
 
+// Forward declare:
+template <typename Backend> void Wait(typename Backend::req_type&);
+
 /**
  * Supported allreduce algorithms.
  * This is used for requesting a particular algorithm. Use automatic to let the
  * library select for you.
  *
- * Note: These are kept for backwards compatibility and are all
- * equivalent to an automatic algorithm that passes through to MPI.
+ * automatic and mpi_passthrough pass through to MPI. The others are
+ * implemented by Aluminum on the progress engine:
+ * - mpi_recursive_doubling: latency-optimal, for small messages.
+ * - mpi_rabenseifner: reduce-scatter by recursive halving then allgather
+ *   by recursive doubling, for medium messages.
+ * - mpi_ring: pipelined ring, bandwidth-optimal for large messages.
+ * - mpi_biring: two rings in opposite directions, each over half the
+ *   buffer.
+ * - mpi_hierarchical: node-aware, reducing within nodes first so that
+ *   only one copy of the data crosses the network per node.
+ * - mpi_shm: through shared memory, for communicators on a single node
+ *   (otherwise this passes through to MPI).
  */
 enum class MPIAllreduceAlgorithm {
   automatic,
@@ -86,7 +120,168 @@ enum class MPIAllreduceAlgorithm {
   mpi_recursive_doubling,
   mpi_ring,
   mpi_rabenseifner,
-  mpi_biring
+  mpi_biring,
+  mpi_hierarchical,
+  mpi_shm
+};
+/**
+ * Supported allgather (and allgatherv) algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum:
+ * - mpi_ring: a pipelined ring; this suits large messages.
+ * - mpi_recursive_doubling: exchanges doubling in size with partners at
+ *   doubling distance, for power-of-two sizes (otherwise this is
+ *   mpi_bruck).
+ * - mpi_bruck: Bruck's algorithm, which takes ceil(log2(p)) steps for
+ *   any number of ranks; this suits small messages.
+ */
+enum class MPIAllgatherAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_ring,
+  mpi_recursive_doubling,
+  mpi_bruck
+};
+/**
+ * Supported alltoall algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum:
+ * - mpi_bruck: Bruck's algorithm, which takes ceil(log2(p)) steps; this
+ *   suits small blocks.
+ * - mpi_pairwise: pairwise exchanges with a bounded number in flight;
+ *   this suits large blocks.
+ */
+enum class MPIAlltoallAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_bruck,
+  mpi_pairwise
+};
+/**
+ * Supported alltoallv algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum and send only to peers with data:
+ * - mpi_sparse: posts receives from every peer with data at once, unless
+ *   many peers have data, when it is mpi_pairwise.
+ * - mpi_pairwise: a windowed pairwise exchange.
+ *
+ * Ranks may use different Aluminum algorithms in one alltoallv, but
+ * must not mix them with passing through to MPI. Since counts differ
+ * between ranks, tuning rules should not switch between the two by size.
+ */
+enum class MPIAlltoallvAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_sparse,
+  mpi_pairwise
+};
+/**
+ * Supported barrier algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. mpi_hierarchical
+ * synchronizes each node through shared memory and node leaders with a
+ * dissemination barrier (it passes through to MPI when shared memory is
+ * disabled).
+ */
+enum class MPIBarrierAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_hierarchical
+};
+/**
+ * Supported broadcast algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. mpi_shm goes
+ * through shared memory for communicators on a single node (otherwise
+ * it passes through to MPI). The rest are implemented by Aluminum:
+ * - mpi_pipelined_chain: segments are forwarded down a chain of ranks.
+ * - mpi_binary_tree: segments are forwarded down a binary tree; this
+ *   suits medium messages.
+ * - mpi_scatter_allgather: a binomial scatter followed by a ring
+ *   allgather (van de Geijn); this suits large messages.
+ */
+enum class MPIBcastAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_shm,
+  mpi_pipelined_chain,
+  mpi_binary_tree,
+  mpi_scatter_allgather
+};
+/**
+ * Supported reduce-scatter (and reduce-scatterv) algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum:
+ * - mpi_ring: a pipelined ring; this suits large messages.
+ * - mpi_recursive_halving: exchanges halving in size with partners at
+ *   halving distance; this suits small and medium messages.
+ */
+enum class MPIReduceScatterAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_ring,
+  mpi_recursive_halving
+};
+/**
+ * Supported reduce algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum, and pipeline segments up a tree to the root:
+ * - mpi_binomial: a binomial tree.
+ * - mpi_knomial: a k-nomial tree of radix AL_MPI_KNOMIAL_RADIX, which is
+ *   shallower.
+ */
+enum class MPIReduceAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_binomial,
+  mpi_knomial
+};
+/**
+ * Supported gather (and gatherv) algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum:
+ * - mpi_binomial: whole subtrees are gathered up a binomial tree, so the
+ *   root receives from only log2(p) ranks.
+ * - mpi_knomial: the same with a k-nomial tree of radix
+ *   AL_MPI_KNOMIAL_RADIX.
+ * - mpi_flow_controlled: ranks send directly to the root, but at most
+ *   AL_MPI_ROOT_FANIN at once; this suits large gathervs.
+ *
+ * The tree algorithms need every rank's count on every rank.
+ */
+enum class MPIGatherAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_binomial,
+  mpi_knomial,
+  mpi_flow_controlled
+};
+/**
+ * Supported scatter (and scatterv) algorithms.
+ *
+ * automatic and mpi_passthrough pass through to MPI. The rest are
+ * implemented by Aluminum:
+ * - mpi_binomial: whole subtrees are scattered down a binomial tree, so
+ *   the root sends to only log2(p) ranks.
+ * - mpi_knomial: the same with a k-nomial tree of radix
+ *   AL_MPI_KNOMIAL_RADIX.
+ * - mpi_flow_controlled: the root sends to each rank directly, but at
+ *   most AL_MPI_ROOT_FANIN at once.
+ *
+ * The tree algorithms need every rank's count on every rank.
+ */
+enum class MPIScatterAlgorithm {
+  automatic,
+  mpi_passthrough,
+  mpi_binomial,
+  mpi_knomial,
+  mpi_flow_controlled
 };
 /** Supported algorithms for collectives. */
 enum class MPICollectiveAlgorithm {
@@ -97,12 +292,173 @@ enum class MPICollectiveAlgorithm {
 inline std::string algorithm_name(MPIAllreduceAlgorithm algo) {
   switch (algo) {
   case MPIAllreduceAlgorithm::automatic:
+    return "automatic";
   case MPIAllreduceAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
   case MPIAllreduceAlgorithm::mpi_recursive_doubling:
-  case MPIAllreduceAlgorithm::mpi_ring:
+    return "mpi_recursive_doubling";
   case MPIAllreduceAlgorithm::mpi_rabenseifner:
+    return "mpi_rabenseifner";
+  case MPIAllreduceAlgorithm::mpi_ring:
+    return "mpi_ring";
   case MPIAllreduceAlgorithm::mpi_biring:
+    return "mpi_biring";
+  case MPIAllreduceAlgorithm::mpi_hierarchical:
+    return "mpi_hierarchical";
+  case MPIAllreduceAlgorithm::mpi_shm:
+    return "mpi_shm";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI allgather algorithm. */
+inline std::string algorithm_name(MPIAllgatherAlgorithm algo) {
+  switch (algo) {
+  case MPIAllgatherAlgorithm::automatic:
+    return "automatic";
+  case MPIAllgatherAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIAllgatherAlgorithm::mpi_ring:
+    return "mpi_ring";
+  case MPIAllgatherAlgorithm::mpi_recursive_doubling:
+    return "mpi_recursive_doubling";
+  case MPIAllgatherAlgorithm::mpi_bruck:
+    return "mpi_bruck";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI alltoall algorithm. */
+inline std::string algorithm_name(MPIAlltoallAlgorithm algo) {
+  switch (algo) {
+  case MPIAlltoallAlgorithm::automatic:
+    return "automatic";
+  case MPIAlltoallAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIAlltoallAlgorithm::mpi_bruck:
+    return "mpi_bruck";
+  case MPIAlltoallAlgorithm::mpi_pairwise:
+    return "mpi_pairwise";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI alltoallv algorithm. */
+inline std::string algorithm_name(MPIAlltoallvAlgorithm algo) {
+  switch (algo) {
+  case MPIAlltoallvAlgorithm::automatic:
+    return "automatic";
+  case MPIAlltoallvAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIAlltoallvAlgorithm::mpi_sparse:
+    return "mpi_sparse";
+  case MPIAlltoallvAlgorithm::mpi_pairwise:
+    return "mpi_pairwise";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI barrier algorithm. */
+inline std::string algorithm_name(MPIBarrierAlgorithm algo) {
+  switch (algo) {
+  case MPIBarrierAlgorithm::automatic:
+    return "automatic";
+  case MPIBarrierAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIBarrierAlgorithm::mpi_hierarchical:
+    return "mpi_hierarchical";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI broadcast algorithm. */
+inline std::string algorithm_name(MPIBcastAlgorithm algo) {
+  switch (algo) {
+  case MPIBcastAlgorithm::automatic:
+    return "automatic";
+  case MPIBcastAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIBcastAlgorithm::mpi_shm:
+    return "mpi_shm";
+  case MPIBcastAlgorithm::mpi_pipelined_chain:
+    return "mpi_pipelined_chain";
+  case MPIBcastAlgorithm::mpi_binary_tree:
+    return "mpi_binary_tree";
+  case MPIBcastAlgorithm::mpi_scatter_allgather:
+    return "mpi_scatter_allgather";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI reduce-scatter algorithm. */
+inline std::string algorithm_name(MPIReduceScatterAlgorithm algo) {
+  switch (algo) {
+  case MPIReduceScatterAlgorithm::automatic:
+    return "automatic";
+  case MPIReduceScatterAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIReduceScatterAlgorithm::mpi_ring:
+    return "mpi_ring";
+  case MPIReduceScatterAlgorithm::mpi_recursive_halving:
+    return "mpi_recursive_halving";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI reduce algorithm. */
+inline std::string algorithm_name(MPIReduceAlgorithm algo) {
+  switch (algo) {
+  case MPIReduceAlgorithm::automatic:
+    return "automatic";
+  case MPIReduceAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIReduceAlgorithm::mpi_binomial:
+    return "mpi_binomial";
+  case MPIReduceAlgorithm::mpi_knomial:
+    return "mpi_knomial";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI gather algorithm. */
+inline std::string algorithm_name(MPIGatherAlgorithm algo) {
+  switch (algo) {
+  case MPIGatherAlgorithm::automatic:
     return "automatic";
+  case MPIGatherAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIGatherAlgorithm::mpi_binomial:
+    return "mpi_binomial";
+  case MPIGatherAlgorithm::mpi_knomial:
+    return "mpi_knomial";
+  case MPIGatherAlgorithm::mpi_flow_controlled:
+    return "mpi_flow_controlled";
+  default:
+    return "unknown";
+  }
+}
+
+/** Return a textual name for an MPI scatter algorithm. */
+inline std::string algorithm_name(MPIScatterAlgorithm algo) {
+  switch (algo) {
+  case MPIScatterAlgorithm::automatic:
+    return "automatic";
+  case MPIScatterAlgorithm::mpi_passthrough:
+    return "mpi_passthrough";
+  case MPIScatterAlgorithm::mpi_binomial:
+    return "mpi_binomial";
+  case MPIScatterAlgorithm::mpi_knomial:
+    return "mpi_knomial";
+  case MPIScatterAlgorithm::mpi_flow_controlled:
+    return "mpi_flow_controlled";
   default:
     return "unknown";
   }
@@ -121,19 +477,19 @@ inline std::string algorithm_name(MPICollectiveAlgorithm algo) {
 class MPIBackend {
  public:
   using allreduce_algo_type = MPIAllreduceAlgorithm;
-  using allgather_algo_type = MPICollectiveAlgorithm;
-  using allgatherv_algo_type = MPICollectiveAlgorithm;
-  using alltoall_algo_type = MPICollectiveAlgorithm;
-  using alltoallv_algo_type = MPICollectiveAlgorithm;
-  using barrier_algo_type = MPICollectiveAlgorithm;
-  using bcast_algo_type = MPICollectiveAlgorithm;
-  using gather_algo_type = MPICollectiveAlgorithm;
-  using gatherv_algo_type = MPICollectiveAlgorithm;
-  using reduce_algo_type = MPICollectiveAlgorithm;
-  using reduce_scatter_algo_type = MPICollectiveAlgorithm;
-  using reduce_scatterv_algo_type = MPICollectiveAlgorithm;
-  using scatter_algo_type = MPICollectiveAlgorithm;
-  using scatterv_algo_type = MPICollectiveAlgorithm;
+  using allgather_algo_type = MPIAllgatherAlgorithm;
+  using allgatherv_algo_type = MPIAllgatherAlgorithm;
+  using alltoall_algo_type = MPIAlltoallAlgorithm;
+  using alltoallv_algo_type = MPIAlltoallvAlgorithm;
+  using barrier_algo_type = MPIBarrierAlgorithm;
+  using bcast_algo_type = MPIBcastAlgorithm;
+  using gather_algo_type = MPIGatherAlgorithm;
+  using gatherv_algo_type = MPIGatherAlgorithm;
+  using reduce_algo_type = MPIReduceAlgorithm;
+  using reduce_scatter_algo_type = MPIReduceScatterAlgorithm;
+  using reduce_scatterv_algo_type = MPIReduceScatterAlgorithm;
+  using scatter_algo_type = MPIScatterAlgorithm;
+  using scatterv_algo_type = MPIScatterAlgorithm;
   using comm_type = internal::mpi::MPICommunicator;
   using req_type = internal::mpi::AlMPIReq;
   static constexpr std::nullptr_t null_req = nullptr;
@@ -143,17 +499,27 @@ class MPIBackend {
                         ReductionOperator op, comm_type& comm,
                         allreduce_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::allreduce>(algo, comm, sizeof(T), count);
     switch (algo) {
       case MPIAllreduceAlgorithm::automatic:
       case MPIAllreduceAlgorithm::mpi_passthrough:
-      case MPIAllreduceAlgorithm::mpi_recursive_doubling:
-      case MPIAllreduceAlgorithm::mpi_ring:
-      case MPIAllreduceAlgorithm::mpi_rabenseifner:
-      case MPIAllreduceAlgorithm::mpi_biring:
         handle_serialized(internal::mpi::passthrough_allreduce<T>,
                           internal::mpi::passthrough_nb_allreduce<T>,
                           sendbuf, recvbuf, count, op, comm);
         break;
+      case MPIAllreduceAlgorithm::mpi_recursive_doubling:
+      case MPIAllreduceAlgorithm::mpi_rabenseifner:
+      case MPIAllreduceAlgorithm::mpi_ring:
+      case MPIAllreduceAlgorithm::mpi_biring:
+      case MPIAllreduceAlgorithm::mpi_hierarchical:
+      case MPIAllreduceAlgorithm::mpi_shm:
+        {
+          // Aluminum's algorithms always run on the progress engine.
+          req_type req;
+          NonblockingAllreduce(sendbuf, recvbuf, count, op, comm, req, algo);
+          Al::Wait<MPIBackend>(req);
+        }
+        break;
       default:
         throw_al_exception("Invalid algorithm");
     }
@@ -174,15 +540,36 @@ class MPIBackend {
       req_type& req,
       allreduce_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::allreduce>(algo, comm, sizeof(T), count);
     switch (algo) {
       case MPIAllreduceAlgorithm::automatic:
       case MPIAllreduceAlgorithm::mpi_passthrough:
+        internal::mpi::passthrough_nb_allreduce(sendbuf, recvbuf, count, op, comm,
+                                                req);
+        break;
       case MPIAllreduceAlgorithm::mpi_recursive_doubling:
-      case MPIAllreduceAlgorithm::mpi_ring:
+        internal::mpi::recursive_doubling_nb_allreduce(sendbuf, recvbuf, count,
+                                                       op, comm, req);
+        break;
       case MPIAllreduceAlgorithm::mpi_rabenseifner:
+        internal::mpi::rabenseifner_nb_allreduce(sendbuf, recvbuf, count, op,
+                                                 comm, req);
+        break;
+      case MPIAllreduceAlgorithm::mpi_ring:
+        internal::mpi::ring_nb_allreduce(sendbuf, recvbuf, count, op, comm,
+                                         false, req);
+        break;
       case MPIAllreduceAlgorithm::mpi_biring:
-        internal::mpi::passthrough_nb_allreduce(sendbuf, recvbuf, count, op, comm,
-                                                req);
+        internal::mpi::ring_nb_allreduce(sendbuf, recvbuf, count, op, comm,
+                                         true, req);
+        break;
+      case MPIAllreduceAlgorithm::mpi_hierarchical:
+        internal::mpi::hierarchical_nb_allreduce(sendbuf, recvbuf, count, op,
+                                                 comm, req);
+        break;
+      case MPIAllreduceAlgorithm::mpi_shm:
+        internal::mpi::shm_nb_allreduce(sendbuf, recvbuf, count, op, comm,
+                                        req);
         break;
       default:
         throw_al_exception("Invalid algorithm");
@@ -202,6 +589,7 @@ class MPIBackend {
   template <typename T>
   static void Send(const T* sendbuf, size_t count, int dest, comm_type& comm) {
     internal::mpi::assert_count_fits_mpi(count);
+    comm.count_send(dest, count*sizeof(T));
     handle_serialized(internal::mpi::passthrough_send<T>,
                       internal::mpi::passthrough_nb_send<T>,
                       sendbuf, count, dest, comm);
@@ -211,6 +599,7 @@ class MPIBackend {
   static void NonblockingSend(const T* sendbuf, size_t count, int dest,
                               comm_type& comm, req_type& req) {
     internal::mpi::assert_count_fits_mpi(count);
+    comm.count_send(dest, count*sizeof(T));
     internal::mpi::passthrough_nb_send(sendbuf, count, dest, comm, req);
   }
 
@@ -234,6 +623,7 @@ class MPIBackend {
                        T* recvbuf, size_t recv_count, int src, comm_type& comm) {
     internal::mpi::assert_count_fits_mpi(send_count);
     internal::mpi::assert_count_fits_mpi(recv_count);
+    comm.count_send(dest, send_count*sizeof(T));
     handle_serialized(internal::mpi::passthrough_sendrecv<T>,
                       internal::mpi::passthrough_nb_sendrecv<T>,
                       sendbuf, send_count, dest, recvbuf, recv_count, src, comm);
@@ -250,6 +640,7 @@ class MPIBackend {
                                   comm_type& comm, req_type& req) {
     internal::mpi::assert_count_fits_mpi(send_count);
     internal::mpi::assert_count_fits_mpi(recv_count);
+    comm.count_send(dest, send_count*sizeof(T));
     internal::mpi::passthrough_nb_sendrecv(sendbuf, send_count, dest,
                                            recvbuf, recv_count, src,
                                            comm, req);
@@ -271,6 +662,7 @@ class MPIBackend {
                             std::vector<int> srcs, comm_type& comm) {
     for (size_t i = 0; i < send_counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(send_counts[i]);
+      comm.count_send(dests[i], send_counts[i]*sizeof(T));
     }
     for (size_t i = 0; i < recv_counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(recv_counts[i]);
@@ -287,6 +679,7 @@ class MPIBackend {
                             std::vector<int> srcs, comm_type& comm) {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
+      comm.count_send(dests[i], counts[i]*sizeof(T));
     }
     handle_serialized(internal::mpi::passthrough_inplace_multisendrecv<T>,
                       internal::mpi::passthrough_nb_inplace_multisendrecv<T>,
@@ -303,6 +696,7 @@ class MPIBackend {
                                        req_type& req) {
     for (size_t i = 0; i < send_counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(send_counts[i]);
+      comm.count_send(dests[i], send_counts[i]*sizeof(T));
     }
     for (size_t i = 0; i < recv_counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(recv_counts[i]);
@@ -320,6 +714,7 @@ class MPIBackend {
                                        req_type& req) {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
+      comm.count_send(dests[i], counts[i]*sizeof(T));
     }
     internal::mpi::passthrough_nb_inplace_multisendrecv(
       buffers, counts, dests, srcs, comm, req);
@@ -330,12 +725,23 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count,
     comm_type& comm, allgather_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::allgather>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_allgather<T>,
                         internal::mpi::passthrough_nb_allgather<T>,
                         sendbuf, recvbuf, count, comm);
       break;
+    case MPIAllgatherAlgorithm::mpi_ring:
+    case MPIAllgatherAlgorithm::mpi_recursive_doubling:
+    case MPIAllgatherAlgorithm::mpi_bruck:
+      {
+        req_type req;
+        NonblockingAllgather(sendbuf, recvbuf, count, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -352,11 +758,23 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count,
     comm_type& comm, req_type& req, allgather_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::allgather>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_allgather(
         sendbuf, recvbuf, count, comm, req);
       break;
+    case MPIAllgatherAlgorithm::mpi_ring:
+      internal::mpi::ring_nb_allgather(sendbuf, recvbuf, count, comm, req);
+      break;
+    case MPIAllgatherAlgorithm::mpi_recursive_doubling:
+      internal::mpi::recursive_doubling_nb_allgather(
+        sendbuf, recvbuf, count, comm, req);
+      break;
+    case MPIAllgatherAlgorithm::mpi_bruck:
+      internal::mpi::bruck_nb_allgather(sendbuf, recvbuf, count, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -378,12 +796,24 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::allgatherv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_allgatherv<T>,
                         internal::mpi::passthrough_nb_allgatherv<T>,
                         sendbuf, recvbuf, counts, displs, comm);
       break;
+    case MPIAllgatherAlgorithm::mpi_ring:
+    case MPIAllgatherAlgorithm::mpi_recursive_doubling:
+    case MPIAllgatherAlgorithm::mpi_bruck:
+      {
+        req_type req;
+        NonblockingAllgatherv(sendbuf, recvbuf, counts, displs, comm, req,
+                              algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -405,11 +835,25 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::allgatherv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::automatic:
+    case MPIAllgatherAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_allgatherv(
         sendbuf, recvbuf, counts, displs, comm, req);
       break;
+    case MPIAllgatherAlgorithm::mpi_ring:
+      internal::mpi::ring_nb_allgatherv(
+        sendbuf, recvbuf, counts, displs, comm, req);
+      break;
+    case MPIAllgatherAlgorithm::mpi_recursive_doubling:
+      internal::mpi::recursive_doubling_nb_allgatherv(
+        sendbuf, recvbuf, counts, displs, comm, req);
+      break;
+    case MPIAllgatherAlgorithm::mpi_bruck:
+      internal::mpi::bruck_nb_allgatherv(
+        sendbuf, recvbuf, counts, displs, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -424,17 +868,44 @@ class MPIBackend {
                           req, algo);
   }
 
+  template <typename T>
+  static void AllgathervDynamic(
+    const T* sendbuf, size_t count, DynamicRecvBuffer<T>& recv,
+    comm_type& comm) {
+    req_type req;
+    NonblockingAllgathervDynamic(sendbuf, count, recv, comm, req);
+    Al::Wait<MPIBackend>(req);
+  }
+
+  template <typename T>
+  static void NonblockingAllgathervDynamic(
+    const T* sendbuf, size_t count, DynamicRecvBuffer<T>& recv,
+    comm_type& comm, req_type& req) {
+    internal::mpi::assert_count_fits_mpi(count);
+    internal::mpi::dynamic_nb_allgatherv(sendbuf, count, recv, comm, req);
+  }
+
   template <typename T>
   static void Alltoall(
     const T* sendbuf, T* recvbuf, size_t count,
     comm_type& comm, alltoall_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::alltoall>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAlltoallAlgorithm::automatic:
+    case MPIAlltoallAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_alltoall<T>,
                         internal::mpi::passthrough_nb_alltoall<T>,
                         sendbuf, recvbuf, count, comm);
       break;
+    case MPIAlltoallAlgorithm::mpi_bruck:
+    case MPIAlltoallAlgorithm::mpi_pairwise:
+      {
+        req_type req;
+        NonblockingAlltoall(sendbuf, recvbuf, count, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -451,11 +922,19 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count,
     comm_type& comm, req_type& req, alltoall_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::alltoall>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAlltoallAlgorithm::automatic:
+    case MPIAlltoallAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_alltoall(
         sendbuf, recvbuf, count, comm, req);
       break;
+    case MPIAlltoallAlgorithm::mpi_bruck:
+      internal::mpi::bruck_nb_alltoall(sendbuf, recvbuf, count, comm, req);
+      break;
+    case MPIAlltoallAlgorithm::mpi_pairwise:
+      internal::mpi::pairwise_nb_alltoall(sendbuf, recvbuf, count, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -480,13 +959,25 @@ class MPIBackend {
       internal::mpi::assert_count_fits_mpi(send_counts[i]);
       internal::mpi::assert_count_fits_mpi(recv_counts[i]);
     }
+    algo = select_algorithm<AlOperation::alltoallv>(algo, comm, sizeof(T), internal::mpi::sum_counts(send_counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAlltoallvAlgorithm::automatic:
+    case MPIAlltoallvAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_alltoallv<T>,
                         internal::mpi::passthrough_nb_alltoallv<T>,
                         sendbuf, send_counts, send_displs,
                         recvbuf, recv_counts, recv_displs, comm);
       break;
+    case MPIAlltoallvAlgorithm::mpi_sparse:
+    case MPIAlltoallvAlgorithm::mpi_pairwise:
+      {
+        req_type req;
+        NonblockingAlltoallv(sendbuf, send_counts, send_displs,
+                             recvbuf, recv_counts, recv_displs,
+                             comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -511,13 +1002,22 @@ class MPIBackend {
       internal::mpi::assert_count_fits_mpi(send_counts[i]);
       internal::mpi::assert_count_fits_mpi(recv_counts[i]);
     }
+    algo = select_algorithm<AlOperation::alltoallv>(algo, comm, sizeof(T), internal::mpi::sum_counts(send_counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIAlltoallvAlgorithm::automatic:
+    case MPIAlltoallvAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_alltoallv(
         sendbuf, send_counts, send_displs,
         recvbuf, recv_counts, recv_displs,
         comm, req);
       break;
+    case MPIAlltoallvAlgorithm::mpi_sparse:
+    case MPIAlltoallvAlgorithm::mpi_pairwise:
+      internal::mpi::sparse_nb_alltoallv(
+        sendbuf, send_counts, send_displs,
+        recvbuf, recv_counts, recv_displs,
+        comm, algo == MPIAlltoallvAlgorithm::mpi_pairwise, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -531,24 +1031,43 @@ class MPIBackend {
                          buffer, counts, displs, comm, req, algo);
   }
 
-  static void Barrier(comm_type& comm, barrier_algo_type algo) {
-    switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
-      handle_serialized(internal::mpi::passthrough_barrier,
-                        internal::mpi::passthrough_nb_barrier,
-                        comm);
-      break;
-    default:
-      throw_al_exception("Invalid algorithm");
+  template <typename T>
+  static void AlltoallvDynamic(
+    const T* sendbuf,
+    std::vector<size_t> send_counts, std::vector<size_t> send_displs,
+    DynamicRecvBuffer<T>& recv, comm_type& comm) {
+    req_type req;
+    NonblockingAlltoallvDynamic(sendbuf, send_counts, send_displs, recv, comm,
+                                req);
+    Al::Wait<MPIBackend>(req);
+  }
+
+  template <typename T>
+  static void NonblockingAlltoallvDynamic(
+    const T* sendbuf,
+    std::vector<size_t> send_counts, std::vector<size_t> send_displs,
+    DynamicRecvBuffer<T>& recv, comm_type& comm, req_type& req) {
+    for (size_t i = 0; i < send_counts.size(); ++i) {
+      internal::mpi::assert_count_fits_mpi(send_counts[i]);
     }
+    internal::mpi::dynamic_nb_alltoallv(sendbuf, send_counts, send_displs,
+                                        recv, comm, req);
   }
 
+  // Defined after Wait, which it uses.
+  static void Barrier(comm_type& comm, barrier_algo_type algo);
+
   static void NonblockingBarrier(comm_type& comm, req_type& req,
                                  barrier_algo_type algo) {
+    algo = select_algorithm<AlOperation::barrier>(algo, comm, 0, 0);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIBarrierAlgorithm::automatic:
+    case MPIBarrierAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_barrier(comm, req);
       break;
+    case MPIBarrierAlgorithm::mpi_hierarchical:
+      internal::mpi::hierarchical_nb_barrier(comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -558,12 +1077,24 @@ class MPIBackend {
   static void Bcast(T* buf, size_t count, int root, comm_type& comm,
                     bcast_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::bcast>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIBcastAlgorithm::automatic:
+    case MPIBcastAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_bcast<T>,
                         internal::mpi::passthrough_nb_bcast<T>,
                         buf, count, root, comm);
       break;
+    case MPIBcastAlgorithm::mpi_shm:
+    case MPIBcastAlgorithm::mpi_pipelined_chain:
+    case MPIBcastAlgorithm::mpi_binary_tree:
+    case MPIBcastAlgorithm::mpi_scatter_allgather:
+      {
+        req_type req;
+        NonblockingBcast(buf, count, root, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -574,11 +1105,25 @@ class MPIBackend {
     T* buf, size_t count, int root,
     comm_type& comm, req_type& req, bcast_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::bcast>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIBcastAlgorithm::automatic:
+    case MPIBcastAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_bcast(
         buf, count, root, comm, req);
       break;
+    case MPIBcastAlgorithm::mpi_shm:
+      internal::mpi::shm_nb_bcast(buf, count, root, comm, req);
+      break;
+    case MPIBcastAlgorithm::mpi_pipelined_chain:
+      internal::mpi::pipelined_chain_nb_bcast(buf, count, root, comm, req);
+      break;
+    case MPIBcastAlgorithm::mpi_binary_tree:
+      internal::mpi::binary_tree_nb_bcast(buf, count, root, comm, req);
+      break;
+    case MPIBcastAlgorithm::mpi_scatter_allgather:
+      internal::mpi::scatter_allgather_nb_bcast(buf, count, root, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -589,12 +1134,23 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, int root,
     comm_type& comm, gather_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::gather>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIGatherAlgorithm::automatic:
+    case MPIGatherAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_gather<T>,
                         internal::mpi::passthrough_nb_gather<T>,
                         sendbuf, recvbuf, count, root, comm);
       break;
+    case MPIGatherAlgorithm::mpi_binomial:
+    case MPIGatherAlgorithm::mpi_knomial:
+    case MPIGatherAlgorithm::mpi_flow_controlled:
+      {
+        req_type req;
+        NonblockingGather(sendbuf, recvbuf, count, root, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -611,11 +1167,25 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, int root,
     comm_type& comm, req_type& req, gather_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::gather>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIGatherAlgorithm::automatic:
+    case MPIGatherAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_gather(sendbuf, recvbuf, count, root, comm,
                                            req);
       break;
+    case MPIGatherAlgorithm::mpi_binomial:
+      internal::mpi::tree_nb_gather(sendbuf, recvbuf, count, root, 2,
+                                    comm, req);
+      break;
+    case MPIGatherAlgorithm::mpi_knomial:
+      internal::mpi::tree_nb_gather(sendbuf, recvbuf, count, root,
+                                    AL_MPI_KNOMIAL_RADIX, comm, req);
+      break;
+    case MPIGatherAlgorithm::mpi_flow_controlled:
+      internal::mpi::flow_controlled_nb_gather(sendbuf, recvbuf, count, root,
+                                               comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -637,12 +1207,24 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::gatherv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIGatherAlgorithm::automatic:
+    case MPIGatherAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_gatherv<T>,
                         internal::mpi::passthrough_nb_gatherv<T>,
                         sendbuf, recvbuf, counts, displs, root, comm);
       break;
+    case MPIGatherAlgorithm::mpi_binomial:
+    case MPIGatherAlgorithm::mpi_knomial:
+    case MPIGatherAlgorithm::mpi_flow_controlled:
+      {
+        req_type req;
+        NonblockingGatherv(sendbuf, recvbuf, counts, displs, root, comm, req,
+                           algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -664,11 +1246,25 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::gatherv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIGatherAlgorithm::automatic:
+    case MPIGatherAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_gatherv(
         sendbuf, recvbuf, counts, displs, root, comm, req);
       break;
+    case MPIGatherAlgorithm::mpi_binomial:
+      internal::mpi::tree_nb_gatherv(sendbuf, recvbuf, counts, displs, root, 2,
+                                     comm, req);
+      break;
+    case MPIGatherAlgorithm::mpi_knomial:
+      internal::mpi::tree_nb_gatherv(sendbuf, recvbuf, counts, displs, root,
+                                     AL_MPI_KNOMIAL_RADIX, comm, req);
+      break;
+    case MPIGatherAlgorithm::mpi_flow_controlled:
+      internal::mpi::flow_controlled_nb_gatherv(
+        sendbuf, recvbuf, counts, displs, root, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -688,12 +1284,22 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, ReductionOperator op, int root,
     comm_type& comm, reduce_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::reduce>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceAlgorithm::automatic:
+    case MPIReduceAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_reduce<T>,
                         internal::mpi::passthrough_nb_reduce<T>,
                         sendbuf, recvbuf, count, op, root, comm);
       break;
+    case MPIReduceAlgorithm::mpi_binomial:
+    case MPIReduceAlgorithm::mpi_knomial:
+      {
+        req_type req;
+        NonblockingReduce(sendbuf, recvbuf, count, op, root, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -711,11 +1317,21 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, ReductionOperator op, int root,
     comm_type& comm, req_type& req, reduce_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::reduce>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceAlgorithm::automatic:
+    case MPIReduceAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_reduce(sendbuf, recvbuf, count, op, root,
                                            comm, req);
       break;
+    case MPIReduceAlgorithm::mpi_binomial:
+      internal::mpi::tree_nb_reduce(sendbuf, recvbuf, count, op, root, 2,
+                                    comm, req);
+      break;
+    case MPIReduceAlgorithm::mpi_knomial:
+      internal::mpi::tree_nb_reduce(sendbuf, recvbuf, count, op, root,
+                                    AL_MPI_KNOMIAL_RADIX, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -733,12 +1349,22 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, ReductionOperator op,
     comm_type& comm, reduce_scatter_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::reduce_scatter>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_reduce_scatter<T>,
                         internal::mpi::passthrough_nb_reduce_scatter<T>,
                         sendbuf, recvbuf, count, op, comm);
       break;
+    case MPIReduceScatterAlgorithm::mpi_ring:
+    case MPIReduceScatterAlgorithm::mpi_recursive_halving:
+      {
+        req_type req;
+        NonblockingReduce_scatter(sendbuf, recvbuf, count, op, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -756,11 +1382,21 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, ReductionOperator op,
     comm_type& comm, req_type& req, reduce_scatter_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::reduce_scatter>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_reduce_scatter(sendbuf, recvbuf, count, op,
                                                    comm, req);
       break;
+    case MPIReduceScatterAlgorithm::mpi_ring:
+      internal::mpi::ring_nb_reduce_scatter(sendbuf, recvbuf, count, op,
+                                            comm, req);
+      break;
+    case MPIReduceScatterAlgorithm::mpi_recursive_halving:
+      internal::mpi::recursive_halving_nb_reduce_scatter(
+        sendbuf, recvbuf, count, op, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -782,12 +1418,23 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::reduce_scatterv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_reduce_scatterv<T>,
                         internal::mpi::passthrough_nb_reduce_scatterv<T>,
                         sendbuf, recvbuf, counts, op, comm);
       break;
+    case MPIReduceScatterAlgorithm::mpi_ring:
+    case MPIReduceScatterAlgorithm::mpi_recursive_halving:
+      {
+        req_type req;
+        NonblockingReduce_scatterv(sendbuf, recvbuf, counts, op, comm, req,
+                                   algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -809,11 +1456,21 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::reduce_scatterv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::automatic:
+    case MPIReduceScatterAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_reduce_scatterv(
         sendbuf, recvbuf, counts, op, comm, req);
       break;
+    case MPIReduceScatterAlgorithm::mpi_ring:
+      internal::mpi::ring_nb_reduce_scatterv(
+        sendbuf, recvbuf, counts, op, comm, req);
+      break;
+    case MPIReduceScatterAlgorithm::mpi_recursive_halving:
+      internal::mpi::recursive_halving_nb_reduce_scatterv(
+        sendbuf, recvbuf, counts, op, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -832,12 +1489,23 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, int root,
     comm_type& comm, scatter_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::scatter>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIScatterAlgorithm::automatic:
+    case MPIScatterAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_scatter<T>,
                         internal::mpi::passthrough_nb_scatter<T>,
                         sendbuf, recvbuf, count, root, comm);
       break;
+    case MPIScatterAlgorithm::mpi_binomial:
+    case MPIScatterAlgorithm::mpi_knomial:
+    case MPIScatterAlgorithm::mpi_flow_controlled:
+      {
+        req_type req;
+        NonblockingScatter(sendbuf, recvbuf, count, root, comm, req, algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -854,11 +1522,25 @@ class MPIBackend {
     const T* sendbuf, T* recvbuf, size_t count, int root,
     comm_type& comm, req_type& req, scatter_algo_type algo) {
     internal::mpi::assert_count_fits_mpi(count);
+    algo = select_algorithm<AlOperation::scatter>(algo, comm, sizeof(T), count);
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIScatterAlgorithm::automatic:
+    case MPIScatterAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_scatter(sendbuf, recvbuf, count, root,
                                             comm, req);
       break;
+    case MPIScatterAlgorithm::mpi_binomial:
+      internal::mpi::tree_nb_scatter(sendbuf, recvbuf, count, root, 2,
+                                     comm, req);
+      break;
+    case MPIScatterAlgorithm::mpi_knomial:
+      internal::mpi::tree_nb_scatter(sendbuf, recvbuf, count, root,
+                                     AL_MPI_KNOMIAL_RADIX, comm, req);
+      break;
+    case MPIScatterAlgorithm::mpi_flow_controlled:
+      internal::mpi::flow_controlled_nb_scatter(sendbuf, recvbuf, count, root,
+                                                comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -880,12 +1562,24 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::scatterv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIScatterAlgorithm::automatic:
+    case MPIScatterAlgorithm::mpi_passthrough:
       handle_serialized(internal::mpi::passthrough_scatterv<T>,
                         internal::mpi::passthrough_nb_scatterv<T>,
                         sendbuf, recvbuf, counts, displs, root, comm);
       break;
+    case MPIScatterAlgorithm::mpi_binomial:
+    case MPIScatterAlgorithm::mpi_knomial:
+    case MPIScatterAlgorithm::mpi_flow_controlled:
+      {
+        req_type req;
+        NonblockingScatterv(sendbuf, recvbuf, counts, displs, root, comm, req,
+                            algo);
+        Al::Wait<MPIBackend>(req);
+      }
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -907,11 +1601,25 @@ class MPIBackend {
     for (size_t i = 0; i < counts.size(); ++i) {
       internal::mpi::assert_count_fits_mpi(counts[i]);
     }
+    algo = select_algorithm<AlOperation::scatterv>(algo, comm, sizeof(T), internal::mpi::sum_counts(counts));
     switch (algo) {
-    case MPICollectiveAlgorithm::automatic:
+    case MPIScatterAlgorithm::automatic:
+    case MPIScatterAlgorithm::mpi_passthrough:
       internal::mpi::passthrough_nb_scatterv(
         sendbuf, recvbuf, counts, displs, root, comm, req);
       break;
+    case MPIScatterAlgorithm::mpi_binomial:
+      internal::mpi::tree_nb_scatterv(sendbuf, recvbuf, counts, displs, root, 2,
+                                      comm, req);
+      break;
+    case MPIScatterAlgorithm::mpi_knomial:
+      internal::mpi::tree_nb_scatterv(sendbuf, recvbuf, counts, displs, root,
+                                      AL_MPI_KNOMIAL_RADIX, comm, req);
+      break;
+    case MPIScatterAlgorithm::mpi_flow_controlled:
+      internal::mpi::flow_controlled_nb_scatterv(
+        sendbuf, recvbuf, counts, displs, root, comm, req);
+      break;
     default:
       throw_al_exception("Invalid algorithm");
     }
@@ -926,9 +1634,28 @@ class MPIBackend {
       internal::IN_PLACE<T>(), buffer, counts, displs, root, comm, req, algo);
   }
 
-  static std::string Name() { return "MPIBackend"; }
+  static const char* Name() { return "MPIBackend"; }
 
 private:
+  /**
+   * Return the algorithm to use for an operation on count elements of
+   * type_size bytes: algo, unless it is automatic, in which case the
+   * choice from comm's tuning table.
+   */
+  template <AlOperation Op, typename AlgoType>
+  static AlgoType select_algorithm(AlgoType algo, const comm_type& comm,
+                                   size_t type_size, size_t count) {
+    if (algo != AlgoType::automatic) {
+      return algo;
+    }
+    const int choice = comm.get_algo_selector().select(Op, type_size, count);
+#ifdef AL_TRACE
+    internal::trace::record_algorithm(
+      internal::mpi::algorithm_cname(Op, choice));
+#endif
+    return static_cast<AlgoType>(choice);
+  }
+
   /**
    * Handle AL_MPI_SERIALIZE support by dispatching a call to either
    * blocking_func (when not serialized) or nonblocking_func followed
@@ -976,4 +1703,25 @@ inline void Wait<MPIBackend>(typename MPIBackend::req_type& req) {
   req = MPIBackend::null_req;
 }
 
+inline void MPIBackend::Barrier(comm_type& comm, barrier_algo_type algo) {
+  algo = select_algorithm<AlOperation::barrier>(algo, comm, 0, 0);
+  switch (algo) {
+  case MPIBarrierAlgorithm::automatic:
+  case MPIBarrierAlgorithm::mpi_passthrough:
+    handle_serialized(internal::mpi::passthrough_barrier,
+                      internal::mpi::passthrough_nb_barrier,
+                      comm);
+    break;
+  case MPIBarrierAlgorithm::mpi_hierarchical:
+    {
+      req_type req;
+      NonblockingBarrier(comm, req, algo);
+      Al::Wait<MPIBackend>(req);
+    }
+    break;
+  default:
+    throw_al_exception("Invalid algorithm");
+  }
+}
+
 }  // namespace Al
@@ -850,7 +850,7 @@ class NCCLBackend {
     NonblockingScatterv(internal::IN_PLACE<T>(), buffer, counts, displs, root, comm, req, algo);
   }
 
-  static std::string Name() { return "NCCLBackend"; }
+  static const char* Name() { return "NCCLBackend"; }
 
  private:
   /** Event for synchronizing between streams. */
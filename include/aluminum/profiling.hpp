@@ -44,6 +44,11 @@
 #include <cuda_runtime.h>
 #endif
 
+// Profiling ranges and marks are only emitted when some profiler is enabled.
+#if defined AL_HAS_NVPROF || defined AL_HAS_ROCTRACER
+#define AL_HAS_PROFILING
+#endif
+
 namespace Al {
 namespace internal {
 namespace profiling {
@@ -55,8 +60,17 @@ void name_thread(std::thread::native_handle_type handle, std::string name);
 void name_stream(AlGpuStream_t stream, std::string name);
 #endif
 
-/** Create an instantaneous marker. */
-void mark(std::string desc);
+/**
+ * Create an instantaneous marker.
+ *
+ * desc must remain valid for the duration of the call; string literals
+ * are preferred, as no copy is made.
+ */
+#ifdef AL_HAS_PROFILING
+void mark(const char* desc);
+#else
+inline void mark(const char*) {}
+#endif
 
 /** Represent a range for profiling. */
 struct ProfileRange {
@@ -68,10 +82,21 @@ struct ProfileRange {
 #endif
 };
 
-/** Start a profiling region with name. */
-ProfileRange prof_start(std::string name);
+#ifdef AL_HAS_PROFILING
+/**
+ * Start a profiling region with name.
+ *
+ * name should be a string with static storage duration (e.g., a
+ * literal), so that starting a region does not allocate.
+ */
+ProfileRange prof_start(const char* name);
 /** End a profiling region. */
 void prof_end(ProfileRange range);
+#else
+// Without a profiler, these compile to nothing.
+inline ProfileRange prof_start(const char*) { return ProfileRange{}; }
+inline void prof_end(ProfileRange) {}
+#endif
 
 }  // namespace profiling
 }  // namespace internal
@@ -45,12 +45,17 @@
 #include <Al_config.hpp>
 #include "aluminum/tuning_params.hpp"
 #include "aluminum/state.hpp"
+#include "aluminum/stats.hpp"
 #ifdef AL_THREAD_MULTIPLE
 #include "aluminum/utils/mpsc_queue.hpp"
 #else
 #include "aluminum/utils/spsc_queue.hpp"
 #endif
 
+// Forward declarations from hwloc, so we do not need to include it here.
+struct hwloc_bitmap_s;
+struct hwloc_topology;
+
 namespace Al {
 namespace internal {
 
@@ -74,6 +79,27 @@ class ProgressEngine {
   void stop();
   /** Enqueue state for asynchronous execution. */
   void enqueue(AlState* state);
+  /**
+   * Pause the progress engine.
+   *
+   * Once all in-progress operations complete, the progress thread
+   * will park (sleep) and release its core binding until resume is
+   * called. Operations enqueued while paused will wake the engine,
+   * which will complete them and then park again.
+   */
+  void pause();
+  /**
+   * Resume the progress engine after a pause.
+   *
+   * This returns once the progress thread is awake and rebound.
+   */
+  void resume();
+  /** Return true if the progress thread is currently parked. */
+  bool is_parked() const { return parked_flag.load(); }
+  /** Return self-profiling statistics for the progress engine. */
+  ProgressEngineStats get_stats();
+  /** Reset self-profiling statistics. */
+  void reset_stats();
 
   /**
    * Best effort to dump progress engine state for debugging.
@@ -108,6 +134,24 @@ class ProgressEngine {
   /** Atomic flag indicating that a thread is starting the progess engine. */
   std::atomic<bool> doing_start_flag;
 #endif
+  /** Atomic flag indicating the user requested the engine pause. */
+  std::atomic<bool> pause_flag;
+  /**
+   * Atomic flag indicating the progress thread is parked (or about to).
+   *
+   * The engine sets this and then rechecks its input queues; enqueuers
+   * push and then check this. Both sides fence, so a newly-enqueued
+   * state is never missed.
+   */
+  std::atomic<bool> parked_flag;
+  /** Atomic flag indicating the progress thread is awake and bound. */
+  std::atomic<bool> awake_flag;
+  /** For park_cv. */
+  std::mutex park_mutex;
+  /** Used to wake the progress engine when it is parked. */
+  std::condition_variable park_cv;
+  /** Whether to park automatically after being idle (AL_PE_AUTO_PARK). */
+  bool auto_park = false;
   /**
    * Per-stream request queues.
    *
@@ -142,8 +186,46 @@ class ProgressEngine {
   std::unordered_map<void*, std::array<std::vector<AlState*>, AL_PE_NUM_PIPELINE_STAGES>> run_queues;
   /** Number of currently-active bounded-length operations. */
   size_t num_bounded = 0;
+  /** Number of currently-active operations of any type. */
+  size_t num_active = 0;
   /** Core to bind the progress engine to. */
   int core_to_bind = -1;
+  /** Cached topology for rebinding the progress engine. */
+  hwloc_topology* bind_topo = nullptr;
+  /** Cached cpuset for the core the progress engine is bound to. */
+  hwloc_bitmap_s* bind_coreset = nullptr;
+  /** Cached cpuset the progress thread had before binding. */
+  hwloc_bitmap_s* unbind_cpuset = nullptr;
+  /** Number of iterations of the engine loop. */
+  std::atomic<uint64_t> num_iterations;
+  /** Protects the profile data below, which is updated when sampling. */
+  std::mutex profile_mutex;
+  /** Sampled self-profiling data. */
+  struct Profile {
+    /** Time profiling started (or was reset). */
+    double start_time = 0.0;
+    /** Value of num_iterations when profiling started. */
+    uint64_t start_iterations = 0;
+    uint64_t sampled_iterations = 0;
+    uint64_t idle_samples = 0;
+    double input_scan_time = 0.0;
+    double empty_input_scan_time = 0.0;
+    /** Number of steps and time in step() for one kind of state. */
+    struct StepProfile {
+      const char* name = nullptr;
+      uint64_t num_steps = 0;
+      double time = 0.0;
+    };
+    /**
+     * Step profiles by state name.
+     *
+     * This is fixed-size so sampling never allocates; any kinds of
+     * states beyond this are lumped into the last entry.
+     */
+    std::array<StepProfile, 64> steps;
+    /** Sum and max run queue depth by stream and stage. */
+    std::unordered_map<void*, std::array<std::pair<uint64_t, size_t>, AL_PE_NUM_PIPELINE_STAGES>> depths;
+  } profile;
 #ifdef AL_HAS_CUDA
   /** Used to pass the original CUDA device to the progress engine thread. */
   std::atomic<int> cur_device;
@@ -156,6 +238,21 @@ class ProgressEngine {
    * If there are multiple ranks per NUMA node, they get the last-1, etc. core.
    */
   void bind();
+  /** Undo bind, returning the progress thread to its original cpuset. */
+  void unbind();
+  /** Add state to the appropriate input queue. */
+  void push_request(AlState* state);
+  /** Return true if there are no requests in any input queue. */
+  bool input_queues_empty();
+  /** Wake the progress engine if it is parked. */
+  void wake();
+  /**
+   * Park the progress engine until woken.
+   * Returns immediately if there are pending requests.
+   */
+  void park();
+  /** Compute stats from the profile (profile_mutex must be held). */
+  ProgressEngineStats compute_stats();
   /** This is the main progress engine loop. */
   void engine();
 };
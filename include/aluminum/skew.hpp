@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include <mpi.h>
+
+#include <Al_config.hpp>
+#include "aluminum/tuning_params.hpp"
+#include "aluminum/utils/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace skew {
+
+/**
+ * Return true if skew detection is enabled.
+ *
+ * This is set by the AL_SKEW environment variable at initialization;
+ * only communicators created after that record arrivals.
+ */
+bool skew_enabled();
+
+/**
+ * Set up skew detection if AL_SKEW is set.
+ *
+ * This estimates the offset of this rank's clock from rank 0 of
+ * world_comm, and is collective over it.
+ */
+void init(MPI_Comm world_comm);
+/** Clean up skew detection. */
+void finalize();
+
+/** Offset to add to get_time() to align it with world rank 0's clock. */
+extern double clock_offset;
+
+/**
+ * Record of when this rank called each collective on one communicator.
+ *
+ * Arrival times are kept for windows of AL_SKEW_WINDOW operations.
+ * When a window fills, it is gathered to rank 0 of the communicator with
+ * a nonblocking gather, which is completed when the next window fills,
+ * so the exchange stays off the critical path. Rank 0 then computes the
+ * skew of each operation and which rank arrived last. A partial window
+ * at destruction is dropped.
+ *
+ * This relies on collectives being called in the same order on every
+ * rank, and is only used by the thread calling operations.
+ */
+class ArrivalLog {
+ public:
+  /** Set up logging for comm (which is duplicated). */
+  ArrivalLog(MPI_Comm comm);
+  ArrivalLog(const ArrivalLog&) = delete;
+  ArrivalLog& operator=(const ArrivalLog&) = delete;
+  /** Complete any pending exchange. */
+  ~ArrivalLog();
+
+  /** Record a call to op, which must have static storage duration. */
+  void record(const char* op) {
+    names[num_arrivals % AL_SKEW_WINDOW] = op;
+    times[num_arrivals % AL_SKEW_WINDOW] = get_time() + clock_offset;
+    ++num_arrivals;
+    if (num_arrivals % AL_SKEW_WINDOW == 0) {
+      exchange();
+    }
+  }
+
+ private:
+  /** Complete the pending gather, then start one for the current window. */
+  void exchange();
+  /** Complete the pending gather and process it on rank 0. */
+  void finish_exchange();
+
+  /** Private communicator for exchanging arrival times. */
+  MPI_Comm comm = MPI_COMM_NULL;
+  /** Rank in comm. */
+  int rank;
+  /** Rank in the world communicator of each rank of comm. */
+  std::vector<int> world_ranks;
+  /** Number of calls recorded. */
+  size_t num_arrivals = 0;
+  /** Operations and times in the current window. */
+  std::vector<const char*> names;
+  std::vector<double> times;
+  /** Operations and times in the window being exchanged. */
+  std::vector<const char*> pending_names;
+  std::vector<double> pending_times;
+  /** Times from every rank for the pending window (on rank 0). */
+  std::vector<double> all_times;
+  /** Request for the pending gather. */
+  MPI_Request req = MPI_REQUEST_NULL;
+};
+
+/** Return true if op is a point-to-point operation. */
+inline bool is_peer_op(const char* op) {
+  return std::strstr(op, "send") != nullptr || std::strstr(op, "recv") != nullptr;
+}
+
+/** Record the calling rank's arrival at op on comm, if enabled. */
+template <typename Comm>
+void record_arrival(const char* op, const Comm& comm) {
+  ArrivalLog* log = comm.get_arrival_log();
+  if (log != nullptr && !is_peer_op(op)) {
+    log->record(op);
+  }
+}
+
+/** Write a human-readable summary of skew and straggler stats to os. */
+std::ostream& write_skew_stats(std::ostream& os);
+
+/**
+ * Write skew stats to hostname.pid.skew.txt, if AL_SKEW is set and this
+ * rank has any.
+ */
+void write_skew_stats_to_file();
+
+}  // namespace skew
+}  // namespace internal
+}  // namespace Al
@@ -29,6 +29,7 @@
 
 #include <memory>
 #include <atomic>
+#include <limits>
 
 #include "aluminum/profiling.hpp"
 
@@ -93,15 +94,31 @@ class AlState {
   virtual void* get_compute_stream() const { return DEFAULT_STREAM; }
   /** Return the run queue type this operation should use. */
   virtual RunType get_run_type() const { return RunType::bounded; }
-  /** Return a name identifying the state (for debugging/info purposes). */
-  virtual std::string get_name() const { return "AlState"; }
+  /**
+   * Return a name identifying the state (for debugging/info purposes).
+   *
+   * This is used for profiling ranges on every operation, so it must be
+   * a string with static storage duration (e.g., a literal) and must not
+   * allocate.
+   */
+  virtual const char* get_name() const { return "AlState"; }
   /** Return a string description of the state (for debugging/info purposes). */
   virtual std::string get_desc() const { return ""; }
+  /**
+   * Return the size of the operation in bytes (for statistics).
+   *
+   * This is the size of the local buffer the caller passed (for vector
+   * operations, the sum of the counts).
+   */
+  virtual size_t get_bytes() const { return 0; }
  private:
 #ifdef AL_DEBUG_HANG_CHECK
   bool hang_reported = false;
-  double start_time = std::numeric_limits<double>::max();
 #endif
+  /** Time the operation was enqueued to the progress engine. */
+  double enqueue_time = 0.0;
+  /** Time the operation was started by the progress engine. */
+  double start_time = std::numeric_limits<double>::max();
   profiling::ProfileRange prof_range;
   /** Whether execution of this operation is paused on pipeline advancement. */
   bool paused_for_advance = false;
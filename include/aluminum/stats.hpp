@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Al {
+
+/**
+ * Histogram of non-negative integer values (e.g., nanoseconds).
+ *
+ * Buckets are log-linear, as in HDR histograms: each power of two is
+ * split into four equal-width sub-buckets, so any recorded value is
+ * within 25% of its bucket's lower bound.
+ */
+struct Histogram {
+  /** Sub-buckets per power of two (log2). */
+  static constexpr size_t sub_bucket_bits = 2;
+  static constexpr size_t num_sub_buckets = size_t{1} << sub_bucket_bits;
+  /** Total number of buckets, enough for any 64-bit value. */
+  static constexpr size_t num_buckets = num_sub_buckets * (64 - sub_bucket_bits + 1);
+
+  /** Return the bucket value belongs in. */
+  static size_t bucket_index(uint64_t value) {
+    if (value < num_sub_buckets) {
+      return static_cast<size_t>(value);
+    }
+    const size_t msb = 63 - __builtin_clzll(value);
+    const size_t shift = msb - sub_bucket_bits;
+    return num_sub_buckets * (shift + 1)
+      + static_cast<size_t>((value >> shift) & (num_sub_buckets - 1));
+  }
+  /** Return the smallest value that belongs in bucket. */
+  static uint64_t bucket_lower_bound(size_t bucket) {
+    if (bucket < num_sub_buckets) {
+      return bucket;
+    }
+    const size_t shift = bucket / num_sub_buckets - 1;
+    return (num_sub_buckets + bucket % num_sub_buckets) << shift;
+  }
+
+  /** Number of values in each bucket. */
+  std::array<uint64_t, num_buckets> buckets = {};
+  /** Total number of values. */
+  uint64_t count = 0;
+  /** Sum of all values. */
+  uint64_t sum = 0;
+
+  /** Add value to the histogram. */
+  void add(uint64_t value) {
+    ++buckets[bucket_index(value)];
+    ++count;
+    sum += value;
+  }
+  /** Return the mean value, or 0 if empty. */
+  double mean() const {
+    return count ? static_cast<double>(sum) / count : 0.0;
+  }
+  /**
+   * Return (the lower bound of the bucket of) the value at percentile p
+   * (in [0, 100]), or 0 if empty.
+   */
+  uint64_t percentile(double p) const;
+};
+
+/**
+ * Statistics for one kind of operation (e.g., "MPIAllreduce") in one
+ * size class.
+ *
+ * Only operations run by the progress engine are included.
+ */
+struct OpStats {
+  /** Name of the operation (as from AlState::get_name()). */
+  const char* name;
+  /**
+   * Size class: 0 for operations of 0 bytes, otherwise k such that the
+   * size is in [2^(k-1), 2^k) bytes.
+   */
+  size_t size_class;
+  /** Number of operations completed. */
+  uint64_t num_ops;
+  /** Total bytes over all operations. */
+  uint64_t bytes;
+  /** Time (ns) from enqueue to being started by the progress engine. */
+  Histogram queue_ns;
+  /** Time (ns) from being started to completion. */
+  Histogram exec_ns;
+};
+
+/**
+ * Statistics on the progress engine itself.
+ *
+ * Iterations are counted exactly. Everything else is measured only on
+ * every AL_PE_PROFILE_SAMPLE_INTERVAL-th iteration of the progress
+ * engine loop, to keep the cost negligible; times are extrapolated to
+ * all iterations.
+ */
+struct ProgressEngineStats {
+  /** Time spent in step() by one kind of state. */
+  struct StepStats {
+    /** Name of the state (as from AlState::get_name()). */
+    const char* name;
+    /** Number of sampled calls to step(). */
+    uint64_t sampled_steps;
+    /** Estimated total time (seconds) in step(). */
+    double seconds;
+  };
+  /** Depth of one pipeline stage's run queue for one stream. */
+  struct QueueDepthStats {
+    /** Compute stream. */
+    void* stream;
+    /** Pipeline stage. */
+    size_t stage;
+    /** Mean number of operations in the run queue when sampled. */
+    double mean_depth;
+    /** Max number of operations in the run queue when sampled. */
+    size_t max_depth;
+  };
+
+  /** Time (seconds) statistics have been collected over. */
+  double elapsed = 0.0;
+  /** Number of iterations of the progress engine loop. */
+  uint64_t iterations = 0;
+  /** Iterations per second. */
+  double iterations_per_second = 0.0;
+  /** Number of iterations that were sampled. */
+  uint64_t sampled_iterations = 0;
+  /** Fraction of sampled iterations with no operations running. */
+  double idle_fraction = 0.0;
+  /** Estimated time (seconds) scanning input queues, in total. */
+  double input_scan_seconds = 0.0;
+  /** Estimated time (seconds) scanning input queues that were all empty. */
+  double empty_input_scan_seconds = 0.0;
+  /** Time in step() by state. */
+  std::vector<StepStats> steps;
+  /** Run queue depths by stream and pipeline stage. */
+  std::vector<QueueDepthStats> queue_depths;
+};
+
+/** Write a human-readable summary of progress engine stats to os. */
+std::ostream& operator<<(std::ostream& os, const ProgressEngineStats& stats);
+
+/**
+ * Arrival skew for one kind of collective (e.g., "allreduce").
+ *
+ * Skew is the time between the first and the last rank calling the
+ * operation, with clocks aligned across ranks.
+ */
+struct SkewStats {
+  /** Name of the operation (as passed to trace::record_op()). */
+  const char* name;
+  /** Number of operations. */
+  uint64_t num_ops;
+  /** Skew (ns). */
+  Histogram skew_ns;
+};
+
+/**
+ * Samples of one MPI_T performance variable.
+ *
+ * Variables with multiple elements (e.g., one per peer) are summed.
+ */
+struct MPIPvarStats {
+  /** Name of the variable. */
+  std::string name;
+  /** Class of the variable (e.g., MPI_T_PVAR_CLASS_COUNTER). */
+  int var_class;
+  /** Number of samples. */
+  uint64_t num_samples;
+  /** First and most recent values. */
+  double first;
+  double last;
+  /** Minimum, maximum, and mean over all samples. */
+  double min;
+  double max;
+  double mean;
+};
+
+/** How often one rank was the last to arrive at collectives. */
+struct StragglerStats {
+  /** Rank in Aluminum's world communicator. */
+  int rank;
+  /** Number of operations this rank arrived at last. */
+  uint64_t times_last;
+  /** Total time (seconds) this rank arrived after the first rank. */
+  double late_seconds;
+};
+
+namespace internal {
+namespace stats {
+
+/** Return the size class for an operation of bytes. */
+inline size_t size_class(size_t bytes) {
+  return bytes ? 64 - __builtin_clzll(bytes) : 0;
+}
+
+/**
+ * Record a completed operation.
+ *
+ * Times are as from get_time(). This is meant to be called only by the
+ * progress engine thread.
+ */
+void record_op(const char* name, size_t bytes,
+               double enqueue_time, double start_time, double end_time);
+
+/** Write a human-readable summary of stats to os. */
+std::ostream& write_op_stats(std::ostream& os, const std::vector<OpStats>& stats);
+
+/** Write stats to hostname.pid.opstats.txt, if AL_OP_STATS is set. */
+void write_op_stats_to_file();
+
+}  // namespace stats
+}  // namespace internal
+}  // namespace Al
@@ -27,80 +27,236 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
-#include <string>
-#include <sstream>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <type_traits>
 #include <typeinfo>
-#include <utility>
 #include <vector>
 
 #include <Al_config.hpp>
+#include "aluminum/skew.hpp"
+#include "aluminum/tuning_params.hpp"
 #include "aluminum/utils/utils.hpp"
 
 namespace Al {
 namespace internal {
-// Forward declaration.
 class AlState;
 namespace trace {
 
-#ifdef AL_TRACE
-// Need to be able to print vectors.
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const std::vector<T>& v) {
-  os << "[";
-  if (!v.empty()) {
-    for (size_t i = 0; i < v.size() - 1; ++i) {
-      os << v[i] << ", ";
+/** Kinds of events recorded in the trace. */
+enum class TraceEventKind : uint8_t {
+  /** A user called an operation. */
+  op,
+  /** An operation was enqueued to the progress engine. */
+  pe_enqueue,
+  /** The progress engine started an operation. */
+  pe_start,
+  /** An operation advanced to its next pipeline stage. */
+  pe_advance,
+  /** The progress engine completed an operation. */
+  pe_done,
+  /** An algorithm was selected for the thread's last operation. */
+  algo
+};
+
+/**
+ * A single compact trace record.
+ *
+ * This is plain data: strings are pointers to static storage (string
+ * literals, type_info) and are only decoded when the trace is written.
+ */
+struct TraceRecord {
+  /** Time the event was recorded (as from get_time()). */
+  double time;
+  /** Operation name (user ops) or state name (progress engine). */
+  const char* name;
+  /** Backend name (user ops only). */
+  const char* backend;
+  /** Datatype (user ops only). */
+  const std::type_info* type;
+  /** Communicator (user ops) or state (progress engine). */
+  const void* comm;
+  /** Compute stream. */
+  uintptr_t stream;
+  /**
+   * Number of elements (sum, for vector operations), or the new pipeline
+   * stage for pe_advance.
+   */
+  size_t count;
+  /** Rank in comm. */
+  int rank;
+  /** Size of comm. */
+  int comm_size;
+  /** Root or peer of the operation, or -1 if none. */
+  int peer;
+  /** Kind of event. */
+  TraceEventKind kind;
+};
+
+/**
+ * Fixed-size ring buffer of trace records for a single thread.
+ *
+ * Only the owning thread writes; when full, the oldest records are
+ * overwritten. Readers (when writing the trace) may run concurrently,
+ * but may then see a torn record that is being overwritten.
+ */
+struct TraceBuffer {
+  static_assert((AL_TRACE_BUFFER_ENTRIES & (AL_TRACE_BUFFER_ENTRIES - 1)) == 0,
+                "AL_TRACE_BUFFER_ENTRIES must be a power of 2");
+  static constexpr size_t mask = AL_TRACE_BUFFER_ENTRIES - 1;
+
+  TraceBuffer(size_t thread_idx_) :
+    records(new TraceRecord[AL_TRACE_BUFFER_ENTRIES]),
+    thread_idx(thread_idx_) {}
+
+  /** Add a record, overwriting the oldest one if full. */
+  void push(const TraceRecord& record) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    records[h & mask] = record;
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  /** Storage for records. */
+  std::unique_ptr<TraceRecord[]> records;
+  /** Total number of records ever pushed. */
+  std::atomic<size_t> head{0};
+  /** Index of the owning thread, in order of first trace event. */
+  size_t thread_idx;
+};
+
+/** Allocate and register a trace buffer for the calling thread. */
+TraceBuffer* register_thread_buffer();
+
+/** Trace buffer for the calling thread, allocated on first use. */
+extern thread_local TraceBuffer* thread_buffer;
+
+/** Save record to the calling thread's trace buffer. */
+inline void save_trace_record(const TraceRecord& record) {
+  TraceBuffer* buf = thread_buffer;
+  if (buf == nullptr) {
+    buf = register_thread_buffer();
+  }
+  buf->push(record);
+}
+
+/** Extracts the count and peer of an operation from its arguments. */
+struct OpArgSummary {
+  size_t count = 0;
+  int peer = -1;
+  bool have_count = false;
+
+  // The first count (or vector of counts) gives the count, and the
+  // first int gives the root or peer. Everything else is ignored.
+  void add(size_t c) {
+    if (!have_count) {
+      count = c;
+      have_count = true;
+    }
+  }
+  void add(const std::vector<size_t>& counts) {
+    if (!have_count) {
+      for (const auto& c : counts) {
+        count += c;
+      }
+      have_count = true;
     }
-    os << v[v.size() - 1];
   }
-  os << "]";
-  return os;
+  void add(int p) {
+    if (peer < 0) {
+      peer = p;
+    }
+  }
+  template <typename U>
+  void add(const U&) {}
+};
+
+/** Convert a compute stream to an integer identifier. */
+template <typename Stream>
+uintptr_t stream_to_id(const Stream& stream) {
+  if constexpr (std::is_pointer_v<Stream>) {
+    return reinterpret_cast<uintptr_t>(stream);
+  } else if constexpr (std::is_integral_v<Stream>) {
+    return static_cast<uintptr_t>(stream);
+  } else {
+    return 0;
+  }
 }
-#endif
 
 /**
- * Save entry to the trace log.
- * progress is whether this comes from the progress engine, which is recorded
- * separately.
+ * Record an operation to the trace log.
+ *
+ * This also records the arrival of this rank at collectives when skew
+ * detection is enabled.
+ *
+ * op must be a string with static storage duration.
  */
-void save_trace_entry(std::string entry, bool progress = false);
-
-/** Record an operation to the trace log. */
 template <typename Backend, typename T, typename... Args>
 #ifdef AL_TRACE
-void record_op(std::string const& op,
+void record_op(const char* op,
                typename Backend::comm_type const& comm,
                Args&&... args) {
-  std::ostringstream ss;
-  ss << static_cast<size_t>(get_time()) << ": "
-     << Backend::Name() << " "
-     << comm.get_stream() << " "
-     << typeid(T).name() << " "
-     << op << " "
-     << comm.rank() << " " << comm.size() << " ";
-
-  // See:
-  // https://stackoverflow.com/questions/27375089/what-is-the-easiest-way-to-print-a-variadic-parameter-pack-using-stdostream
-  using expander = int[];
-  (void) expander{0, (void(ss << " " << std::forward<Args>(args)), 0)...};
-  save_trace_entry(ss.str(), false);
+  skew::record_arrival(op, comm);
+  OpArgSummary summary;
+  (summary.add(args), ...);
+  TraceRecord record;
+  record.time = get_time();
+  record.name = op;
+  record.backend = Backend::Name();
+  record.type = &typeid(T);
+  record.comm = &comm;
+  record.stream = stream_to_id(comm.get_stream());
+  record.count = summary.count;
+  record.rank = comm.rank();
+  record.comm_size = comm.size();
+  record.peer = summary.peer;
+  record.kind = TraceEventKind::op;
+  save_trace_record(record);
 }
 #else  // AL_TRACE
-void record_op(std::string const&,
-               typename Backend::comm_type const&,
+void record_op(const char* op,
+               typename Backend::comm_type const& comm,
                Args&&...) {
+  skew::record_arrival(op, comm);
 }
 #endif  // AL_TRACE
 
+/**
+ * Record the algorithm automatically selected for the calling thread's
+ * last operation.
+ *
+ * algo must be a string with static storage duration.
+ */
+void record_algorithm(const char* algo);
+/** Record an operation being enqueued to the progress engine. */
+void record_pe_enqueue(const AlState& state);
 /** Record a progress engine operation start to the trace log. */
 void record_pe_start(const AlState& state);
+/** Record a progress engine operation advancing to stage. */
+void record_pe_advance(const AlState& state, size_t stage);
 /** Record a progress engine operation completion to the trace log. */
 void record_pe_done(const AlState& state);
 
-/** Write trace logs to os. */
+/** Decode trace logs and write them to os. */
 std::ostream& write_trace_log(std::ostream& os);
-/** Write trace logs to hostname.pid.trace.txt. */
+/**
+ * Decode trace logs and write them to os in Chrome trace-event JSON.
+ *
+ * This can be viewed with chrome://tracing or Perfetto. Each rank is a
+ * process (pid is the world rank), so files from different ranks can be
+ * merged by concatenating their traceEvents (see util/merge_traces.py).
+ * User calls are on their calling thread, and each progress engine
+ * operation is a slice on a track for its compute stream, with child
+ * slices for time queued and each pipeline stage. Flow events link each
+ * call to the operation it enqueued.
+ */
+std::ostream& write_chrome_trace(std::ostream& os);
+/**
+ * Write trace logs to hostname.pid.trace.txt and, in Chrome trace-event
+ * format, hostname.pid.trace.json.
+ */
 void write_trace_to_file();
 
 }  // namespace trace
@@ -39,6 +39,7 @@
 
 #include <Al_config.hpp>
 #include "aluminum/mempool.hpp"
+#include "aluminum/mpi/comm_matrix.hpp"
 #include "aluminum/progress.hpp"
 #include "aluminum/trace.hpp"
 #ifdef AL_HAS_CUDA
@@ -185,14 +186,50 @@ void Finalize() {
   // Clear host memory pool.
   internal::mempool.clear();
   is_initialized = false;
-  internal::mpi::finalize();
+  internal::stats::write_op_stats_to_file();
+  if (internal::mpi::comm_matrix_enabled()) {
+    internal::mpi::write_comm_matrix("al_comm_matrix.txt");
+  }
+  // Write the trace while the world communicator is still around.
   internal::trace::write_trace_to_file();
+  internal::mpi::finalize();
+  // This is after the world communicator's final exchange of arrivals.
+  internal::skew::write_skew_stats_to_file();
 }
 
 bool Initialized() {
   return is_initialized;
 }
 
+void PauseProgress() {
+  if (progress_engine) {
+    progress_engine->pause();
+  }
+}
+
+void ResumeProgress() {
+  if (progress_engine) {
+    progress_engine->resume();
+  }
+}
+
+void WriteCommMatrix(const std::string& filename) {
+  internal::mpi::write_comm_matrix(filename);
+}
+
+ProgressEngineStats GetProgressEngineStats() {
+  if (progress_engine) {
+    return progress_engine->get_stats();
+  }
+  return ProgressEngineStats{};
+}
+
+void ResetProgressEngineStats() {
+  if (progress_engine) {
+    progress_engine->reset_stats();
+  }
+}
+
 namespace internal {
 
 // Note: This is declared in progress.hpp.
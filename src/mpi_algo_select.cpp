@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/mpi/algo_select.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Al.hpp"
+#include "aluminum/mpi/calibration.hpp"
+#include "aluminum/traits/traits.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+namespace {
+
+/** An inclusive range of values; "*" is everything. */
+struct Range {
+  size_t lo = 0;
+  size_t hi = std::numeric_limits<size_t>::max();
+  bool contains(size_t v) const { return v >= lo && v <= hi; }
+};
+
+/** One rule of the tuning table. */
+struct Rule {
+  AlOperation op;
+  Range type_size;
+  Range comm_size;
+  Range ranks_per_node;
+  size_t min_bytes;
+  size_t max_bytes;
+  int algo;
+};
+
+/** Names of each operation and its algorithms, indexed by enum value. */
+struct OpAlgos {
+  const char* name;
+  std::vector<std::string> algos;
+};
+
+/** Return the names of every operation's algorithms. */
+template <AlOperation Op>
+OpAlgos get_op_algos() {
+  OpAlgos op_algos;
+  op_algos.name = AlOperationName<Op>;
+  if constexpr (OpSupportsAlgos<Op>::value) {
+    using algo_type = typename OpAlgoType<Op, MPIBackend>::type;
+    for (int i = 0; ; ++i) {
+      std::string name = algorithm_name(static_cast<algo_type>(i));
+      if (name == "unknown") {
+        break;
+      }
+      op_algos.algos.push_back(name);
+    }
+  } else {
+    op_algos.algos.push_back("automatic");
+  }
+  return op_algos;
+}
+
+/** Names of all operations and algorithms, indexed by AlOperation. */
+const std::vector<OpAlgos>& all_op_algos() {
+  static const std::vector<OpAlgos> ops = {
+    get_op_algos<AlOperation::allgather>(),
+    get_op_algos<AlOperation::allgatherv>(),
+    get_op_algos<AlOperation::allreduce>(),
+    get_op_algos<AlOperation::alltoall>(),
+    get_op_algos<AlOperation::alltoallv>(),
+    get_op_algos<AlOperation::barrier>(),
+    get_op_algos<AlOperation::bcast>(),
+    get_op_algos<AlOperation::gather>(),
+    get_op_algos<AlOperation::gatherv>(),
+    get_op_algos<AlOperation::reduce>(),
+    get_op_algos<AlOperation::reduce_scatter>(),
+    get_op_algos<AlOperation::reduce_scatterv>(),
+    get_op_algos<AlOperation::scatter>(),
+    get_op_algos<AlOperation::scatterv>(),
+    get_op_algos<AlOperation::send>(),
+    get_op_algos<AlOperation::recv>(),
+    get_op_algos<AlOperation::sendrecv>(),
+    get_op_algos<AlOperation::multisendrecv>()
+  };
+  return ops;
+}
+
+/** Rules of the tuning table, in order. */
+std::vector<Rule> rules;
+
+/** Parse a range field; return false if it is malformed. */
+bool parse_range(const std::string& s, Range& range) {
+  if (s == "*") {
+    return true;
+  }
+  try {
+    size_t pos;
+    range.lo = std::stoull(s, &pos);
+    if (pos == s.size()) {
+      range.hi = range.lo;
+    } else if (s[pos] == '-') {
+      if (pos + 1 < s.size()) {
+        size_t end;
+        range.hi = std::stoull(s.substr(pos + 1), &end);
+        return pos + 1 + end == s.size();
+      }
+    } else {
+      return false;
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Native algorithms must be predicted to beat passing through to MPI by
+ * this factor to be chosen, since MPI's own algorithms are tuned in ways
+ * the model does not capture.
+ */
+constexpr double model_margin = 0.9;
+
+/**
+ * Return the algorithm the network model predicts is fastest for op on
+ * bytes, or 0 (automatic) for passing through to MPI.
+ *
+ * Ranks are assumed to be placed by node, so exchanges at distances of
+ * at least ranks_per_node cross nodes, and when every rank on a node
+ * does so at once they share its link. MPI is assumed to use the better
+ * of recursive doubling and Rabenseifner's algorithm (for allreduce),
+ * of a binomial tree and scatter-allgather (for broadcast), to
+ * exchange with every peer directly (for alltoall), and to use a
+ * dissemination barrier.
+ */
+int predict_algorithm(AlOperation op, size_t bytes, int comm_size,
+                      int ranks_per_node, const NetworkModel& model) {
+  const int p = comm_size;
+  const int ppn = std::min(ranks_per_node, comm_size);
+  const bool multi_node = ppn < p;
+  if (p < 2 || (ppn > 1 && !model.intra.valid)
+      || (multi_node && !model.inter.valid)) {
+    return 0;
+  }
+  const LinkModel& intra = model.intra;
+  const LinkModel& inter = model.inter;
+  LinkModel shared_inter = inter;
+  shared_inter.G *= ppn;
+  // One message of n bytes at distance, with every rank sending.
+  auto exchange = [&](int distance, double n) {
+    return (multi_node && distance >= ppn) ? shared_inter.time(n)
+      : intra.time(n);
+  };
+  // Links a ring crosses; only one rank per node crosses nodes.
+  const LinkModel& ring_link = multi_node ? inter : intra;
+  int pof2 = 1;
+  while (pof2 * 2 <= p) {
+    pof2 *= 2;
+  }
+  const double n = static_cast<double>(bytes);
+  // Non-powers of two fold extra ranks in before and out after.
+  const double fold = (pof2 < p) ? 2 * exchange(pof2, n) : 0.0;
+  int chosen = 0;
+
+  if (op == AlOperation::allreduce) {
+    double recursive_doubling = fold;
+    double rabenseifner = fold;
+    for (int distance = 1; distance < pof2; distance *= 2) {
+      recursive_doubling += exchange(distance, n);
+      rabenseifner += 2 * exchange(distance, n / (2 * distance));
+    }
+    // MPI's own versions of these are assumed to be at least as fast.
+    double best = model_margin * std::min(recursive_doubling, rabenseifner);
+    auto consider = [&](double time, MPIAllreduceAlgorithm algo) {
+      if (time < best) {
+        best = time;
+        chosen = static_cast<int>(algo);
+      }
+    };
+    consider(2 * (p - 1) * ring_link.time(n / p),
+             MPIAllreduceAlgorithm::mpi_ring);
+    if (multi_node && ppn > 1) {
+      // Reduce-scatter and allgather on each node, with an allreduce of
+      // each shard across nodes in between.
+      const double shard = n / ppn;
+      double hierarchical = 2 * (ppn - 1) * intra.time(shard);
+      for (int nodes = 1; nodes < p / ppn; nodes *= 2) {
+        hierarchical += 2 * shared_inter.time(shard / (2 * nodes));
+      }
+      consider(hierarchical, MPIAllreduceAlgorithm::mpi_hierarchical);
+    }
+  } else if (op == AlOperation::bcast) {
+    int log_p = 0;
+    while ((1 << log_p) < p) {
+      ++log_p;
+    }
+    const double binomial = log_p * ring_link.time(n);
+    const double scatter_allgather =
+      log_p * ring_link.time(n / p) + (p - 1) * ring_link.time(n / p);
+    double best = model_margin * std::min(binomial, scatter_allgather);
+    auto consider = [&](double time, MPIBcastAlgorithm algo) {
+      if (time < best) {
+        best = time;
+        chosen = static_cast<int>(algo);
+      }
+    };
+    // Pipelines take one stage per level of the tree to fill, then one
+    // per remaining segment; tree stages send to two children.
+    const double seg = std::min<double>(n, AL_MPI_BCAST_SEGMENT_BYTES);
+    const double num_segs = std::max(std::ceil(n / seg), 1.0);
+    consider((p - 2 + num_segs) * ring_link.time(seg),
+             MPIBcastAlgorithm::mpi_pipelined_chain);
+    int tree_depth = 0;
+    while ((2 << tree_depth) <= p) {
+      ++tree_depth;
+    }
+    consider((tree_depth - 1 + num_segs) * 2 * ring_link.time(seg),
+             MPIBcastAlgorithm::mpi_binary_tree);
+    if (!multi_node) {
+      // The root copies in and every rank copies out, with a flag
+      // handoff before each.
+      consider(2 * intra.L + n * intra.G, MPIBcastAlgorithm::mpi_shm);
+    }
+  } else if (op == AlOperation::barrier) {
+    // MPI is assumed to use a dissemination barrier over all ranks.
+    double dissemination = 0.0;
+    for (int distance = 1; distance < p; distance *= 2) {
+      dissemination += exchange(distance, 0.0);
+    }
+    // Arrival and release each take a flag handoff on the node, with a
+    // dissemination among node leaders in between.
+    double hierarchical = ppn > 1 ? 2 * intra.L : 0.0;
+    for (int distance = 1; distance * ppn < p; distance *= 2) {
+      hierarchical += inter.time(0.0);
+    }
+    if (hierarchical < model_margin * dissemination) {
+      chosen = static_cast<int>(MPIBarrierAlgorithm::mpi_hierarchical);
+    }
+  } else if (op == AlOperation::alltoall) {
+    // Here n is the block for each peer. MPI is assumed to exchange with
+    // every peer directly.
+    double direct = 0.0;
+    for (int distance = 1; distance < p; ++distance) {
+      direct += exchange(distance, n);
+    }
+    // Bruck sends about half the blocks each step and packs and unpacks
+    // them locally.
+    double bruck = 0.0;
+    for (int distance = 1; distance < p; distance *= 2) {
+      bruck += exchange(distance, n * (p / 2)) + n * p * intra.G;
+    }
+    if (bruck < model_margin * direct) {
+      chosen = static_cast<int>(MPIAlltoallAlgorithm::mpi_bruck);
+    } else if (p - 1 > AL_MPI_ALLTOALL_WINDOW) {
+      // The model does not capture the contention of posting every
+      // exchange at once, which the bounded window avoids.
+      chosen = static_cast<int>(MPIAlltoallAlgorithm::mpi_pairwise);
+    }
+  }
+  return chosen;
+}
+
+}  // anonymous namespace
+
+bool have_tuning_rules() {
+  return !rules.empty();
+}
+
+AlgoSelector::AlgoSelector(int comm_size, int ranks_per_node) {
+  static constexpr size_t type_sizes[num_type_sizes] = {1, 2, 4, 8, 16, 0};
+  for (size_t op = 0; op < num_ops; ++op) {
+    for (size_t b = 0; b < num_buckets; ++b) {
+      const size_t bytes = b ? size_t{1} << (b - 1) : 0;
+      if (rules.empty()) {
+        // Without a table, fall back to the network model, which does
+        // not depend on the datatype.
+        const int choice = predict_algorithm(
+          static_cast<AlOperation>(op), bytes, comm_size, ranks_per_node,
+          get_network_model());
+        for (size_t t = 0; t < num_type_sizes; ++t) {
+          choices[op][t][b] = static_cast<uint8_t>(choice);
+        }
+        continue;
+      }
+      for (size_t t = 0; t < num_type_sizes; ++t) {
+        choices[op][t][b] = 0;
+        for (const auto& rule : rules) {
+          if (static_cast<size_t>(rule.op) == op
+              // Other datatype sizes only match "*".
+              && (type_sizes[t] ? rule.type_size.contains(type_sizes[t])
+                  : rule.type_size.lo == 0)
+              && rule.comm_size.contains(comm_size)
+              && rule.ranks_per_node.contains(ranks_per_node)
+              && bytes >= rule.min_bytes && bytes <= rule.max_bytes) {
+            choices[op][t][b] = static_cast<uint8_t>(rule.algo);
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+void load_tuning_table() {
+  const char* filename = std::getenv("AL_MPI_TUNING_FILE");
+  if (filename == nullptr || *filename == '\0') {
+    return;
+  }
+  std::ifstream file(filename);
+  if (!file) {
+    throw_al_exception("Could not open tuning file ", filename);
+  }
+  const auto& ops = all_op_algos();
+  std::string line;
+  for (size_t line_num = 1; std::getline(file, line); ++line_num) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string op_name, type_size, comm_size, ranks_per_node, min_bytes,
+      max_bytes, algo_name, extra;
+    if (!(fields >> op_name)) {
+      continue;  // Blank.
+    }
+    if (!(fields >> type_size >> comm_size >> ranks_per_node >> min_bytes
+          >> max_bytes >> algo_name) || (fields >> extra)) {
+      throw_al_exception(filename, ":", line_num, ": expected 7 fields");
+    }
+    Rule rule;
+    size_t op = 0;
+    while (op < ops.size() && op_name != ops[op].name) {
+      ++op;
+    }
+    if (op == ops.size()) {
+      throw_al_exception(filename, ":", line_num, ": unknown operation ",
+                         op_name);
+    }
+    rule.op = static_cast<AlOperation>(op);
+    Range bytes_lo, bytes_hi;
+    if (!parse_range(type_size, rule.type_size)
+        || !parse_range(comm_size, rule.comm_size)
+        || !parse_range(ranks_per_node, rule.ranks_per_node)
+        || !parse_range(min_bytes, bytes_lo)
+        || !parse_range(max_bytes, bytes_hi)) {
+      throw_al_exception(filename, ":", line_num, ": malformed range");
+    }
+    rule.min_bytes = bytes_lo.lo;
+    rule.max_bytes = bytes_hi.hi;
+    const auto& algos = ops[op].algos;
+    rule.algo = 0;
+    while (static_cast<size_t>(rule.algo) < algos.size()
+           && algo_name != algos[rule.algo]) {
+      ++rule.algo;
+    }
+    if (static_cast<size_t>(rule.algo) == algos.size()) {
+      throw_al_exception(filename, ":", line_num, ": unknown algorithm ",
+                         algo_name, " for ", op_name);
+    }
+    rules.push_back(rule);
+  }
+}
+
+const char* algorithm_cname(AlOperation op, int algo) {
+  const auto& algos = all_op_algos()[static_cast<size_t>(op)].algos;
+  if (algo < 0 || static_cast<size_t>(algo) >= algos.size()) {
+    return "unknown";
+  }
+  return algos[algo].c_str();
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
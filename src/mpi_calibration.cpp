@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/mpi/calibration.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "aluminum/tuning_params.hpp"
+#include "aluminum/utils/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+namespace {
+
+/** The calibrated network model. */
+NetworkModel network_model;
+
+/** Tag for messages to echo back. */
+constexpr int ping_tag = 1;
+/** Tag for a stream of messages, answered once the last one arrives. */
+constexpr int stream_tag = 2;
+/** Tag to stop answering probes. */
+constexpr int done_tag = 3;
+
+/** Bytes of small and large probe messages. */
+constexpr size_t small_bytes = 8;
+constexpr size_t large_bytes = 262144;
+/** Number of messages in a stream. */
+constexpr int stream_length = 16;
+/** Maximum rounds of each probe; the fastest round is used. */
+constexpr int max_rounds = 20;
+
+constexpr double no_time = std::numeric_limits<double>::infinity();
+
+/** Answer probes from peer until it is done. */
+void answer_probes(MPI_Comm comm, int peer) {
+  std::vector<unsigned char> buf(large_bytes);
+  while (true) {
+    MPI_Status status;
+    MPI_Probe(peer, MPI_ANY_TAG, comm, &status);
+    int count;
+    MPI_Get_count(&status, MPI_BYTE, &count);
+    MPI_Recv(buf.data(), count, MPI_BYTE, peer, status.MPI_TAG, comm,
+             MPI_STATUS_IGNORE);
+    if (status.MPI_TAG == done_tag) {
+      return;
+    }
+    if (status.MPI_TAG == ping_tag) {
+      MPI_Send(buf.data(), count, MPI_BYTE, peer, ping_tag, comm);
+    } else if (buf[0]) {
+      // Last message of a stream.
+      MPI_Send(buf.data(), 1, MPI_BYTE, peer, stream_tag, comm);
+    }
+  }
+}
+
+/**
+ * Return the fastest round trip of a message of bytes to peer, and in
+ * send_time the fastest time for the send to return, or no_time if
+ * past deadline.
+ */
+double time_ping_pong(MPI_Comm comm, int peer, size_t bytes,
+                      double deadline, double& send_time) {
+  std::vector<unsigned char> buf(bytes);
+  double best = no_time;
+  send_time = no_time;
+  for (int round = 0; round < max_rounds && get_time() < deadline; ++round) {
+    const double start = get_time();
+    MPI_Send(buf.data(), bytes, MPI_BYTE, peer, ping_tag, comm);
+    const double sent = get_time();
+    MPI_Recv(buf.data(), bytes, MPI_BYTE, peer, ping_tag, comm,
+             MPI_STATUS_IGNORE);
+    best = std::min(best, get_time() - start);
+    send_time = std::min(send_time, sent - start);
+  }
+  return best;
+}
+
+/**
+ * Return the fastest time to send a stream of small messages to peer
+ * and get a reply, or no_time if past deadline.
+ */
+double time_stream(MPI_Comm comm, int peer, double deadline) {
+  std::vector<unsigned char> bufs(stream_length * small_bytes, 0);
+  bufs[(stream_length - 1) * small_bytes] = 1;  // Mark the last message.
+  std::vector<MPI_Request> reqs(stream_length);
+  unsigned char reply;
+  double best = no_time;
+  for (int round = 0; round < max_rounds && get_time() < deadline; ++round) {
+    const double start = get_time();
+    for (int i = 0; i < stream_length; ++i) {
+      MPI_Isend(&bufs[i * small_bytes], small_bytes, MPI_BYTE, peer,
+                stream_tag, comm, &reqs[i]);
+    }
+    MPI_Waitall(stream_length, reqs.data(), MPI_STATUSES_IGNORE);
+    MPI_Recv(&reply, 1, MPI_BYTE, peer, stream_tag, comm, MPI_STATUS_IGNORE);
+    best = std::min(best, get_time() - start);
+  }
+  return best;
+}
+
+/** Measure the link to peer, which must be answering probes. */
+LinkModel measure_link(MPI_Comm comm, int peer, double deadline) {
+  double o, unused;
+  const double small_rtt = time_ping_pong(comm, peer, small_bytes, deadline, o);
+  const double large_rtt = time_ping_pong(comm, peer, large_bytes, deadline,
+                                          unused);
+  const double stream = time_stream(comm, peer, deadline);
+  MPI_Send(nullptr, 0, MPI_BYTE, peer, done_tag, comm);
+  LinkModel link;
+  if (stream == no_time) {
+    return link;  // Ran out of time.
+  }
+  link.o = o;
+  link.L = std::max(small_rtt / 2 - 2*o, 0.0);
+  link.G = std::max((large_rtt - small_rtt) / 2 / (large_bytes - small_bytes),
+                    0.0);
+  // The last message of the stream and the reply take about a round
+  // trip, and the messages before it are spaced by the gap.
+  link.g = std::max((stream - small_rtt) / (stream_length - 1), o);
+  link.valid = true;
+  return link;
+}
+
+/**
+ * Return a key for the set of hosts of ranks in comm (on rank 0 only).
+ *
+ * This uses FNV-1a rather than std::hash so keys are stable across
+ * builds.
+ */
+std::string get_hosts_key(MPI_Comm comm, int rank, int size) {
+  char name[MPI_MAX_PROCESSOR_NAME] = {};
+  int len;
+  MPI_Get_processor_name(name, &len);
+  std::vector<char> names(rank == 0 ? size * MPI_MAX_PROCESSOR_NAME : 0);
+  MPI_Gather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+             names.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, comm);
+  if (rank != 0) {
+    return "";
+  }
+  std::set<std::string> hosts;
+  for (int i = 0; i < size; ++i) {
+    hosts.emplace(&names[i * MPI_MAX_PROCESSOR_NAME],
+                  strnlen(&names[i * MPI_MAX_PROCESSOR_NAME],
+                          MPI_MAX_PROCESSOR_NAME));
+  }
+  uint64_t hash = 14695981039346656037ULL;
+  for (const auto& host : hosts) {
+    // Include the terminator to separate names.
+    for (size_t i = 0; i <= host.size(); ++i) {
+      hash ^= static_cast<unsigned char>(host.c_str()[i]);
+      hash *= 1099511628211ULL;
+    }
+  }
+  std::ostringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return key.str();
+}
+
+/** Return the cache file for key, or an empty string for none. */
+std::string get_cache_path(const std::string& key) {
+  const char* dir = std::getenv("AL_MPI_CALIBRATION_DIR");
+  if (dir == nullptr || *dir == '\0') {
+    dir = std::getenv("HOME");
+  }
+  if (dir == nullptr || *dir == '\0') {
+    return "";
+  }
+  return std::string(dir) + "/.aluminum-calibration-" + key;
+}
+
+/** Read a link named name from is; return false on error. */
+bool read_link(std::istream& is, const char* name, LinkModel& link) {
+  std::string read_name;
+  is >> read_name >> link.valid >> link.L >> link.o >> link.g >> link.G;
+  return is && read_name == name;
+}
+
+/** Write a link named name to os. */
+void write_link(std::ostream& os, const char* name, const LinkModel& link) {
+  os << name << " " << link.valid << " " << link.L << " " << link.o << " "
+     << link.g << " " << link.G << "\n";
+}
+
+}  // anonymous namespace
+
+void calibrate_network(MPI_Comm comm) {
+  const char* env = std::getenv("AL_MPI_CALIBRATE");
+  if (env == nullptr || std::string(env) == "0") {
+    return;
+  }
+  const double deadline = get_time() + AL_MPI_CALIBRATION_MS / 1000.0;
+  // Use separate communicators so probes cannot match anything else.
+  MPI_Comm probe_comm, local_comm;
+  MPI_Comm_dup(comm, &probe_comm);
+  int rank, size;
+  MPI_Comm_rank(probe_comm, &rank);
+  MPI_Comm_size(probe_comm, &size);
+  MPI_Comm_split_type(probe_comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+                      &local_comm);
+  int local_rank, local_size;
+  MPI_Comm_rank(local_comm, &local_rank);
+  MPI_Comm_size(local_comm, &local_size);
+
+  // Rank 0 probes local rank 1 on its node and the first rank on
+  // another node (if any). Local ranks are ordered by rank, so rank 0 is
+  // local rank 0.
+  int node_first_rank = rank;
+  MPI_Allreduce(MPI_IN_PLACE, &node_first_rank, 1, MPI_INT, MPI_MIN,
+                local_comm);
+  const bool on_root_node = node_first_rank == 0;
+  int remote_rank = on_root_node ? size : rank;
+  MPI_Allreduce(MPI_IN_PLACE, &remote_rank, 1, MPI_INT, MPI_MIN, probe_comm);
+
+  const std::string key = get_hosts_key(probe_comm, rank, size);
+  std::string cache_path;
+  int cached = 0;
+  if (rank == 0) {
+    cache_path = get_cache_path(key);
+    std::ifstream f(cache_path);
+    cached = f && read_link(f, "intra", network_model.intra)
+      && read_link(f, "inter", network_model.inter);
+    if (!cached) {
+      network_model = NetworkModel();
+    }
+  }
+  MPI_Bcast(&cached, 1, MPI_INT, 0, probe_comm);
+
+  if (!cached) {
+    // Leave half the time for the inter-node link.
+    const double intra_deadline = (remote_rank < size)
+      ? deadline - AL_MPI_CALIBRATION_MS / 2000.0 : deadline;
+    if (on_root_node && local_size > 1) {
+      if (local_rank == 0) {
+        network_model.intra = measure_link(local_comm, 1, intra_deadline);
+      } else if (local_rank == 1) {
+        answer_probes(local_comm, 0);
+      }
+    }
+    if (remote_rank < size) {
+      if (rank == 0) {
+        network_model.inter = measure_link(probe_comm, remote_rank, deadline);
+      } else if (rank == remote_rank) {
+        answer_probes(probe_comm, 0);
+      }
+    }
+    // Only cache complete results.
+    if (rank == 0 && !cache_path.empty()
+        && (local_size == 1 || network_model.intra.valid)
+        && (remote_rank == size || network_model.inter.valid)) {
+      std::ofstream f(cache_path);
+      f << std::setprecision(std::numeric_limits<double>::max_digits10);
+      write_link(f, "intra", network_model.intra);
+      write_link(f, "inter", network_model.inter);
+    }
+  }
+
+  double params[10];
+  int i = 0;
+  for (LinkModel* link : {&network_model.intra, &network_model.inter}) {
+    params[i++] = link->valid;
+    params[i++] = link->L;
+    params[i++] = link->o;
+    params[i++] = link->g;
+    params[i++] = link->G;
+  }
+  MPI_Bcast(params, 10, MPI_DOUBLE, 0, probe_comm);
+  i = 0;
+  for (LinkModel* link : {&network_model.intra, &network_model.inter}) {
+    link->valid = params[i++] != 0.0;
+    link->L = params[i++];
+    link->o = params[i++];
+    link->g = params[i++];
+    link->G = params[i++];
+  }
+
+  MPI_Comm_free(&local_comm);
+  MPI_Comm_free(&probe_comm);
+}
+
+const NetworkModel& get_network_model() {
+  return network_model;
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/mpi/cma.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+#ifdef AL_HAS_CMA
+#include <sys/prctl.h>
+#include <sys/uio.h>
+#endif
+
+#include "aluminum/base.hpp"
+#include "aluminum/mpi/communicator.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+namespace {
+
+/** Whether cross-memory attach may be used (AL_MPI_CMA). */
+bool cma_allowed = true;
+
+/** Value peers read to check that cross-memory attach works. */
+const uint64_t cma_probe_value = 0xA1CA0A1CA0A1CA0AULL;
+
+#ifdef AL_HAS_CMA
+/**
+ * Copy bytes from addr in process pid to buf; return false on error.
+ *
+ * The kernel may copy less than requested, so this loops.
+ */
+bool cma_read(int64_t pid, uint64_t addr, void* buf, size_t bytes) {
+  size_t done = 0;
+  while (done < bytes) {
+    struct iovec local = {static_cast<char*>(buf) + done, bytes - done};
+    struct iovec remote = {reinterpret_cast<void*>(addr + done), bytes - done};
+    ssize_t n = process_vm_readv(static_cast<pid_t>(pid), &local, 1,
+                                 &remote, 1, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+#endif
+
+}  // anonymous namespace
+
+void init_cma() {
+  // Set AL_MPI_CMA to 0 to never use cross-memory attach.
+  if (const char* env = std::getenv("AL_MPI_CMA");
+      env != nullptr && std::string(env) == "0") {
+    cma_allowed = false;
+  }
+}
+
+CMAPeers::CMAPeers(MPI_Comm comm, MPI_Comm local_comm) {
+  int size, local_size;
+  MPI_Comm_size(comm, &size);
+  MPI_Comm_size(local_comm, &local_size);
+  on_node.assign(size, 0);
+  std::vector<int> local_ranks(local_size);
+  std::vector<int> ranks(local_size);
+  for (int i = 0; i < local_size; ++i) {
+    local_ranks[i] = i;
+  }
+  MPI_Group group, local_group;
+  MPI_Comm_group(comm, &group);
+  MPI_Comm_group(local_comm, &local_group);
+  MPI_Group_translate_ranks(local_group, local_size, local_ranks.data(),
+                            group, ranks.data());
+  MPI_Group_free(&group);
+  MPI_Group_free(&local_group);
+  for (int rank : ranks) {
+    on_node[rank] = 1;
+  }
+}
+
+std::unique_ptr<CMAPeers> make_cma_peers(MPI_Comm comm, MPI_Comm local_comm,
+                                         int local_size) {
+#ifdef AL_HAS_CMA
+  if (!cma_allowed || local_size == 1) {
+    return nullptr;
+  }
+  // Let peers read our memory even when Yama restricts ptrace to
+  // descendants, as MPI libraries' own CMA support does.
+#ifdef PR_SET_PTRACER
+  prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+#endif
+  // Every rank tries to read a known value from every peer; only use
+  // CMA on this node if all succeed, so that all ranks agree.
+  CMAControl mine = {static_cast<int64_t>(getpid()),
+                     reinterpret_cast<uint64_t>(&cma_probe_value),
+                     sizeof(cma_probe_value)};
+  std::vector<CMAControl> peers(local_size);
+  MPI_Allgather(&mine, sizeof(CMAControl), MPI_BYTE,
+                peers.data(), sizeof(CMAControl), MPI_BYTE, local_comm);
+  int ok = 1;
+  for (const auto& peer : peers) {
+    uint64_t value = 0;
+    if (!cma_read(peer.pid, peer.addr, &value, sizeof(value))
+        || value != cma_probe_value) {
+      ok = 0;
+      break;
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, local_comm);
+  if (!ok) {
+    return nullptr;
+  }
+  return std::make_unique<CMAPeers>(comm, local_comm);
+#else
+  (void) comm;
+  (void) local_comm;
+  (void) local_size;
+  return nullptr;
+#endif
+}
+
+void CMASend::start(const void* buf, size_t bytes, int dest, MPI_Comm comm) {
+  ctrl = {static_cast<int64_t>(getpid()), reinterpret_cast<uint64_t>(buf),
+          bytes};
+  MPI_Irecv(nullptr, 0, MPI_BYTE, dest, cma_ack_tag, comm, &reqs[0]);
+  MPI_Isend(&ctrl, sizeof(ctrl), MPI_BYTE, dest, pt2pt_tag, comm, &reqs[1]);
+}
+
+bool CMASend::test() {
+  int flag;
+  MPI_Testall(2, reqs, &flag, MPI_STATUSES_IGNORE);
+  return flag;
+}
+
+void CMARecv::start(void* buf_, size_t bytes_, int src_, MPI_Comm comm_) {
+  buf = buf_;
+  bytes = bytes_;
+  src = src_;
+  comm = comm_;
+  copied = false;
+  MPI_Irecv(&ctrl, sizeof(ctrl), MPI_BYTE, src, pt2pt_tag, comm, &req);
+}
+
+bool CMARecv::test() {
+  int flag;
+  MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+  if (!flag) {
+    return false;
+  }
+  if (copied) {
+    return true;
+  }
+  if (ctrl.bytes != bytes) {
+    terminate_al("Cross-memory attach transfer of ", ctrl.bytes,
+                 " bytes does not match receive of ", bytes, " bytes");
+  }
+#ifdef AL_HAS_CMA
+  if (!cma_read(ctrl.pid, ctrl.addr, buf, bytes)) {
+    terminate_al("Cross-memory attach read failed: errno ", errno);
+  }
+#endif
+  copied = true;
+  MPI_Isend(nullptr, 0, MPI_BYTE, src, cma_ack_tag, comm, &req);
+  return test();
+}
+
+}  // namespace mpi
+}  // namespace internal
+}  // namespace Al
@@ -26,9 +26,21 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "aluminum/mpi_impl.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <string>
+#include <unordered_set>
 #include <mpi.h>
 #include "aluminum/base.hpp"
+#include "aluminum/mpi/calibration.hpp"
+#include "aluminum/mpi/cma.hpp"
 #include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/comm_matrix.hpp"
+#include "aluminum/mpi/pvars.hpp"
+#include "aluminum/mpi/shm.hpp"
 
 namespace Al {
 namespace internal {
@@ -57,6 +69,15 @@ bool initialized_mpi = false;
 int max_tag = 0;
 // World MPI communicator.
 MPICommunicator* al_world_comm = nullptr;
+// Whether to count per-peer traffic (AL_COMM_MATRIX).
+bool count_peer_traffic = false;
+// Protects live_traffic and the retired totals.
+std::mutex traffic_mutex;
+// Traffic counters for all live communicators.
+std::unordered_set<const PeerTraffic*> live_traffic;
+// Totals, by world rank, from communicators that have been destroyed.
+std::vector<uint64_t> retired_sent_bytes;
+std::vector<uint64_t> retired_sent_messages;
 
 #ifdef AL_HAS_HALF
 // Operator implementations for half.
@@ -185,7 +206,20 @@ void init(int& argc, char**& argv, MPI_Comm world_comm) {
   MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &p, &flag);
   max_tag = *p;
 
+  // Set AL_COMM_MATRIX to a non-zero value to count per-peer traffic.
+  if (const char* env = std::getenv("AL_COMM_MATRIX");
+      env != nullptr && std::string(env) != "0") {
+    count_peer_traffic = true;
+  }
+  init_cma();
+  load_tuning_table();
+  if (!have_tuning_rules()) {
+    calibrate_network(world_comm);
+  }
+  skew::init(world_comm);
+
   al_world_comm = new MPICommunicator(world_comm);
+  init_pvars(al_world_comm->get_comm());
 
 #ifdef AL_HAS_HALF
   // Set up reduction operators for half.
@@ -205,11 +239,13 @@ void init(int& argc, char**& argv, MPI_Comm world_comm) {
 }
 
 void finalize() {
+  finalize_pvars();
   // Communicator teardown is safe even when MPI has already been finalized.
   if (al_world_comm) {
     delete al_world_comm;
     al_world_comm = nullptr;
   }
+  skew::finalize();
 
   int flag;
   MPI_Finalized(&flag);
@@ -236,6 +272,175 @@ void finalize() {
 
 int get_max_tag() { return max_tag; }
 
+bool comm_matrix_enabled() { return count_peer_traffic; }
+
+PeerTraffic::PeerTraffic(MPI_Comm comm, int size) :
+  world_ranks(size),
+  sent_bytes(new std::atomic<uint64_t>[size]),
+  sent_messages(new std::atomic<uint64_t>[size]) {
+  for (int i = 0; i < size; ++i) {
+    sent_bytes[i] = 0;
+    sent_messages[i] = 0;
+  }
+  if (al_world_comm) {
+    std::vector<int> ranks(size);
+    std::iota(ranks.begin(), ranks.end(), 0);
+    MPI_Group group, world_group;
+    MPI_Comm_group(comm, &group);
+    MPI_Comm_group(al_world_comm->get_comm(), &world_group);
+    MPI_Group_translate_ranks(group, size, ranks.data(),
+                              world_group, world_ranks.data());
+    MPI_Group_free(&group);
+    MPI_Group_free(&world_group);
+  } else {
+    // This is the world communicator itself.
+    std::iota(world_ranks.begin(), world_ranks.end(), 0);
+  }
+  std::lock_guard<std::mutex> lock(traffic_mutex);
+  live_traffic.insert(this);
+}
+
+PeerTraffic::~PeerTraffic() {
+  std::lock_guard<std::mutex> lock(traffic_mutex);
+  live_traffic.erase(this);
+  accumulate(retired_sent_bytes, retired_sent_messages);
+}
+
+void PeerTraffic::accumulate(std::vector<uint64_t>& bytes,
+                             std::vector<uint64_t>& messages) const {
+  for (size_t i = 0; i < world_ranks.size(); ++i) {
+    const int world_rank = world_ranks[i];
+    if (world_rank == MPI_UNDEFINED || world_rank < 0) {
+      continue;  // Not part of Aluminum's world.
+    }
+    if (static_cast<size_t>(world_rank) >= bytes.size()) {
+      bytes.resize(world_rank + 1, 0);
+      messages.resize(world_rank + 1, 0);
+    }
+    bytes[world_rank] += sent_bytes[i].load(std::memory_order_relaxed);
+    messages[world_rank] += sent_messages[i].load(std::memory_order_relaxed);
+  }
+}
+
+void write_comm_matrix(const std::string& filename) {
+  const MPICommunicator& world = get_world_comm();
+  const size_t world_size = world.size();
+  std::vector<uint64_t> bytes(world_size, 0);
+  std::vector<uint64_t> messages(world_size, 0);
+  {
+    std::lock_guard<std::mutex> lock(traffic_mutex);
+    for (size_t i = 0; i < retired_sent_bytes.size() && i < world_size; ++i) {
+      bytes[i] += retired_sent_bytes[i];
+      messages[i] += retired_sent_messages[i];
+    }
+    for (const auto& traffic : live_traffic) {
+      traffic->accumulate(bytes, messages);
+    }
+  }
+  bytes.resize(world_size);
+  messages.resize(world_size);
+  std::vector<uint64_t> all_bytes, all_messages;
+  if (world.rank() == 0) {
+    all_bytes.resize(world_size * world_size);
+    all_messages.resize(world_size * world_size);
+  }
+  MPI_Gather(bytes.data(), world_size, MPI_UINT64_T,
+             all_bytes.data(), world_size, MPI_UINT64_T, 0, world.get_comm());
+  MPI_Gather(messages.data(), world_size, MPI_UINT64_T,
+             all_messages.data(), world_size, MPI_UINT64_T, 0, world.get_comm());
+  if (world.rank() != 0) {
+    return;
+  }
+  // Row i, column j is what world rank i sent to world rank j.
+  std::ofstream file(filename);
+  file << "# Aluminum communication matrix, " << world_size << " ranks\n";
+  file << "# bytes sent (row: sender, column: receiver)\n";
+  for (size_t i = 0; i < world_size; ++i) {
+    for (size_t j = 0; j < world_size; ++j) {
+      file << all_bytes[i*world_size + j] << (j + 1 < world_size ? " " : "\n");
+    }
+  }
+  file << "# messages sent (row: sender, column: receiver)\n";
+  for (size_t i = 0; i < world_size; ++i) {
+    for (size_t j = 0; j < world_size; ++j) {
+      file << all_messages[i*world_size + j] << (j + 1 < world_size ? " " : "\n");
+    }
+  }
+}
+
+NodeComm::NodeComm(MPI_Comm comm, int local_rank, bool uniform_) :
+  uniform(uniform_) {
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_split(comm, local_rank, rank, &cross_comm);
+}
+
+NodeComm::~NodeComm() {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Comm_free(&cross_comm);
+  }
+}
+
+NodeExtents get_node_extents(MPI_Comm comm, int local_size) {
+  int extents[2] = {local_size, -local_size};
+  MPI_Allreduce(MPI_IN_PLACE, extents, 2, MPI_INT, MPI_MAX, comm);
+  return {-extents[1], extents[0]};
+}
+
+std::unique_ptr<NodeComm> make_node_comm(MPI_Comm comm, int size,
+                                         int local_rank,
+                                         const NodeExtents& extents) {
+  // Ranks must agree on whether to split, so this uses the extents
+  // across all nodes.
+  if (extents.max_local_size == 1 || extents.min_local_size == size) {
+    return nullptr;
+  }
+  return std::make_unique<NodeComm>(
+    comm, local_rank, extents.min_local_size == extents.max_local_size);
+}
+
+NodeShm::NodeShm(MPI_Comm local_comm, int local_rank_, int local_size_) :
+  local_rank(local_rank_), local_size(local_size_),
+  flags(local_size_), buffers(local_size_) {
+  // Each rank's segment is its flag, padded to avoid false sharing,
+  // followed by its buffer.
+  constexpr size_t flag_bytes = AL_DESTRUCTIVE_INTERFERENCE_SIZE;
+  static_assert(sizeof(std::atomic<uint64_t>) <= flag_bytes,
+                "Flag does not fit in its padding");
+  void* base;
+  MPI_Win_allocate_shared(flag_bytes + buffer_bytes(), 1, MPI_INFO_NULL,
+                          local_comm, &base, &win);
+  new (base) std::atomic<uint64_t>(0);
+  for (int i = 0; i < local_size; ++i) {
+    MPI_Aint size;
+    int disp_unit;
+    char* peer_base;
+    MPI_Win_shared_query(win, i, &size, &disp_unit, &peer_base);
+    flags[i] = reinterpret_cast<std::atomic<uint64_t>*>(peer_base);
+    buffers[i] = peer_base + flag_bytes;
+  }
+  // Peers must not read flags before they are initialized.
+  MPI_Barrier(local_comm);
+}
+
+NodeShm::~NodeShm() {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Win_free(&win);
+  }
+}
+
+std::unique_ptr<NodeShm> make_node_shm(MPI_Comm local_comm, int local_rank,
+                                       int local_size) {
+  if (local_size == 1 || AL_MPI_SHM_BYTES == 0) {
+    return nullptr;
+  }
+  return std::make_unique<NodeShm>(local_comm, local_rank, local_size);
+}
+
 const MPICommunicator& get_world_comm() {
 #ifdef AL_DEBUG
   if (!al_world_comm) {
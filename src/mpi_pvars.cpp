@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/mpi/pvars.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "Al.hpp"
+#include "aluminum/tuning_params.hpp"
+#include "aluminum/utils/utils.hpp"
+
+namespace Al {
+namespace internal {
+namespace mpi {
+
+namespace {
+
+/** A performance variable being sampled. */
+struct Pvar {
+  std::string name;
+  int var_class;
+  MPI_Datatype datatype;
+  MPI_T_pvar_handle handle;
+  /** Number of elements in the variable. */
+  int count;
+  /** Whether we started the variable (and so must stop it). */
+  bool started;
+  /** Buffer to read the variable into. */
+  std::vector<unsigned char> buf;
+  uint64_t num_samples = 0;
+  double first = 0.0;
+  double last = 0.0;
+  double min = std::numeric_limits<double>::max();
+  double max = std::numeric_limits<double>::lowest();
+  double sum = 0.0;
+};
+
+/** Whether MPI_T was initialized. */
+bool mpi_t_initialized = false;
+/** Session all variables are allocated in. */
+MPI_T_pvar_session session = MPI_T_PVAR_SESSION_NULL;
+/** Variables being sampled. */
+std::vector<Pvar> pvars;
+/** Protects samples of pvars. */
+std::mutex pvars_mutex;
+/** Time of the last sample. */
+double last_sample_time = 0.0;
+
+/** Return the sum of the count elements of type datatype in buf. */
+template <typename T>
+double sum_elements(const unsigned char* buf, int count) {
+  double sum = 0.0;
+  for (int i = 0; i < count; ++i) {
+    sum += static_cast<double>(reinterpret_cast<const T*>(buf)[i]);
+  }
+  return sum;
+}
+
+/** Return true if we can convert values of datatype. */
+bool supported_datatype(MPI_Datatype datatype) {
+  return datatype == MPI_UNSIGNED || datatype == MPI_UNSIGNED_LONG
+    || datatype == MPI_UNSIGNED_LONG_LONG || datatype == MPI_COUNT
+    || datatype == MPI_INT || datatype == MPI_DOUBLE;
+}
+
+double to_double(const Pvar& pvar) {
+  const unsigned char* buf = pvar.buf.data();
+  if (pvar.datatype == MPI_UNSIGNED) {
+    return sum_elements<unsigned>(buf, pvar.count);
+  } else if (pvar.datatype == MPI_UNSIGNED_LONG) {
+    return sum_elements<unsigned long>(buf, pvar.count);
+  } else if (pvar.datatype == MPI_UNSIGNED_LONG_LONG) {
+    return sum_elements<unsigned long long>(buf, pvar.count);
+  } else if (pvar.datatype == MPI_COUNT) {
+    return sum_elements<MPI_Count>(buf, pvar.count);
+  } else if (pvar.datatype == MPI_INT) {
+    return sum_elements<int>(buf, pvar.count);
+  } else {
+    return sum_elements<double>(buf, pvar.count);
+  }
+}
+
+/** Sample every variable; pvars_mutex must be held. */
+void sample_all() {
+  for (auto& pvar : pvars) {
+    if (MPI_T_pvar_read(session, pvar.handle, pvar.buf.data()) != MPI_SUCCESS) {
+      continue;
+    }
+    const double value = to_double(pvar);
+    if (pvar.num_samples == 0) {
+      pvar.first = value;
+    }
+    ++pvar.num_samples;
+    pvar.last = value;
+    pvar.min = std::min(pvar.min, value);
+    pvar.max = std::max(pvar.max, value);
+    pvar.sum += value;
+  }
+  last_sample_time = get_time();
+}
+
+/** Add the variable with name to pvars, if possible. */
+void add_pvar(const std::string& name, MPI_Comm comm, int rank) {
+  Pvar pvar;
+  pvar.name = name;
+  int num_pvars;
+  MPI_T_pvar_get_num(&num_pvars);
+  int index = -1;
+  int bind, continuous;
+  for (int i = 0; i < num_pvars && index < 0; ++i) {
+    char pvar_name[256];
+    int name_len = sizeof(pvar_name);
+    char desc[1024];
+    int desc_len = sizeof(desc);
+    int verbosity, readonly, atomic;
+    MPI_T_enum enumtype;
+    MPI_T_pvar_get_info(i, pvar_name, &name_len, &verbosity, &pvar.var_class,
+                        &pvar.datatype, &enumtype, desc, &desc_len, &bind,
+                        &readonly, &continuous, &atomic);
+    if (name == pvar_name) {
+      index = i;
+    }
+  }
+  if (index < 0) {
+    std::cerr << rank << ": MPI_T performance variable " << name
+              << " not found" << std::endl;
+    return;
+  }
+  if (!supported_datatype(pvar.datatype)) {
+    std::cerr << rank << ": MPI_T performance variable " << name
+              << " has an unsupported datatype" << std::endl;
+    return;
+  }
+  void* obj;
+  if (bind == MPI_T_BIND_NO_OBJECT) {
+    obj = nullptr;
+  } else if (bind == MPI_T_BIND_MPI_COMM) {
+    obj = &comm;
+  } else {
+    std::cerr << rank << ": MPI_T performance variable " << name
+              << " is bound to an unsupported object" << std::endl;
+    return;
+  }
+  if (MPI_T_pvar_handle_alloc(session, index, obj, &pvar.handle, &pvar.count)
+      != MPI_SUCCESS) {
+    std::cerr << rank << ": could not allocate MPI_T performance variable "
+              << name << std::endl;
+    return;
+  }
+  pvar.started = !continuous;
+  if (pvar.started) {
+    MPI_T_pvar_start(session, pvar.handle);
+  }
+  int type_size;
+  MPI_Type_size(pvar.datatype, &type_size);
+  pvar.buf.resize(static_cast<size_t>(pvar.count) * type_size);
+  pvars.push_back(std::move(pvar));
+}
+
+}  // anonymous namespace
+
+void init_pvars(MPI_Comm comm) {
+  // Set AL_MPI_T_PVARS to a comma-separated list of variables to sample.
+  const char* env = std::getenv("AL_MPI_T_PVARS");
+  if (env == nullptr || std::string(env).empty()) {
+    return;
+  }
+  int provided;
+  if (MPI_T_init_thread(MPI_THREAD_MULTIPLE, &provided) != MPI_SUCCESS) {
+    throw_al_exception("Failed to initialize MPI_T");
+  }
+  mpi_t_initialized = true;
+  MPI_T_pvar_session_create(&session);
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  std::istringstream names(env);
+  std::string name;
+  while (std::getline(names, name, ',')) {
+    if (!name.empty()) {
+      add_pvar(name, comm, rank);
+    }
+  }
+  std::lock_guard<std::mutex> lock(pvars_mutex);
+  sample_all();
+}
+
+void finalize_pvars() {
+  if (!mpi_t_initialized) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(pvars_mutex);
+    for (auto& pvar : pvars) {
+      if (pvar.started) {
+        MPI_T_pvar_stop(session, pvar.handle);
+      }
+      MPI_T_pvar_handle_free(session, &pvar.handle);
+    }
+    pvars.clear();
+  }
+  MPI_T_pvar_session_free(&session);
+  MPI_T_finalize();
+  mpi_t_initialized = false;
+}
+
+bool pvars_enabled() { return !pvars.empty(); }
+
+void sample_pvars() {
+  std::lock_guard<std::mutex> lock(pvars_mutex);
+  if (get_time() - last_sample_time >= AL_MPI_T_SAMPLE_INTERVAL_USEC * 1e-6) {
+    sample_all();
+  }
+}
+
+std::ostream& write_pvar_stats(std::ostream& os,
+                               const std::vector<MPIPvarStats>& stats) {
+  os << "# pvar class num_samples first last min max mean\n";
+  for (const auto& s : stats) {
+    os << s.name << " " << s.var_class << " " << s.num_samples
+       << " " << s.first << " " << s.last << " " << s.min
+       << " " << s.max << " " << s.mean << "\n";
+  }
+  return os;
+}
+
+}  // namespace mpi
+}  // namespace internal
+
+std::vector<MPIPvarStats> GetMPIPvarStats() {
+  std::lock_guard<std::mutex> lock(internal::mpi::pvars_mutex);
+  // Take a final sample so the most recent values are current.
+  if (!internal::mpi::pvars.empty()) {
+    internal::mpi::sample_all();
+  }
+  std::vector<MPIPvarStats> stats;
+  stats.reserve(internal::mpi::pvars.size());
+  for (const auto& pvar : internal::mpi::pvars) {
+    stats.push_back({pvar.name, pvar.var_class, pvar.num_samples,
+                     pvar.first, pvar.last,
+                     pvar.num_samples ? pvar.min : 0.0,
+                     pvar.num_samples ? pvar.max : 0.0,
+                     pvar.num_samples ? pvar.sum / pvar.num_samples : 0.0});
+  }
+  return stats;
+}
+
+}  // namespace Al
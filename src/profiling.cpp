@@ -58,30 +58,29 @@ void name_stream(AlGpuStream_t stream, std::string name) {
 }
 #endif
 
-void mark(std::string desc) {
-  (void) desc;
+#ifdef AL_HAS_PROFILING
+
+void mark(const char* desc) {
 #ifdef AL_HAS_NVPROF
-  nvtxMarkA(desc.c_str());
+  nvtxMarkA(desc);
 #endif
 #ifdef AL_HAS_ROCTRACER
-  roctxMark(desc.c_str());
+  roctxMark(desc);
 #endif
 }
 
-ProfileRange prof_start(std::string name) {
-  (void) name;
+ProfileRange prof_start(const char* name) {
   ProfileRange range;
 #ifdef AL_HAS_NVPROF
-  range.nvtx_range = nvtxRangeStartA(name.c_str());
+  range.nvtx_range = nvtxRangeStartA(name);
 #endif
 #ifdef AL_HAS_ROCTRACER
-  range.roctx_range = roctxRangeStart(name.c_str());
+  range.roctx_range = roctxRangeStart(name);
 #endif
   return range;
 }
 
 void prof_end(ProfileRange range) {
-  (void) range;
 #ifdef AL_HAS_NVPROF
   nvtxRangeEnd(range.nvtx_range);
 #endif
@@ -90,6 +89,8 @@ void prof_end(ProfileRange range) {
 #endif
 }
 
+#endif  // AL_HAS_PROFILING
+
 }  // namespace profiling
 }  // namespace internal
 }  // namespace Al
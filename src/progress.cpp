@@ -27,6 +27,9 @@
 
 #include "aluminum/progress.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <numeric>
 #include <string>
@@ -39,7 +42,10 @@
 #include "aluminum/tuning_params.hpp"
 #include "aluminum/state.hpp"
 #include "aluminum/mpi/communicator.hpp"
+#include "aluminum/mpi/pvars.hpp"
 #include "aluminum/profiling.hpp"
+#include "aluminum/stats.hpp"
+#include "aluminum/utils/utils.hpp"
 #ifdef AL_HAS_CUDA
 #include "aluminum/cuda/cuda.hpp"
 #endif
@@ -239,6 +245,16 @@ ProgressEngine::ProgressEngine() {
 #ifdef AL_PE_START_ON_DEMAND
   doing_start_flag = false;
 #endif
+  num_iterations = 0;
+  profile.start_time = get_time();
+  pause_flag = false;
+  parked_flag = false;
+  awake_flag = true;
+  // Set AL_PE_AUTO_PARK to a non-zero value to park the engine when idle.
+  if (const char* env = std::getenv("AL_PE_AUTO_PARK");
+      env != nullptr && std::string(env) != "0") {
+    auto_park = true;
+  }
 #ifdef AL_PE_ADD_DEFAULT_STREAM
   // Initialze with the default stream.
   num_input_streams = 1;
@@ -254,7 +270,17 @@ ProgressEngine::ProgressEngine() {
   bind_init();
 }
 
-ProgressEngine::~ProgressEngine() {}
+ProgressEngine::~ProgressEngine() {
+  if (bind_coreset) {
+    hwloc_bitmap_free(bind_coreset);
+  }
+  if (unbind_cpuset) {
+    hwloc_bitmap_free(unbind_cpuset);
+  }
+  if (bind_topo) {
+    hwloc_topology_destroy(bind_topo);
+  }
+}
 
 void ProgressEngine::run() {
   // Wait for the progress engine to start.
@@ -281,6 +307,7 @@ void ProgressEngine::stop() {
     throw_al_exception("Stop called twice on progress engine");
   }
   stop_flag.store(true, std::memory_order_release);
+  wake();
   thread.join();
 }
 
@@ -290,6 +317,15 @@ void ProgressEngine::enqueue(AlState* state) {
     run();
   }
 #endif
+  state->enqueue_time = get_time();
+#ifdef AL_TRACE
+  trace::record_pe_enqueue(*state);
+#endif
+  push_request(state);
+  wake();
+}
+
+void ProgressEngine::push_request(AlState* state) {
 #ifdef AL_PE_STREAM_QUEUE_CACHE
   // Check the thread-local queue cache.
   auto iter = ProgressEngine::stream_to_queue.find(state->get_compute_stream());
@@ -356,6 +392,16 @@ std::ostream& ProgressEngine::dump_state(std::ostream& ss) {
   // Note: This pulls *directly from internal state*.
   // This is *not* thread safe, and stuff might blow up.
   // You should only be dumping state where you don't care about that anyway.
+  ss << "Progress engine " << (pause_flag.load() ? "paused" : "running")
+     << (parked_flag.load() ? " (parked)" : "")
+     << (auto_park ? " auto-park" : "") << "\n";
+  // Do not block here, since we may be in a signal handler.
+  if (profile_mutex.try_lock()) {
+    ss << compute_stats();
+    profile_mutex.unlock();
+  } else {
+    ss << "Progress engine stats unavailable\n";
+  }
   for (auto&& stream_pipeline_pair : run_queues) {
     ss << "Pipelined run queue for stream " << stream_pipeline_pair.first << ":\n";
     auto&& pipeline = stream_pipeline_pair.second;
@@ -434,6 +480,15 @@ void ProgressEngine::bind_init() {
 }
 
 void ProgressEngine::bind() {
+  // Rebinding after a park reuses the cached topology and cpuset.
+  if (bind_coreset != nullptr) {
+    if (hwloc_set_cpubind(bind_topo, bind_coreset, HWLOC_CPUBIND_THREAD) == -1) {
+      std::cerr << mpi::get_world_comm().rank()
+                << ": failed to rebind progress thread"
+                << std::endl;
+    }
+    return;
+  }
   if (core_to_bind < 0) {
     std::cerr << mpi::get_world_comm().rank()
               << ": progress engine binding not initialized"
@@ -466,17 +521,156 @@ void ProgressEngine::bind() {
     hwloc_topology_destroy(topo);
     return;
   }
+  // Save the original binding so we can give the core back when parked.
+  hwloc_cpuset_t orig_cpuset = hwloc_bitmap_alloc();
+  if (hwloc_get_cpubind(topo, orig_cpuset, HWLOC_CPUBIND_THREAD) == -1) {
+    hwloc_bitmap_free(orig_cpuset);
+    orig_cpuset = nullptr;
+  }
   hwloc_cpuset_t coreset = hwloc_bitmap_dup(core->cpuset);
   hwloc_bitmap_singlify(coreset);
   if (hwloc_set_cpubind(topo, coreset, HWLOC_CPUBIND_THREAD) == -1) {
     std::cerr << mpi::get_world_comm().rank()
               << ": failed to bind progress thread"
               << std::endl;
+    hwloc_bitmap_free(coreset);
+    if (orig_cpuset) {
+      hwloc_bitmap_free(orig_cpuset);
+    }
+    hwloc_bitmap_free(cpuset);
+    hwloc_topology_destroy(topo);
+    return;
   }
 
-  hwloc_bitmap_free(coreset);
+  // Keep the topology and cpusets around for unbind/rebind.
+  bind_topo = topo;
+  bind_coreset = coreset;
+  unbind_cpuset = orig_cpuset;
   hwloc_bitmap_free(cpuset);
-  hwloc_topology_destroy(topo);
+}
+
+void ProgressEngine::unbind() {
+  if (unbind_cpuset == nullptr) {
+    return;  // Never bound, nothing to restore.
+  }
+  if (hwloc_set_cpubind(bind_topo, unbind_cpuset, HWLOC_CPUBIND_THREAD) == -1) {
+    std::cerr << mpi::get_world_comm().rank()
+              << ": failed to unbind progress thread"
+              << std::endl;
+  }
+}
+
+bool ProgressEngine::input_queues_empty() {
+  const size_t cur_input_streams = num_input_streams.load();
+  for (size_t i = 0; i < cur_input_streams; ++i) {
+    if (request_queues[i].q.peek() != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ProgressEngine::wake() {
+  // Pairs with the fence in park: either we see the engine parked, or
+  // the engine sees whatever we did before calling this.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked_flag.load(std::memory_order_relaxed)) {
+    {
+      std::lock_guard<std::mutex> lock(park_mutex);
+      parked_flag = false;
+    }
+    park_cv.notify_all();
+  }
+}
+
+void ProgressEngine::park() {
+  awake_flag = false;
+  parked_flag = true;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (stop_flag.load(std::memory_order_relaxed)
+      || (!auto_park && !pause_flag.load(std::memory_order_relaxed))
+      || !input_queues_empty()) {
+    parked_flag = false;
+    awake_flag = true;
+    return;
+  }
+  // Give the core back while we sleep.
+  unbind();
+  {
+    std::unique_lock<std::mutex> lock(park_mutex);
+    park_cv.wait(lock, [this] { return !parked_flag.load(); });
+  }
+  bind();
+  awake_flag = true;
+}
+
+ProgressEngineStats ProgressEngine::get_stats() {
+  std::lock_guard<std::mutex> lock(profile_mutex);
+  return compute_stats();
+}
+
+ProgressEngineStats ProgressEngine::compute_stats() {
+  ProgressEngineStats stats;
+  stats.elapsed = get_time() - profile.start_time;
+  stats.iterations = num_iterations.load() - profile.start_iterations;
+  if (stats.elapsed > 0.0) {
+    stats.iterations_per_second = stats.iterations / stats.elapsed;
+  }
+  stats.sampled_iterations = profile.sampled_iterations;
+  if (profile.sampled_iterations) {
+    stats.idle_fraction = static_cast<double>(profile.idle_samples)
+      / profile.sampled_iterations;
+  }
+  // Extrapolate sampled times to all iterations.
+  stats.input_scan_seconds =
+    profile.input_scan_time * AL_PE_PROFILE_SAMPLE_INTERVAL;
+  stats.empty_input_scan_seconds =
+    profile.empty_input_scan_time * AL_PE_PROFILE_SAMPLE_INTERVAL;
+  for (const auto& step : profile.steps) {
+    if (step.name == nullptr) {
+      break;
+    }
+    stats.steps.push_back({step.name, step.num_steps,
+                           step.time * AL_PE_PROFILE_SAMPLE_INTERVAL});
+  }
+  for (const auto& [stream, depths] : profile.depths) {
+    for (size_t stage = 0; stage < AL_PE_NUM_PIPELINE_STAGES; ++stage) {
+      stats.queue_depths.push_back(
+        {stream, stage,
+         profile.sampled_iterations
+         ? static_cast<double>(depths[stage].first) / profile.sampled_iterations
+         : 0.0,
+         depths[stage].second});
+    }
+  }
+  return stats;
+}
+
+void ProgressEngine::reset_stats() {
+  std::lock_guard<std::mutex> lock(profile_mutex);
+  profile = Profile{};
+  profile.start_time = get_time();
+  profile.start_iterations = num_iterations.load();
+}
+
+void ProgressEngine::pause() {
+  pause_flag = true;
+}
+
+void ProgressEngine::resume() {
+  pause_flag = false;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // Wait until the progress thread is back on its core.
+  // Keep waking it, in case it was about to (auto-)park.
+  std::unique_lock<std::mutex> lock(park_mutex);
+  while (!awake_flag.load()) {
+    if (parked_flag.load()) {
+      parked_flag = false;
+      park_cv.notify_all();
+    }
+    park_cv.wait_for(lock, std::chrono::microseconds(100),
+                     [this] { return awake_flag.load(); });
+  }
 }
 
 void ProgressEngine::engine() {
@@ -495,12 +689,23 @@ void ProgressEngine::engine() {
 #else
   startup_cv.notify_one();
 #endif
+  // Time at which the engine last became idle, for auto-parking.
+  double idle_start = -1.0;
+  // Step times from the current sample, merged into the profile after.
+  std::vector<std::pair<const char*, double>> sampled_steps;
+  sampled_steps.reserve(AL_PE_NUM_CONCURRENT_OPS * AL_PE_NUM_PIPELINE_STAGES);
+  uint64_t iteration = 0;
   while (!stop_flag.load(std::memory_order_acquire)) {
+    const bool sample = (iteration & (AL_PE_PROFILE_SAMPLE_INTERVAL - 1)) == 0;
+    num_iterations.store(++iteration, std::memory_order_relaxed);
+    const double scan_start = sample ? get_time() : 0.0;
+    bool found_request = false;
     // Check for newly-submitted requests.
     size_t cur_input_streams = num_input_streams.load();
     for (size_t i = 0; i < cur_input_streams; ++i) {
       AlState* req = request_queues[i].q.peek();
       if (req != nullptr) {
+        found_request = true;
         // Add to the correct run queue if one is available.
         bool do_start = false;
         switch (req->get_run_type()) {
@@ -528,10 +733,9 @@ void ProgressEngine::engine() {
                                decltype(run_queues)::mapped_type{});
           }
           run_queues[req->get_compute_stream()][0].push_back(req);
-          req->start();
-#ifdef AL_DEBUG_HANG_CHECK
+          ++num_active;
           req->start_time = get_time();
-#endif
+          req->start();
 #ifdef AL_TRACE
           trace::record_pe_start(*req);
 #endif
@@ -539,6 +743,7 @@ void ProgressEngine::engine() {
         }
       }
     }
+    const double scan_time = sample ? get_time() - scan_start : 0.0;
     // Process one step of each in-progress request.
     for (auto&& stream_pipeline_pair : run_queues) {
       auto&& pipeline = stream_pipeline_pair.second;
@@ -550,7 +755,14 @@ void ProgressEngine::engine() {
           if (req->paused_for_advance) {
             ++i;
           } else {
-            PEAction action = req->step();
+            PEAction action;
+            if (sample) {
+              const double step_start = get_time();
+              action = req->step();
+              sampled_steps.emplace_back(req->get_name(), get_time() - step_start);
+            } else {
+              action = req->step();
+            }
             switch (action) {
             case PEAction::cont:
               // Nothing to do here.
@@ -581,6 +793,9 @@ void ProgressEngine::engine() {
 #endif
               // Only move if this is the head of the pipeline stage.
               if (i == pipeline[stage].begin()) {
+#ifdef AL_TRACE
+                trace::record_pe_advance(*req, stage+1);
+#endif
                 pipeline[stage+1].push_back(req);
                 i = pipeline[stage].erase(i);
               } else {
@@ -592,6 +807,9 @@ void ProgressEngine::engine() {
               if (req->get_run_type() == RunType::bounded) {
                 --num_bounded;
               }
+              --num_active;
+              stats::record_op(req->get_name(), req->get_bytes(),
+                               req->enqueue_time, req->start_time, get_time());
 #ifdef AL_TRACE
               trace::record_pe_done(*req);
 #endif
@@ -610,6 +828,9 @@ void ProgressEngine::engine() {
           if (req->paused_for_advance) {
             // Move to the next stage.
             req->paused_for_advance = false;
+#ifdef AL_TRACE
+            trace::record_pe_advance(*req, stage+1);
+#endif
             pipeline[stage+1].push_back(req);
             i = pipeline[stage].erase(i);
           } else {
@@ -618,6 +839,61 @@ void ProgressEngine::engine() {
         }
       }
     }
+    if (sample) {
+      std::lock_guard<std::mutex> lock(profile_mutex);
+      ++profile.sampled_iterations;
+      if (num_active == 0) {
+        ++profile.idle_samples;
+      }
+      profile.input_scan_time += scan_time;
+      if (!found_request) {
+        profile.empty_input_scan_time += scan_time;
+      }
+      for (const auto& [name, t] : sampled_steps) {
+        // Names are static strings, so compare pointers.
+        size_t i = 0;
+        while (i < profile.steps.size() - 1
+               && profile.steps[i].name != nullptr
+               && profile.steps[i].name != name) {
+          ++i;
+        }
+        if (profile.steps[i].name == nullptr) {
+          profile.steps[i].name = name;
+        } else if (profile.steps[i].name != name) {
+          profile.steps[i].name = "(other)";
+        }
+        ++profile.steps[i].num_steps;
+        profile.steps[i].time += t;
+      }
+      sampled_steps.clear();
+      for (auto&& stream_pipeline_pair : run_queues) {
+        auto& depths = profile.depths[stream_pipeline_pair.first];
+        for (size_t stage = 0; stage < AL_PE_NUM_PIPELINE_STAGES; ++stage) {
+          const size_t depth = stream_pipeline_pair.second[stage].size();
+          depths[stage].first += depth;
+          depths[stage].second = std::max(depths[stage].second, depth);
+        }
+      }
+    }
+    if (sample && mpi::pvars_enabled()) {
+      mpi::sample_pvars();
+    }
+    // Park if requested or idle for long enough.
+    if (num_active == 0) {
+      if (pause_flag.load(std::memory_order_relaxed)) {
+        park();
+        idle_start = -1.0;
+      } else if (auto_park) {
+        if (idle_start < 0.0) {
+          idle_start = get_time();
+        } else if (get_time() - idle_start > AL_PE_AUTO_PARK_IDLE_USEC * 1e-6) {
+          park();
+          idle_start = -1.0;
+        }
+      }
+    } else {
+      idle_start = -1.0;
+    }
   }
 }
 
@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/skew.hpp"
+
+#include <unistd.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <utility>
+
+#include "Al.hpp"
+
+namespace Al {
+namespace internal {
+namespace skew {
+
+double clock_offset = 0.0;
+
+namespace {
+
+/** Whether to record arrivals (AL_SKEW). */
+bool enabled = false;
+/** Group of the world communicator, for translating ranks. */
+MPI_Group world_group = MPI_GROUP_NULL;
+/** Number of ping-pongs used to estimate each clock offset. */
+constexpr int num_clock_samples = 16;
+
+/** Skew for one kind of operation. */
+struct OpSkew {
+  const char* name = nullptr;
+  uint64_t num_ops = 0;
+  Histogram skew_ns;
+};
+
+/** Lateness for one rank. */
+struct RankLateness {
+  uint64_t times_last = 0;
+  double late_seconds = 0.0;
+};
+
+/** Protects op_skew and rank_lateness. */
+std::mutex skew_mutex;
+/**
+ * Skew by operation name.
+ *
+ * The same name may have different addresses in different translation
+ * units, so these are compared as strings.
+ */
+std::map<std::string, OpSkew> op_skew;
+/** Lateness by world rank. */
+std::map<int, RankLateness> rank_lateness;
+
+uint64_t to_ns(double t) {
+  return t > 0.0 ? static_cast<uint64_t>(t * 1e9) : 0;
+}
+
+/**
+ * Set clock_offset to the offset from the clock of rank 0 of comm.
+ *
+ * Rank 0 serves ping-pongs from each other rank in turn. Each rank uses
+ * the sample with the smallest round-trip time, assuming the latency is
+ * the same in each direction.
+ */
+void estimate_clock_offset(MPI_Comm comm) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  if (rank == 0) {
+    for (int peer = 1; peer < size; ++peer) {
+      for (int i = 0; i < num_clock_samples; ++i) {
+        MPI_Recv(nullptr, 0, MPI_BYTE, peer, 0, comm, MPI_STATUS_IGNORE);
+        const double now = get_time();
+        MPI_Send(&now, 1, MPI_DOUBLE, peer, 0, comm);
+      }
+    }
+    return;
+  }
+  double best_rtt = std::numeric_limits<double>::max();
+  for (int i = 0; i < num_clock_samples; ++i) {
+    const double send_time = get_time();
+    MPI_Send(nullptr, 0, MPI_BYTE, 0, 0, comm);
+    double root_time;
+    MPI_Recv(&root_time, 1, MPI_DOUBLE, 0, 0, comm, MPI_STATUS_IGNORE);
+    const double recv_time = get_time();
+    if (recv_time - send_time < best_rtt) {
+      best_rtt = recv_time - send_time;
+      clock_offset = root_time - (send_time + recv_time) / 2;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+bool skew_enabled() { return enabled; }
+
+void init(MPI_Comm world_comm) {
+  // Set AL_SKEW to a non-zero value to record collective arrivals.
+  const char* env = std::getenv("AL_SKEW");
+  if (env == nullptr || std::string(env) == "0") {
+    return;
+  }
+  enabled = true;
+  MPI_Comm_group(world_comm, &world_group);
+  MPI_Comm comm;
+  MPI_Comm_dup(world_comm, &comm);
+  estimate_clock_offset(comm);
+  MPI_Comm_free(&comm);
+}
+
+void finalize() {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (world_group != MPI_GROUP_NULL && !finalized) {
+    MPI_Group_free(&world_group);
+  }
+  world_group = MPI_GROUP_NULL;
+}
+
+ArrivalLog::ArrivalLog(MPI_Comm comm_) :
+  names(AL_SKEW_WINDOW), times(AL_SKEW_WINDOW),
+  pending_names(AL_SKEW_WINDOW), pending_times(AL_SKEW_WINDOW) {
+  MPI_Comm_dup(comm_, &comm);
+  int size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  std::vector<int> ranks(size);
+  std::iota(ranks.begin(), ranks.end(), 0);
+  world_ranks.resize(size);
+  MPI_Group group;
+  MPI_Comm_group(comm, &group);
+  MPI_Group_translate_ranks(group, size, ranks.data(),
+                            world_group, world_ranks.data());
+  MPI_Group_free(&group);
+  if (rank == 0) {
+    all_times.resize(size * AL_SKEW_WINDOW);
+  }
+}
+
+ArrivalLog::~ArrivalLog() {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    finish_exchange();
+    MPI_Comm_free(&comm);
+  }
+}
+
+void ArrivalLog::exchange() {
+  finish_exchange();
+  std::swap(names, pending_names);
+  std::swap(times, pending_times);
+  MPI_Igather(pending_times.data(), AL_SKEW_WINDOW, MPI_DOUBLE,
+              all_times.data(), AL_SKEW_WINDOW, MPI_DOUBLE, 0, comm, &req);
+}
+
+void ArrivalLog::finish_exchange() {
+  if (req == MPI_REQUEST_NULL) {
+    return;
+  }
+  MPI_Wait(&req, MPI_STATUS_IGNORE);
+  if (rank != 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(skew_mutex);
+  for (size_t i = 0; i < AL_SKEW_WINDOW; ++i) {
+    size_t first = 0;
+    size_t last = 0;
+    for (size_t r = 1; r < world_ranks.size(); ++r) {
+      if (all_times[r*AL_SKEW_WINDOW + i] < all_times[first*AL_SKEW_WINDOW + i]) {
+        first = r;
+      }
+      if (all_times[r*AL_SKEW_WINDOW + i] > all_times[last*AL_SKEW_WINDOW + i]) {
+        last = r;
+      }
+    }
+    const double first_time = all_times[first*AL_SKEW_WINDOW + i];
+    OpSkew& op = op_skew[pending_names[i]];
+    if (op.name == nullptr) {
+      op.name = pending_names[i];
+    }
+    ++op.num_ops;
+    op.skew_ns.add(to_ns(all_times[last*AL_SKEW_WINDOW + i] - first_time));
+    ++rank_lateness[world_ranks[last]].times_last;
+    for (size_t r = 0; r < world_ranks.size(); ++r) {
+      rank_lateness[world_ranks[r]].late_seconds +=
+        all_times[r*AL_SKEW_WINDOW + i] - first_time;
+    }
+  }
+}
+
+std::ostream& write_skew_stats(std::ostream& os) {
+  os << "# op num_ops skew_ns(mean p50 p99 max)\n";
+  for (const auto& s : GetSkewStats()) {
+    os << s.name << " " << s.num_ops
+       << " " << static_cast<uint64_t>(s.skew_ns.mean())
+       << " " << s.skew_ns.percentile(50)
+       << " " << s.skew_ns.percentile(99)
+       << " " << s.skew_ns.percentile(100) << "\n";
+  }
+  os << "# rank times_last late_seconds\n";
+  for (const auto& s : GetStragglerStats()) {
+    os << s.rank << " " << s.times_last << " " << s.late_seconds << "\n";
+  }
+  return os;
+}
+
+void write_skew_stats_to_file() {
+  if (!enabled) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(skew_mutex);
+    if (op_skew.empty()) {
+      return;
+    }
+  }
+  char hostname[HOST_NAME_MAX];
+  gethostname(hostname, HOST_NAME_MAX);
+  pid_t pid = getpid();
+  std::ofstream file(std::string(hostname) + "." + std::to_string(pid)
+                     + ".skew.txt");
+  write_skew_stats(file);
+}
+
+}  // namespace skew
+}  // namespace internal
+
+std::vector<SkewStats> GetSkewStats() {
+  std::lock_guard<std::mutex> lock(internal::skew::skew_mutex);
+  std::vector<SkewStats> stats;
+  stats.reserve(internal::skew::op_skew.size());
+  for (const auto& [name, op] : internal::skew::op_skew) {
+    stats.push_back({op.name, op.num_ops, op.skew_ns});
+  }
+  return stats;
+}
+
+std::vector<StragglerStats> GetStragglerStats() {
+  std::lock_guard<std::mutex> lock(internal::skew::skew_mutex);
+  std::vector<StragglerStats> stats;
+  stats.reserve(internal::skew::rank_lateness.size());
+  for (const auto& [rank, lateness] : internal::skew::rank_lateness) {
+    stats.push_back({rank, lateness.times_last, lateness.late_seconds});
+  }
+  std::stable_sort(stats.begin(), stats.end(),
+                   [](const StragglerStats& a, const StragglerStats& b) {
+                     return a.times_last > b.times_last;
+                   });
+  return stats;
+}
+
+std::ostream& WriteSkewStats(std::ostream& os) {
+  return internal::skew::write_skew_stats(os);
+}
+
+}  // namespace Al
@@ -0,0 +1,248 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "aluminum/stats.hpp"
+
+#include <unistd.h>
+#include <limits.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Al.hpp"
+#include "aluminum/mpi/pvars.hpp"
+
+namespace Al {
+
+uint64_t Histogram::percentile(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  const uint64_t target = std::max<uint64_t>(
+    1, static_cast<uint64_t>(std::ceil(p / 100.0 * count)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < num_buckets; ++i) {
+    seen += buckets[i];
+    if (seen >= target) {
+      return bucket_lower_bound(i);
+    }
+  }
+  return bucket_lower_bound(num_buckets - 1);
+}
+
+std::ostream& operator<<(std::ostream& os, const ProgressEngineStats& stats) {
+  os << "Progress engine stats over " << stats.elapsed << " s:\n"
+     << "  iterations " << stats.iterations
+     << " (" << stats.iterations_per_second << "/s), "
+     << stats.sampled_iterations << " sampled\n"
+     << "  idle fraction " << stats.idle_fraction << "\n"
+     << "  input scan " << stats.input_scan_seconds << " s ("
+     << stats.empty_input_scan_seconds << " s finding nothing)\n";
+  for (const auto& step : stats.steps) {
+    os << "  step " << step.name << ": " << step.seconds << " s over "
+       << step.sampled_steps << " sampled steps\n";
+  }
+  for (const auto& depth : stats.queue_depths) {
+    os << "  run queue stream " << depth.stream << " stage " << depth.stage
+       << ": mean depth " << depth.mean_depth
+       << " max depth " << depth.max_depth << "\n";
+  }
+  return os;
+}
+
+namespace internal {
+namespace stats {
+
+namespace {
+
+/** Histogram that can be updated while being read. */
+struct AtomicHistogram {
+  std::array<std::atomic<uint64_t>, Histogram::num_buckets> buckets = {};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> sum{0};
+
+  void add(uint64_t value) {
+    buckets[Histogram::bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+  }
+  void snapshot(Histogram& hist) const {
+    for (size_t i = 0; i < Histogram::num_buckets; ++i) {
+      hist.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    hist.count = count.load(std::memory_order_relaxed);
+    hist.sum = sum.load(std::memory_order_relaxed);
+  }
+  void reset() {
+    for (auto& b : buckets) {
+      b.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+  }
+};
+
+/** Statistics for one (operation, size class). */
+struct OpStatsSlot {
+  OpStatsSlot(const char* name_, size_t size_class_) :
+    name(name_), size_class(size_class_) {}
+
+  const char* name;
+  size_t size_class;
+  std::atomic<uint64_t> num_ops{0};
+  std::atomic<uint64_t> bytes{0};
+  AtomicHistogram queue_ns;
+  AtomicHistogram exec_ns;
+};
+
+struct SlotKeyHash {
+  size_t operator()(const std::pair<const char*, size_t>& key) const {
+    return std::hash<const char*>()(key.first) ^ (key.second << 1);
+  }
+};
+
+/**
+ * Slots indexed by operation name and size class.
+ *
+ * Names are pointers to static strings, so comparing pointers is
+ * sufficient. Only the recording (progress engine) thread uses this, so
+ * lookups need no locking.
+ */
+std::unordered_map<std::pair<const char*, size_t>, OpStatsSlot*, SlotKeyHash> slot_map;
+
+/** Protects all_slots. */
+std::mutex slots_mutex;
+/** All slots, for readers. */
+std::vector<std::unique_ptr<OpStatsSlot>> all_slots;
+
+OpStatsSlot* get_slot(const char* name, size_t size_class) {
+  auto key = std::make_pair(name, size_class);
+  auto iter = slot_map.find(key);
+  if (iter != slot_map.end()) {
+    return iter->second;
+  }
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  all_slots.push_back(std::make_unique<OpStatsSlot>(name, size_class));
+  slot_map[key] = all_slots.back().get();
+  return all_slots.back().get();
+}
+
+uint64_t to_ns(double t) {
+  return t > 0.0 ? static_cast<uint64_t>(t * 1e9) : 0;
+}
+
+}  // anonymous namespace
+
+void record_op(const char* name, size_t bytes,
+               double enqueue_time, double start_time, double end_time) {
+  OpStatsSlot* slot = get_slot(name, size_class(bytes));
+  slot->num_ops.fetch_add(1, std::memory_order_relaxed);
+  slot->bytes.fetch_add(bytes, std::memory_order_relaxed);
+  slot->queue_ns.add(to_ns(start_time - enqueue_time));
+  slot->exec_ns.add(to_ns(end_time - start_time));
+}
+
+std::ostream& write_op_stats(std::ostream& os, const std::vector<OpStats>& stats) {
+  os << "# op size_class(bytes) num_ops bytes"
+     << " queue_ns(mean p50 p99 max) exec_ns(mean p50 p99 max)\n";
+  for (const auto& s : stats) {
+    os << s.name << " ";
+    if (s.size_class == 0) {
+      os << "0";
+    } else {
+      os << "[" << (uint64_t{1} << (s.size_class - 1))
+         << "," << (uint64_t{1} << s.size_class) << ")";
+    }
+    os << " " << s.num_ops << " " << s.bytes;
+    for (const Histogram* hist : {&s.queue_ns, &s.exec_ns}) {
+      os << " " << static_cast<uint64_t>(hist->mean())
+         << " " << hist->percentile(50)
+         << " " << hist->percentile(99)
+         << " " << hist->percentile(100);
+    }
+    os << "\n";
+  }
+  return os;
+}
+
+void write_op_stats_to_file() {
+  const char* env = std::getenv("AL_OP_STATS");
+  if (env == nullptr || std::string(env) == "0") {
+    return;
+  }
+  char hostname[HOST_NAME_MAX];
+  gethostname(hostname, HOST_NAME_MAX);
+  pid_t pid = getpid();
+  std::ofstream file(std::string(hostname) + "." + std::to_string(pid)
+                     + ".opstats.txt");
+  write_op_stats(file, GetOpStats());
+  const auto pvar_stats = GetMPIPvarStats();
+  if (!pvar_stats.empty()) {
+    mpi::write_pvar_stats(file, pvar_stats);
+  }
+}
+
+}  // namespace stats
+}  // namespace internal
+
+std::vector<OpStats> GetOpStats() {
+  std::lock_guard<std::mutex> lock(internal::stats::slots_mutex);
+  std::vector<OpStats> stats(internal::stats::all_slots.size());
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const auto& slot = internal::stats::all_slots[i];
+    stats[i].name = slot->name;
+    stats[i].size_class = slot->size_class;
+    stats[i].num_ops = slot->num_ops.load(std::memory_order_relaxed);
+    stats[i].bytes = slot->bytes.load(std::memory_order_relaxed);
+    slot->queue_ns.snapshot(stats[i].queue_ns);
+    slot->exec_ns.snapshot(stats[i].exec_ns);
+  }
+  return stats;
+}
+
+void ResetOpStats() {
+  std::lock_guard<std::mutex> lock(internal::stats::slots_mutex);
+  for (auto& slot : internal::stats::all_slots) {
+    slot->num_ops.store(0, std::memory_order_relaxed);
+    slot->bytes.store(0, std::memory_order_relaxed);
+    slot->queue_ns.reset();
+    slot->exec_ns.reset();
+  }
+}
+
+std::ostream& WriteOpStats(std::ostream& os) {
+  return internal::stats::write_op_stats(os, GetOpStats());
+}
+
+}  // namespace Al
@@ -31,56 +31,183 @@
 #include <unistd.h>
 #include <limits.h>
 
+#include <algorithm>
 #include <fstream>
-#include <vector>
-#ifdef AL_THREAD_MULTIPLE
+#include <iomanip>
+#include <memory>
 #include <mutex>
-#endif
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "aluminum/state.hpp"
+#include "aluminum/mpi/communicator.hpp"
 
 namespace Al {
 namespace internal {
 namespace trace {
 
+thread_local TraceBuffer* thread_buffer = nullptr;
+
 namespace {
-#ifdef AL_THREAD_MULTIPLE
-std::mutex log_mutex;
+/** Protects trace_buffers (only when registering or writing). */
+std::mutex buffers_mutex;
+/** Trace buffers for every thread that has recorded an event. */
+std::vector<std::unique_ptr<TraceBuffer>> trace_buffers;
+
+#ifdef AL_TRACE
+void record_pe_event(const AlState& state, TraceEventKind kind,
+                     size_t stage = 0) {
+  TraceRecord record;
+  record.time = get_time();
+  record.name = state.get_name();
+  record.backend = nullptr;
+  record.type = nullptr;
+  record.comm = &state;
+  record.stream = reinterpret_cast<uintptr_t>(state.get_compute_stream());
+  record.count = stage;
+  record.rank = -1;
+  record.comm_size = -1;
+  record.peer = -1;
+  record.kind = kind;
+  save_trace_record(record);
+}
+
+/**
+ * Copy the records currently in every trace buffer, in time order.
+ *
+ * Also returns the number of records that were overwritten.
+ */
+std::vector<std::pair<size_t, TraceRecord>> gather_records(size_t& dropped) {
+  std::vector<std::pair<size_t, TraceRecord>> records;
+  dropped = 0;
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  for (const auto& buf : trace_buffers) {
+    const size_t head = buf->head.load(std::memory_order_acquire);
+    const size_t num = std::min(head, static_cast<size_t>(AL_TRACE_BUFFER_ENTRIES));
+    dropped += head - num;
+    for (size_t i = head - num; i < head; ++i) {
+      records.emplace_back(buf->thread_idx, buf->records[i & TraceBuffer::mask]);
+    }
+  }
+  std::stable_sort(records.begin(), records.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second.time < b.second.time;
+                   });
+  return records;
+}
+
+const char* pe_event_name(TraceEventKind kind) {
+  switch (kind) {
+  case TraceEventKind::pe_enqueue: return "ENQUEUE";
+  case TraceEventKind::pe_start: return "START";
+  case TraceEventKind::pe_advance: return "ADVANCE";
+  case TraceEventKind::pe_done: return "DONE";
+  default: return "UNKNOWN";
+  }
+}
+
+/** Lifetime of one operation on the progress engine. */
+struct PELifetime {
+  PELifetime(const TraceRecord& r) :
+    name(r.name), state(r.comm), stream(r.stream) {}
+
+  const char* name;
+  const void* state;
+  uintptr_t stream;
+  double enqueue_time = -1.0;
+  double start_time = -1.0;
+  double done_time = -1.0;
+  /** Times at which the operation entered each stage after the first. */
+  std::vector<double> advance_times;
+  /** Flow ID linking this to the user call, or 0 if none. */
+  size_t flow_id = 0;
+};
+
+/** Chrome trace timestamps are in microseconds. */
+double to_us(double t) { return t * 1e6; }
+
+/** Write the common fields of a Chrome trace event. */
+void write_event_header(std::ostream& os, const char* ph, const char* name,
+                        const char* cat, int pid, size_t tid, double ts) {
+  os << "{\"ph\":\"" << ph << "\",\"name\":\"" << name
+     << "\",\"cat\":\"" << cat << "\",\"pid\":" << pid
+     << ",\"tid\":" << tid << ",\"ts\":" << to_us(ts);
+}
+
+/** Write a metadata event naming a process or thread. */
+void write_name_event(std::ostream& os, const char* kind, int pid,
+                      size_t tid, const std::string& name) {
+  os << "{\"ph\":\"M\",\"name\":\"" << kind << "\",\"pid\":" << pid
+     << ",\"tid\":" << tid << ",\"args\":{\"name\":\"" << name
+     << "\"}},\n";
+}
+
+/** Write a complete (duration) event. */
+void write_slice(std::ostream& os, const char* name, const char* cat,
+                 int pid, size_t tid, double start, double end) {
+  write_event_header(os, "X", name, cat, pid, tid, start);
+  os << ",\"dur\":" << to_us(std::max(end - start, 0.0)) << "},\n";
+}
+#endif  // AL_TRACE
+}  // anonymous namespace
+
+TraceBuffer* register_thread_buffer() {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  trace_buffers.push_back(std::make_unique<TraceBuffer>(trace_buffers.size()));
+  thread_buffer = trace_buffers.back().get();
+  return thread_buffer;
+}
+
+void record_algorithm(const char* algo) {
+#ifdef AL_TRACE
+  TraceRecord record;
+  record.time = get_time();
+  record.name = algo;
+  record.backend = nullptr;
+  record.type = nullptr;
+  record.comm = nullptr;
+  record.stream = 0;
+  record.count = 0;
+  record.rank = -1;
+  record.comm_size = -1;
+  record.peer = -1;
+  record.kind = TraceEventKind::algo;
+  save_trace_record(record);
+#else
+  (void) algo;
 #endif
-std::vector<std::string> trace_log;
-std::vector<std::string> pe_trace_log;
 }
 
-void save_trace_entry(std::string entry, bool progress) {
-#ifdef AL_THREAD_MULTIPLE
-  std::lock_guard<std::mutex> lock(log_mutex);
+void record_pe_enqueue(const AlState& state) {
+#ifdef AL_TRACE
+  record_pe_event(state, TraceEventKind::pe_enqueue);
+#else
+  (void) state;
 #endif
-  if (progress) {
-    pe_trace_log.push_back(std::move(entry));
-  } else {
-    trace_log.push_back(std::move(entry));
-  }
 }
 
 void record_pe_start(const AlState& state) {
 #ifdef AL_TRACE
-  std::stringstream ss;
-  ss << get_time() << ": PE START "
-     << state.get_name() << " "
-     << state.get_desc();
-  save_trace_entry(ss.str(), true);
+  record_pe_event(state, TraceEventKind::pe_start);
+#else
+  (void) state;
+#endif
+}
+
+void record_pe_advance(const AlState& state, size_t stage) {
+#ifdef AL_TRACE
+  record_pe_event(state, TraceEventKind::pe_advance, stage);
 #else
   (void) state;
+  (void) stage;
 #endif
 }
 
 void record_pe_done(const AlState& state) {
 #ifdef AL_TRACE
-  std::stringstream ss;
-  ss << get_time() << ": PE DONE "
-     << state.get_name() << " "
-     << state.get_desc();
-  save_trace_entry(ss.str(), true);
+  record_pe_event(state, TraceEventKind::pe_done);
 #else
   (void) state;
 #endif
@@ -88,13 +215,222 @@ void record_pe_done(const AlState& state) {
 
 std::ostream& write_trace_log(std::ostream& os) {
 #ifdef AL_TRACE
-#ifdef AL_THREAD_MULTIPLE
-  std::lock_guard<std::mutex> lock(log_mutex);
-#endif
+  size_t dropped;
+  auto records = gather_records(dropped);
+  const auto old_flags = os.flags();
+  const auto old_precision = os.precision();
+  os << std::fixed << std::setprecision(9);
+  if (dropped) {
+    os << "Dropped " << dropped << " oldest trace records\n";
+  }
   os << "Trace:\n";
-  for (const auto& entry : trace_log) os << entry << "\n";
+  for (const auto& [thread_idx, r] : records) {
+    if (r.kind == TraceEventKind::algo) {
+      os << r.time << ": algorithm=" << r.name
+         << " thread=" << thread_idx << "\n";
+      continue;
+    }
+    if (r.kind != TraceEventKind::op) {
+      continue;
+    }
+    os << r.time << ": "
+       << r.backend << " "
+       << r.stream << " "
+       << r.type->name() << " "
+       << r.name << " "
+       << r.rank << " " << r.comm_size << " "
+       << "comm=" << r.comm << " "
+       << "count=" << r.count;
+    if (r.peer >= 0) {
+      os << " peer=" << r.peer;
+    }
+    os << " thread=" << thread_idx << "\n";
+  }
   os << "Progress engine trace:\n";
-  for (const auto& entry : pe_trace_log) os << entry << "\n";
+  for (const auto& [thread_idx, r] : records) {
+    if (r.kind == TraceEventKind::op || r.kind == TraceEventKind::algo) {
+      continue;
+    }
+    os << r.time << ": PE "
+       << pe_event_name(r.kind) << " "
+       << r.name << " "
+       << "state=" << r.comm << " "
+       << "stream=" << r.stream;
+    if (r.kind == TraceEventKind::pe_advance) {
+      os << " stage=" << r.count;
+    }
+    os << "\n";
+  }
+  os.flags(old_flags);
+  os.precision(old_precision);
+  return os;
+#else
+  return os;
+#endif
+}
+
+std::ostream& write_chrome_trace(std::ostream& os) {
+#ifdef AL_TRACE
+  size_t dropped;
+  auto records = gather_records(dropped);
+  const int pid = mpi::get_world_comm().rank();
+  const auto old_flags = os.flags();
+  const auto old_precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  // Tracks for compute streams are numbered after all thread tracks.
+  // Operations on the same stream may overlap (in different pipeline
+  // stages), so each stream gets as many lanes as it needs to keep
+  // slices properly nested.
+  constexpr size_t stream_tid_base = 1000;
+
+  // Match up progress engine events for each operation, and link each
+  // to the user call that enqueued it (the last call on that thread).
+  std::vector<PELifetime> lifetimes;
+  std::unordered_map<const void*, size_t> open_lifetimes;
+  std::unordered_map<size_t, size_t> last_call_on_thread;  // -> record index
+  std::unordered_map<size_t, size_t> call_flow_ids;  // record index -> flow
+  std::unordered_map<size_t, double> call_end_times;  // record index -> time
+  std::unordered_map<size_t, const char*> call_algos;  // record index -> algo
+  // Flow IDs are global in a merged trace, so prefix them with the rank.
+  size_t next_flow_id = (static_cast<size_t>(pid) << 32) + 1;
+  auto get_lifetime = [&](const TraceRecord& r) -> PELifetime& {
+    auto iter = open_lifetimes.find(r.comm);
+    if (iter == open_lifetimes.end()) {
+      // Started before the trace buffer wrapped; make a new lifetime.
+      lifetimes.emplace_back(r);
+      iter = open_lifetimes.emplace(r.comm, lifetimes.size() - 1).first;
+    }
+    return lifetimes[iter->second];
+  };
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto& [thread_idx, r] = records[i];
+    switch (r.kind) {
+    case TraceEventKind::op:
+      last_call_on_thread[thread_idx] = i;
+      break;
+    case TraceEventKind::algo: {
+      auto call_iter = last_call_on_thread.find(thread_idx);
+      if (call_iter != last_call_on_thread.end()) {
+        call_algos[call_iter->second] = r.name;
+      }
+      break;
+    }
+    case TraceEventKind::pe_enqueue: {
+      // States may be reused after they complete, so always start fresh.
+      lifetimes.emplace_back(r);
+      open_lifetimes[r.comm] = lifetimes.size() - 1;
+      PELifetime& lifetime = lifetimes.back();
+      lifetime.enqueue_time = r.time;
+      auto call_iter = last_call_on_thread.find(thread_idx);
+      if (call_iter != last_call_on_thread.end()) {
+        lifetime.flow_id = next_flow_id++;
+        call_flow_ids[call_iter->second] = lifetime.flow_id;
+        call_end_times[call_iter->second] = r.time;
+        last_call_on_thread.erase(call_iter);
+      }
+      break;
+    }
+    case TraceEventKind::pe_start:
+      get_lifetime(r).start_time = r.time;
+      break;
+    case TraceEventKind::pe_advance:
+      get_lifetime(r).advance_times.push_back(r.time);
+      break;
+    case TraceEventKind::pe_done:
+      get_lifetime(r).done_time = r.time;
+      open_lifetimes.erase(r.comm);
+      break;
+    }
+  }
+  const double trace_end = records.empty() ? 0.0 : records.back().second.time;
+
+  os << "{\"displayTimeUnit\":\"ns\",";
+  os << "\"otherData\":{\"rank\":" << pid << ",\"dropped\":" << dropped << "},";
+  os << "\"traceEvents\":[\n";
+  write_name_event(os, "process_name", pid, 0, "rank " + std::to_string(pid));
+  std::unordered_map<size_t, bool> named_threads;
+
+  // User calls.
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto& [thread_idx, r] = records[i];
+    if (r.kind != TraceEventKind::op) {
+      continue;
+    }
+    if (!named_threads.count(thread_idx)) {
+      write_name_event(os, "thread_name", pid, thread_idx,
+                       "thread " + std::to_string(thread_idx));
+      named_threads[thread_idx] = true;
+    }
+    auto end_iter = call_end_times.find(i);
+    const double end = (end_iter == call_end_times.end()) ? r.time : end_iter->second;
+    write_event_header(os, "X", r.name, "call", pid, thread_idx, r.time);
+    os << ",\"dur\":" << to_us(end - r.time)
+       << ",\"args\":{\"backend\":\"" << r.backend
+       << "\",\"type\":\"" << r.type->name()
+       << "\",\"count\":" << r.count
+       << ",\"peer\":" << r.peer
+       << ",\"rank\":" << r.rank
+       << ",\"comm_size\":" << r.comm_size
+       << ",\"comm\":\"" << r.comm
+       << "\",\"stream\":" << r.stream;
+    auto algo_iter = call_algos.find(i);
+    if (algo_iter != call_algos.end()) {
+      os << ",\"algorithm\":\"" << algo_iter->second << "\"";
+    }
+    os << "}},\n";
+    auto flow_iter = call_flow_ids.find(i);
+    if (flow_iter != call_flow_ids.end()) {
+      write_event_header(os, "s", "enqueue", "flow", pid, thread_idx, r.time);
+      os << ",\"id\":" << flow_iter->second << "},\n";
+    }
+  }
+
+  // Progress engine operations, packed into lanes per stream.
+  std::unordered_map<uintptr_t, std::vector<std::pair<size_t, double>>> stream_lanes;
+  size_t next_stream_tid = stream_tid_base;
+  for (const auto& lifetime : lifetimes) {
+    const double done = lifetime.done_time >= 0.0 ? lifetime.done_time : trace_end;
+    const double start = lifetime.start_time >= 0.0 ? lifetime.start_time : done;
+    const double begin = lifetime.enqueue_time >= 0.0 ? lifetime.enqueue_time : start;
+    auto& lanes = stream_lanes[lifetime.stream];
+    size_t tid = 0;
+    for (auto& [lane_tid, lane_end] : lanes) {
+      if (lane_end <= begin) {
+        tid = lane_tid;
+        lane_end = done;
+        break;
+      }
+    }
+    if (tid == 0) {
+      tid = next_stream_tid++;
+      lanes.emplace_back(tid, done);
+      std::ostringstream lane_name;
+      lane_name << "stream " << lifetime.stream << " lane " << lanes.size() - 1;
+      write_name_event(os, "thread_name", pid, tid, lane_name.str());
+    }
+    write_event_header(os, "X", lifetime.name, "op", pid, tid, begin);
+    os << ",\"dur\":" << to_us(done - begin)
+       << ",\"args\":{\"state\":\"" << lifetime.state << "\"}},\n";
+    if (lifetime.flow_id) {
+      write_event_header(os, "f", "enqueue", "flow", pid, tid, begin);
+      os << ",\"bp\":\"e\",\"id\":" << lifetime.flow_id << "},\n";
+    }
+    write_slice(os, "queued", "queue", pid, tid, begin, start);
+    double stage_start = start;
+    for (size_t stage = 0; stage <= lifetime.advance_times.size(); ++stage) {
+      const double stage_end = (stage < lifetime.advance_times.size())
+        ? lifetime.advance_times[stage] : done;
+      const std::string stage_name = "stage " + std::to_string(stage);
+      write_slice(os, stage_name.c_str(), "stage", pid, tid, stage_start, stage_end);
+      stage_start = stage_end;
+    }
+  }
+  // Close with a final metadata event so there is no trailing comma.
+  os << "{\"ph\":\"M\",\"name\":\"process_sort_index\",\"pid\":" << pid
+     << ",\"tid\":0,\"args\":{\"sort_index\":" << pid << "}}\n]}\n";
+  os.flags(old_flags);
+  os.precision(old_precision);
   return os;
 #else
   return os;
@@ -107,9 +443,11 @@ void write_trace_to_file() {
   gethostname(hostname, HOST_NAME_MAX);
   pid_t pid = getpid();
   std::string filename = std::string(hostname) + "." + std::to_string(pid)
-    + ".trace.txt";
-  std::ofstream trace_file(filename);
+    + ".trace";
+  std::ofstream trace_file(filename + ".txt");
   write_trace_log(trace_file);
+  std::ofstream chrome_trace_file(filename + ".json");
+  write_chrome_trace(chrome_trace_file);
 #endif
 }
 
@@ -80,6 +80,141 @@ struct AlgorithmOptions<Al::MPIBackend> {
     Al::MPIBackend::scatterv_algo_type::automatic;
 };
 
+// MPI allreduce supports passing through to MPI and its own algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::allreduce, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::allreduce, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::allreduce_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_recursive_doubling", algo_type::mpi_recursive_doubling},
+          {"mpi_rabenseifner", algo_type::mpi_rabenseifner},
+          {"mpi_ring", algo_type::mpi_ring},
+          {"mpi_biring", algo_type::mpi_biring},
+          {"mpi_hierarchical", algo_type::mpi_hierarchical},
+          {"mpi_shm", algo_type::mpi_shm}};
+}
+
+// MPI allgather(v) supports passing through to MPI and its own ring,
+// recursive doubling, and Bruck algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::allgather, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::allgather, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::allgather_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_ring", algo_type::mpi_ring},
+          {"mpi_recursive_doubling", algo_type::mpi_recursive_doubling},
+          {"mpi_bruck", algo_type::mpi_bruck}};
+}
+
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::allgatherv, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::allgatherv, Al::MPIBackend>() {
+  return get_supported_algos<Al::AlOperation::allgather, Al::MPIBackend>();
+}
+
+// MPI alltoall supports passing through to MPI and its own Bruck and
+// pairwise exchange algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::alltoall, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::alltoall, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::alltoall_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_bruck", algo_type::mpi_bruck},
+          {"mpi_pairwise", algo_type::mpi_pairwise}};
+}
+
+// MPI alltoallv supports passing through to MPI and its own sparse and
+// pairwise exchange algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::alltoallv, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::alltoallv, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::alltoallv_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_sparse", algo_type::mpi_sparse},
+          {"mpi_pairwise", algo_type::mpi_pairwise}};
+}
+
+// MPI barrier supports passing through to MPI and its own hierarchical
+// algorithm.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::barrier, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::barrier, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::barrier_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_hierarchical", algo_type::mpi_hierarchical}};
+}
+
+// MPI bcast supports passing through to MPI, shared memory, and its own
+// pipelined and scatter-allgather algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::bcast, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::bcast, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::bcast_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_shm", algo_type::mpi_shm},
+          {"mpi_pipelined_chain", algo_type::mpi_pipelined_chain},
+          {"mpi_binary_tree", algo_type::mpi_binary_tree},
+          {"mpi_scatter_allgather", algo_type::mpi_scatter_allgather}};
+}
+
+// MPI reduce-scatter(v) supports passing through to MPI and its own ring
+// and recursive halving algorithms.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::reduce_scatter, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::reduce_scatter, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::reduce_scatter_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_ring", algo_type::mpi_ring},
+          {"mpi_recursive_halving", algo_type::mpi_recursive_halving}};
+}
+
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::reduce_scatterv, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::reduce_scatterv, Al::MPIBackend>() {
+  return get_supported_algos<Al::AlOperation::reduce_scatter, Al::MPIBackend>();
+}
+
+// MPI reduce supports passing through to MPI and its own binomial and
+// k-nomial trees.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::reduce, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::reduce, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::reduce_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_binomial", algo_type::mpi_binomial},
+          {"mpi_knomial", algo_type::mpi_knomial}};
+}
+
+// MPI gather(v) and scatter(v) support passing through to MPI, their own
+// binomial and k-nomial trees, and flow control at the root.
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::gather, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::gather, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::gather_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_binomial", algo_type::mpi_binomial},
+          {"mpi_knomial", algo_type::mpi_knomial},
+          {"mpi_flow_controlled", algo_type::mpi_flow_controlled}};
+}
+
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::gatherv, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::gatherv, Al::MPIBackend>() {
+  return get_supported_algos<Al::AlOperation::gather, Al::MPIBackend>();
+}
+
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::scatter, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::scatter, Al::MPIBackend>() {
+  using algo_type = Al::MPIBackend::scatter_algo_type;
+  return {{"automatic", algo_type::automatic},
+          {"mpi_passthrough", algo_type::mpi_passthrough},
+          {"mpi_binomial", algo_type::mpi_binomial},
+          {"mpi_knomial", algo_type::mpi_knomial},
+          {"mpi_flow_controlled", algo_type::mpi_flow_controlled}};
+}
+
+template <>
+std::vector<std::pair<std::string, typename Al::OpAlgoType<Al::AlOperation::scatterv, Al::MPIBackend>::type>> get_supported_algos<Al::AlOperation::scatterv, Al::MPIBackend>() {
+  return get_supported_algos<Al::AlOperation::scatter, Al::MPIBackend>();
+}
+
 #ifdef AL_HAS_NCCL
 template <>
 struct AlgorithmOptions<Al::NCCLBackend> {
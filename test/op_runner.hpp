@@ -472,7 +472,7 @@ public:
       std::abort();
     }
     typename Backend::req_type& req = this->get_options().req;
-    auto algo = this->get_options().algos.allgather_algo;
+    auto algo = this->get_options().algos.barrier_algo;
     this->inplace_nb_dispatch(
       [&]() { Al::Barrier<Backend>(comm, algo); },
       [&]() {},
@@ -518,7 +518,7 @@ public:
     }
     int root = this->get_options().root;
     typename Backend::req_type& req = this->get_options().req;
-    auto algo = this->get_options().algos.allgather_algo;
+    auto algo = this->get_options().algos.bcast_algo;
     this->inplace_nb_dispatch(
       [&]() {},
       [&]() { Al::Bcast<Backend>(output.data(), output.size(), root, comm, algo); },
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Al.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cxxopts.hpp>
+#include "test_utils.hpp"
+
+
+/**
+ * Test the communication matrix.
+ *
+ * Each rank sends count floats to the next rank, then rank 0 reads back
+ * the matrix and checks each entry.
+ */
+int main(int argc, char** argv) {
+  // Must be set before initialization.
+  setenv("AL_COMM_MATRIX", "1", 1);
+  test_init_aluminum(argc, argv);
+
+  cxxopts::Options options("test_comm_matrix", "Test communication matrix");
+  options.add_options()
+    ("num-iters", "Number of sends to each peer", cxxopts::value<size_t>()->default_value("3"))
+    ("size", "Size of message to send", cxxopts::value<size_t>()->default_value("1024"))
+    ("file", "Matrix file to write", cxxopts::value<std::string>()->default_value("test_comm_matrix.txt"));
+  auto parsed_opts = options.parse(argc, argv);
+  const size_t num_iters = parsed_opts["num-iters"].as<size_t>();
+  const size_t size = parsed_opts["size"].as<size_t>();
+  const std::string filename = parsed_opts["file"].as<std::string>();
+
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  const int next = (comm.rank() + 1) % comm.size();
+  const int prev = (comm.rank() + comm.size() - 1) % comm.size();
+  std::vector<float> sendbuf(size, 1.0f), recvbuf(size);
+  for (size_t i = 0; i < num_iters; ++i) {
+    Al::SendRecv<Al::MPIBackend>(sendbuf.data(), size, next,
+                                 recvbuf.data(), size, prev, comm);
+  }
+  Al::WriteCommMatrix(filename);
+
+  if (comm.rank() == 0) {
+    std::ifstream file(filename);
+    std::string line;
+    std::vector<std::vector<uint64_t>> matrices;
+    while (std::getline(file, line)) {
+      if (line[0] == '#') {
+        matrices.emplace_back();
+        continue;
+      }
+      std::istringstream ss(line);
+      uint64_t v;
+      while (ss >> v) {
+        matrices.back().push_back(v);
+      }
+    }
+    // Skip the header comment.
+    if (matrices.size() != 3) {
+      std::cerr << "Bad communication matrix file" << std::endl;
+      std::abort();
+    }
+    const size_t n = comm.size();
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        const bool is_next = (j == (i + 1) % n);
+        const uint64_t expected_bytes = is_next ? num_iters*size*sizeof(float) : 0;
+        const uint64_t expected_msgs = is_next ? num_iters : 0;
+        if (matrices[1][i*n + j] != expected_bytes
+            || matrices[2][i*n + j] != expected_msgs) {
+          std::cerr << "Bad communication matrix entry " << i << ", " << j
+                    << ": " << matrices[1][i*n + j] << " bytes, "
+                    << matrices[2][i*n + j] << " messages" << std::endl;
+          std::abort();
+        }
+      }
+    }
+  }
+
+  test_fini_aluminum();
+  return 0;
+}
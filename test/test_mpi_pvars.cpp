@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Al.hpp"
+#include "aluminum/mpi/pvars.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cxxopts.hpp>
+#include "test_utils.hpp"
+
+
+/**
+ * Test sampling MPI_T performance variables.
+ *
+ * Variable names depend on the MPI library, so this only checks that
+ * any variables found were sampled and that unknown ones were skipped.
+ */
+int main(int argc, char** argv) {
+  cxxopts::Options options("test_mpi_pvars", "Test MPI_T performance variables");
+  options.add_options()
+    ("pvars", "Comma-separated performance variables to sample",
+     cxxopts::value<std::string>()->default_value(
+       "pml_ob1_unexpected_msgq_length,pml_ob1_posted_recvq_length,al_no_such_pvar"))
+    ("num-iters", "Number of allreduces to run", cxxopts::value<size_t>()->default_value("1000"));
+  auto parsed_opts = options.parse(argc, argv);
+  const std::string pvars = parsed_opts["pvars"].as<std::string>();
+  const size_t num_iters = parsed_opts["num-iters"].as<size_t>();
+
+  // Must be set before initialization.
+  setenv("AL_MPI_T_PVARS", pvars.c_str(), 1);
+  test_init_aluminum(argc, argv);
+
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  std::vector<float> buf(1024, 1.0f);
+  for (size_t i = 0; i < num_iters; ++i) {
+    Al::MPIBackend::req_type req;
+    Al::NonblockingAllreduce<Al::MPIBackend>(buf.data(), buf.size(),
+                                             Al::ReductionOperator::sum,
+                                             comm, req);
+    Al::Wait<Al::MPIBackend>(req);
+  }
+
+  const auto stats = Al::GetMPIPvarStats();
+  for (const auto& s : stats) {
+    if (s.name == "al_no_such_pvar") {
+      std::cerr << comm.rank() << ": sampled a nonexistent variable" << std::endl;
+      std::abort();
+    }
+    // There is always a sample at initialization and when getting stats.
+    if (s.num_samples < 2 || s.min > s.max) {
+      std::cerr << comm.rank() << ": bad samples for " << s.name << std::endl;
+      std::abort();
+    }
+  }
+  if (comm.rank() == 0) {
+    Al::internal::mpi::write_pvar_stats(std::cout, stats);
+  }
+
+  test_fini_aluminum();
+  return 0;
+}
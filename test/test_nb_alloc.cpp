@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Al.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <cxxopts.hpp>
+#include "test_utils.hpp"
+
+
+/**
+ * Check that the steady-state non-blocking path does not allocate on
+ * the progress engine thread.
+ *
+ * This replaces the global operator new with a version that counts
+ * allocations made by any thread other than the main thread. After a
+ * warmup (to populate run queues, caches, etc.), running non-blocking
+ * operations should not allocate there. In particular, profiling hooks
+ * must not build a name string for every operation.
+ */
+
+namespace {
+std::thread::id main_thread_id;
+std::atomic<bool> counting{false};
+std::atomic<size_t> num_other_thread_allocs{0};
+}  // anonymous namespace
+
+void* operator new(std::size_t size) {
+  if (counting.load(std::memory_order_relaxed)
+      && std::this_thread::get_id() != main_thread_id) {
+    num_other_thread_allocs.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (size == 0) {
+    size = 1;
+  }
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+/** Run non-blocking operations with (long and short) state names. */
+void run_ops(std::vector<float>& buf, Al::MPIBackend::comm_type& comm,
+             size_t num_iters) {
+  Al::MPIBackend::req_type req;
+  for (size_t i = 0; i < num_iters; ++i) {
+    Al::NonblockingAllreduce<Al::MPIBackend>(
+      buf.data(), buf.size(), Al::ReductionOperator::sum, comm, req);
+    Al::Wait<Al::MPIBackend>(req);
+    Al::NonblockingReduce_scatter<Al::MPIBackend>(
+      buf.data(), buf.size() / comm.size(), Al::ReductionOperator::sum,
+      comm, req);
+    Al::Wait<Al::MPIBackend>(req);
+  }
+}
+
+int main(int argc, char** argv) {
+  main_thread_id = std::this_thread::get_id();
+  test_init_aluminum(argc, argv);
+
+  cxxopts::Options options("test_nb_alloc",
+                           "Test for allocations on the progress engine");
+  options.add_options()
+    ("num-iters", "Number of iterations to count allocations over", cxxopts::value<size_t>()->default_value("100"))
+    ("num-warmup", "Number of warmup iterations", cxxopts::value<size_t>()->default_value("10"));
+  auto parsed_opts = options.parse(argc, argv);
+
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  std::vector<float> buf(16 * comm.size(), 1.0f);
+
+  run_ops(buf, comm, parsed_opts["num-warmup"].as<size_t>());
+  MPI_Barrier(MPI_COMM_WORLD);
+  counting = true;
+  run_ops(buf, comm, parsed_opts["num-iters"].as<size_t>());
+  counting = false;
+
+  const size_t allocs = num_other_thread_allocs.load();
+  if (allocs != 0) {
+    std::cerr << comm.rank() << ": " << allocs
+              << " allocations off the main thread in steady state"
+              << std::endl;
+    std::abort();
+  }
+
+  test_fini_aluminum();
+  return 0;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Al.hpp"
+#include <cstring>
+#include <iostream>
+#include <cxxopts.hpp>
+#include "test_utils.hpp"
+
+
+/** Check that histogram buckets cover values without gaps. */
+void check_histogram_buckets() {
+  uint64_t value = 0;
+  for (size_t i = 0; i < Al::Histogram::num_buckets; ++i) {
+    if (Al::Histogram::bucket_lower_bound(i) < value && i > 0) {
+      std::cerr << "Histogram bucket " << i << " is not increasing" << std::endl;
+      std::abort();
+    }
+    value = Al::Histogram::bucket_lower_bound(i);
+    if (Al::Histogram::bucket_index(value) != i) {
+      std::cerr << "Histogram value " << value << " is not in bucket "
+                << i << std::endl;
+      std::abort();
+    }
+  }
+  if (Al::Histogram::bucket_index(~uint64_t{0}) != Al::Histogram::num_buckets - 1) {
+    std::cerr << "Largest value is not in last histogram bucket" << std::endl;
+    std::abort();
+  }
+}
+
+/** Check that operation statistics count what was run. */
+void check_op_stats(size_t num_iters, size_t size) {
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  std::vector<float> buf(size, 1.0f);
+  Al::MPIBackend::req_type req;
+  Al::ResetOpStats();
+  for (size_t i = 0; i < num_iters; ++i) {
+    Al::NonblockingAllreduce<Al::MPIBackend>(
+      buf.data(), buf.size(), Al::ReductionOperator::sum, comm, req);
+    Al::Wait<Al::MPIBackend>(req);
+  }
+  const size_t bytes = size * sizeof(float);
+  bool found = false;
+  for (const auto& s : Al::GetOpStats()) {
+    if (std::strcmp(s.name, "MPIAllreduce") != 0 || s.num_ops == 0) {
+      continue;
+    }
+    found = true;
+    if (s.size_class != Al::internal::stats::size_class(bytes)
+        || s.num_ops != num_iters
+        || s.bytes != num_iters * bytes
+        || s.queue_ns.count != num_iters
+        || s.exec_ns.count != num_iters) {
+      std::cerr << comm.rank() << ": bad stats for MPIAllreduce:\n";
+      Al::WriteOpStats(std::cerr);
+      std::abort();
+    }
+  }
+  if (!found) {
+    std::cerr << comm.rank() << ": no stats for MPIAllreduce" << std::endl;
+    std::abort();
+  }
+}
+
+/** Check that progress engine statistics are being collected. */
+void check_progress_engine_stats() {
+  Al::ProgressEngineStats stats = Al::GetProgressEngineStats();
+  if (stats.iterations == 0
+      || stats.sampled_iterations == 0
+      || stats.sampled_iterations > stats.iterations
+      || stats.idle_fraction < 0.0 || stats.idle_fraction > 1.0) {
+    std::cerr << "Bad progress engine stats:\n" << stats;
+    std::abort();
+  }
+}
+
+int main(int argc, char** argv) {
+  test_init_aluminum(argc, argv);
+
+  cxxopts::Options options("test_op_stats", "Test operation statistics");
+  options.add_options()
+    ("num-iters", "Number of operations to run", cxxopts::value<size_t>()->default_value("10"))
+    ("size", "Size of allreduce to run", cxxopts::value<size_t>()->default_value("1024"));
+  auto parsed_opts = options.parse(argc, argv);
+
+  check_histogram_buckets();
+  check_op_stats(parsed_opts["num-iters"].as<size_t>(),
+                 parsed_opts["size"].as<size_t>());
+  check_progress_engine_stats();
+
+  test_fini_aluminum();
+  return 0;
+}
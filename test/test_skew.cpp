@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Lawrence Livermore National Security, LLC.  Produced at the
+// Lawrence Livermore National Laboratory in collaboration with University of
+// Illinois Urbana-Champaign.
+//
+// Written by the LBANN Research Team (N. Dryden, N. Maruyama, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-756777.
+// All rights reserved.
+//
+// This file is part of Aluminum GPU-aware Communication Library. For details, see
+// http://software.llnl.gov/Aluminum or https://github.com/LLNL/Aluminum.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Al.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cxxopts.hpp>
+#include "test_utils.hpp"
+
+
+/**
+ * Test skew and straggler detection.
+ *
+ * The last rank sleeps before each allreduce, so it should be reported
+ * as arriving last with roughly that much skew.
+ */
+int main(int argc, char** argv) {
+  // Must be set before initialization.
+  setenv("AL_SKEW", "1", 1);
+  test_init_aluminum(argc, argv);
+
+  cxxopts::Options options("test_skew", "Test skew detection");
+  options.add_options()
+    ("delay", "Microseconds the last rank is late", cxxopts::value<size_t>()->default_value("1000"));
+  auto parsed_opts = options.parse(argc, argv);
+  const size_t delay = parsed_opts["delay"].as<size_t>();
+
+  Al::MPIBackend::comm_type comm(MPI_COMM_WORLD);
+  std::vector<float> buf(16, 1.0f);
+  // Only complete windows of arrivals are reported, and only after the
+  // next window fills.
+  const size_t num_iters = 2*AL_SKEW_WINDOW;
+  for (size_t i = 0; i < num_iters; ++i) {
+    if (comm.rank() == comm.size() - 1) {
+      std::this_thread::sleep_for(std::chrono::microseconds(delay));
+    }
+    Al::Allreduce<Al::MPIBackend>(buf.data(), buf.size(),
+                                  Al::ReductionOperator::sum, comm);
+  }
+
+  const auto skew_stats = Al::GetSkewStats();
+  const auto straggler_stats = Al::GetStragglerStats();
+  if (comm.rank() != 0 || comm.size() == 1) {
+    // Only rank 0 of a communicator with peers has statistics.
+    if (!skew_stats.empty() || !straggler_stats.empty()) {
+      std::cerr << comm.rank() << ": unexpected skew stats" << std::endl;
+      std::abort();
+    }
+  } else {
+    if (skew_stats.size() != 1
+        || std::string(skew_stats[0].name) != "allreduce"
+        || skew_stats[0].num_ops != AL_SKEW_WINDOW) {
+      std::cerr << "Bad skew stats" << std::endl;
+      Al::WriteSkewStats(std::cerr);
+      std::abort();
+    }
+    // Allow for the sleep undershooting a bit and bucket rounding.
+    if (skew_stats[0].skew_ns.percentile(50) < delay*1000 / 2) {
+      std::cerr << "Skew too small" << std::endl;
+      Al::WriteSkewStats(std::cerr);
+      std::abort();
+    }
+    if (straggler_stats.empty()
+        || straggler_stats[0].rank != comm.size() - 1
+        || straggler_stats[0].times_last < AL_SKEW_WINDOW * 9 / 10) {
+      std::cerr << "Wrong straggler" << std::endl;
+      Al::WriteSkewStats(std::cerr);
+      std::abort();
+    }
+  }
+
+  test_fini_aluminum();
+  return 0;
+}
@@ -0,0 +1,40 @@
+"""Merge per-rank Aluminum Chrome traces into one file."""
+
+import argparse
+import json
+
+
+parser = argparse.ArgumentParser(
+    description='Merge per-rank Aluminum Chrome trace-event JSON files '
+    '(*.trace.json) into one, for viewing with chrome://tracing or Perfetto')
+parser.add_argument('traces', type=str, nargs='+',
+                    help='Trace files to merge')
+parser.add_argument('--output', type=str, default='merged.trace.json',
+                    help='Output file')
+parser.add_argument('--align', action='store_true',
+                    help='Shift each rank so its first event is at time 0 '
+                    '(use when ranks are on nodes with unsynchronized clocks)')
+
+
+if __name__ == '__main__':
+    args = parser.parse_args()
+    events = []
+    dropped = {}
+    for filename in args.traces:
+        with open(filename) as f:
+            trace = json.load(f)
+        rank_events = trace['traceEvents']
+        if args.align:
+            timed = [e['ts'] for e in rank_events if 'ts' in e]
+            if timed:
+                offset = min(timed)
+                for e in rank_events:
+                    if 'ts' in e:
+                        e['ts'] -= offset
+        events.extend(rank_events)
+        other = trace.get('otherData', {})
+        dropped[other.get('rank', filename)] = other.get('dropped', 0)
+    with open(args.output, 'w') as f:
+        json.dump({'displayTimeUnit': 'ns',
+                   'otherData': {'dropped': dropped},
+                   'traceEvents': events}, f)